@@ -35,6 +35,14 @@ Item {
         model: contactModel
         delegate: ContactDelegate {}
 
+        section.property: "section"
+        section.delegate: Text {
+            x: 4
+            text: section
+            font.bold: true
+            color: "gray"
+        }
+
         Rectangle {
             width: contactList.width - 1
             border {
@@ -24,7 +24,6 @@
 #include <QContactFavorite>
 #include <QContactGender>
 #include <QContactGlobalPresence>
-#include <QContactIdFilter>
 #include <QContactOnlineAccount>
 #include <QContactManager>
 #include <QContactName>
@@ -36,12 +35,13 @@
 #include <QContactUrl>
 #include <QDebug>
 #include <QDesktopServices>
+#include <algorithm>
 #include "contactmodel.h"
 //#include "_gen/contactmodel.moc.hpp"
 
 
-ContactModel::ContactModel(QObject *parent)
-: QAbstractListModel(parent)
+ContactModel::ContactModel(QObject *parent, Mode mode)
+: SortedContactModel(parent, mode)
 {
     // Contact manager
     QMap<QString, QString> params;
@@ -58,6 +58,7 @@ ContactModel::ContactModel(QObject *parent)
             this, SLOT(contactsChanged(const QList<QContactId>&, const QList<QContactDetail::DetailType>&)));
 
     // Model
+    m_roles = SortedContactModel::roleNames();
     m_roles[DisplayNameRole] = "displayName";
     m_roles[PresenceMessageRole] = "presenceMessage";
     m_roles[PresenceIconRole] = "presenceIcon";
@@ -73,16 +74,10 @@ QHash<int, QByteArray> ContactModel::roleNames() const
     return m_roles;
 }
 
-QVariant ContactModel::data(
-        const QModelIndex& index,
+QVariant ContactModel::roleData(
+        const QContact& contact,
         int role) const
 {
-    Q_ASSERT(index.isValid());
-
-    if(index.row() < 0 || index.row() > m_contacts.size())
-        return QVariant();
-
-    const QContact& contact = m_contacts[index.row()];
 
     switch(role) {
     case DisplayNameRole:
@@ -131,77 +126,87 @@ QVariant ContactModel::data(
     }
 }
 
-int ContactModel::rowCount(
-        const QModelIndex& parent) const
+QList<QContact> ContactModel::fetchContacts(
+        const QList<QContactId>& ids) const
 {
-    if(parent.isValid())
-        // This is not a tree, this should not happen
-        return 0;
+    return fetchContacts(ids, QContactFetchHint());
+}
 
-    return m_contacts.size();
+QList<QContact> ContactModel::fetchLabels(
+        const QList<QContactId>& ids) const
+{
+    QContactFetchHint hint;
+    hint.setDetailTypesHint(QList<QContactDetail::DetailType>()
+            << QContactDisplayLabel::Type);
+    hint.setOptimizationHints(QContactFetchHint::NoRelationships
+            | QContactFetchHint::NoActionPreferences
+            | QContactFetchHint::NoBinaryBlobs);
+    return fetchContacts(ids, hint);
 }
 
-QList<QContact> ContactModel::contactsFromIds(
-        const QList<QContactId>& ids)
+QList<QContact> ContactModel::fetchContacts(
+        const QList<QContactId>& ids,
+        const QContactFetchHint& hint) const
 {
-    QContactIdFilter idFilter;
-    idFilter.setIds(ids);
-    return m_manager->contacts(idFilter);
+    QList<QContact> contacts;
+    foreach(const QContact& contact, m_manager->contacts(ids, hint)) {
+        // Contacts removed in the meantime come back empty
+        if(!contact.id().isNull())
+            contacts << contact;
+    }
+    return contacts;
 }
 
-void ContactModel::contactsAdded(
-        const QList<QContactId>& ids)
+QVector<int> ContactModel::rolesForTypes(
+        const QList<QContactDetail::DetailType>& types)
 {
-        qWarning() << "contactsAdded";
+    QVector<int> roles;
+    foreach(QContactDetail::DetailType type, types) {
+        switch(type) {
+        case QContactDetail::TypeDisplayLabel:
+            roles << DisplayNameRole << SectionRole;
+            break;
+        case QContactDetail::TypeGlobalPresence:
+        case QContactDetail::TypePresence:
+            roles << PresenceMessageRole << PresenceIconRole;
+            break;
+        case QContactDetail::TypeAvatar:
+            roles << AvatarImageRole;
+            break;
+        default:
+            break;
+        }
+    }
 
-    QList<QContact> newContacts = contactsFromIds(ids);
-    if(newContacts.isEmpty())
-        return;
+    std::sort(roles.begin(), roles.end());
+    roles.erase(std::unique(roles.begin(), roles.end()), roles.end());
+    return roles;
+}
 
-    int first = m_contacts.size();
-    int last = first + newContacts.size() - 1;
-    beginInsertRows(QModelIndex(), first, last);
-    m_contacts += newContacts;
-    endInsertRows();
+void ContactModel::contactsAdded(
+        const QList<QContactId>& ids)
+{
+    insertContacts(fetchUpdates(ids));
 }
 
 void ContactModel::contactsRemoved(
         const QList<QContactId>& ids)
 {
-        qWarning() << "contactsRevmoed";
-    // FIXME: make this nicer and faster
-    foreach(const QContactId& contactId, ids) {
-        for(int i = m_contacts.size() - 1; i >= 0; i--) {
-            const QContact& contact = m_contacts[i];
-            if(contact.id() == contactId) {
-                beginRemoveRows(QModelIndex(), i, i);
-                m_contacts.removeAt(i);
-                endRemoveRows();
-                break;
-            }
-        }
-    }
+    removeContacts(ids);
 }
 
 void ContactModel::contactsChanged(
         const QList<QContactId>& ids,
-const QList<QContactDetail::DetailType>& types)
+        const QList<QContactDetail::DetailType>& types)
 {
-        qWarning() << "contactsChanged";
-    // FIXME: make this nicer and faster
-    QList<QContact> changedContacts = contactsFromIds(ids);
-    foreach(const QContact& newContact, changedContacts) {
-        for(int i = 0; i < m_contacts.size(); ++i) {
-            if(m_contacts[i].id() == newContact.id()) {
-                m_contacts[i] = newContact;
-                // FIXME: we could avoid emitting too many signals if the
-                // changed contacts are one after each other
-                QModelIndex changedIndex = index(i, 0);
-                emit dataChanged(changedIndex, changedIndex);
-                // This is for QML
-                emit rowChanged(i);
-            }
-        }
+    const QList<QContact> changedContacts = fetchUpdates(ids);
+    updateContacts(changedContacts, rolesForTypes(types));
+
+    // This is for QML
+    foreach(const QContact& contact, changedContacts) {
+        const int row = rowOf(contact.id());
+        if(row >= 0)
+            emit rowChanged(row);
     }
 }
 
@@ -230,10 +235,10 @@ QStringList ContactModel::detailsForContact(
     // support lists of custom objects :(
     QStringList details;
 
-    if(row < 0 || row > m_contacts.size())
+    if(row < 0 || row >= rowCount())
         return details;
 
-    const QContact& contact = m_contacts[row];
+    const QContact contact = this->contact(row);
 
     QString noLabel = QLatin1String("");
     QString noIcon = QLatin1String("");
@@ -378,10 +383,10 @@ bool ContactModel::setupIM(
 
     *pContactId = QLatin1String("");
 
-    if(row < 0 || row > m_contacts.size())
+    if(row < 0 || row >= rowCount())
         return false;
 
-    const QContact& contact = m_contacts[row];
+    const QContact contact = this->contact(row);
     QList<QContactOnlineAccount> accounts =
         contact.details<QContactOnlineAccount>();
 
@@ -17,15 +17,16 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
-#include <QAbstractListModel>
 #include <QContact>
+#include <QContactFetchHint>
+#include "sortedcontactmodel.h"
 
 #ifndef CONTACT_MODEL_H
 #define CONTACT_MODEL_H
 
 QTCONTACTS_USE_NAMESPACE
 
-class ContactModel : public QAbstractListModel
+class ContactModel : public SortedContactModel
 {
     Q_OBJECT
 
@@ -37,13 +38,11 @@ public:
         AvatarImageRole,
     };
 
-    ContactModel(QObject *parent = 0);
+    ContactModel(QObject *parent = 0, Mode mode = FullContacts);
     ~ContactModel();
 
     QContactManager& manager() { return *m_manager; }
 
-    QVariant data(const QModelIndex& index, int role=Qt::DisplayRole) const;
-    int rowCount(const QModelIndex& parent=QModelIndex()) const;
     QHash<int, QByteArray> roleNames() const;
 
     Q_INVOKABLE QStringList detailsForContact(int row);
@@ -54,12 +53,18 @@ public:
 Q_SIGNALS:
     void rowChanged(int row);
 
+protected:
+    QVariant roleData(const QContact& contact, int role) const;
+    QList<QContact> fetchContacts(const QList<QContactId>& ids) const;
+    QList<QContact> fetchLabels(const QList<QContactId>& ids) const;
+
 private:
     QContactManager *m_manager;
-    QList<QContact> m_contacts;
     QHash<int, QByteArray> m_roles;
 
-    QList<QContact> contactsFromIds(const QList<QContactId>& ids);
+    QList<QContact> fetchContacts(const QList<QContactId>& ids,
+            const QContactFetchHint& hint) const;
+    static QVector<int> rolesForTypes(const QList<QContactDetail::DetailType>& types);
 
     template<typename PresenceDetail>
     QString presenceIconForDetail(PresenceDetail& presence) const;
@@ -17,6 +17,7 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#include <QCoreApplication>
 #include <QQmlContext>
 #include "demowindow.h"
 #include "contactmodel.h"
@@ -25,7 +26,11 @@ DemoWindow::DemoWindow(QWindow *parent)
 : QQuickView(parent)
 {
     QQmlContext *context = rootContext();
-    m_model = new ContactModel(this);
+    // Only the rows in view hold their contact's details
+    const bool windowed =
+        QCoreApplication::arguments().contains(QLatin1String("--windowed"));
+    m_model = new ContactModel(this, windowed ? ContactModel::Windowed
+            : ContactModel::FullContacts);
     context->setContextProperty(QLatin1String("contactModel"), m_model);
 
     QString sourcePath = QLatin1String("contactlist.qml");
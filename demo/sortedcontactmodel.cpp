@@ -0,0 +1,499 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QContactDisplayLabel>
+#include <algorithm>
+#include "sortedcontactmodel.h"
+
+SortedContactModel::SortedContactModel(QObject *parent, Mode mode)
+: QAbstractListModel(parent)
+, m_mode(mode)
+, m_sectionsChanged(false)
+, m_cache(CacheSize)
+{
+    m_collator.setCaseSensitivity(Qt::CaseInsensitive);
+    m_collator.setNumericMode(true);
+}
+
+SortedContactModel::~SortedContactModel()
+{
+}
+
+QVariant SortedContactModel::data(
+        const QModelIndex& index,
+        int role) const
+{
+    if(index.row() < 0 || index.row() >= m_rows.size())
+        return QVariant();
+
+    const Row& row = m_rows.at(index.row());
+    if(role == SectionRole)
+        return row.section;
+    if(m_mode == FullContacts)
+        return roleData(row.contact, role);
+
+    if(const RoleValues *values = m_cache.object(row.id))
+        return values->value(role);
+
+    // Fetched once the view has asked for all rows it is about to show
+    if(m_pendingIds.isEmpty())
+        QMetaObject::invokeMethod(const_cast<SortedContactModel *>(this),
+                "fetchPending", Qt::QueuedConnection);
+    m_pendingIds.insert(row.id);
+
+    QContact placeholder;
+    QContactDisplayLabel label;
+    label.setLabel(row.label);
+    placeholder.saveDetail(&label);
+    return roleData(placeholder, role);
+}
+
+QVariant SortedContactModel::roleData(
+        const QContact& contact,
+        int role) const
+{
+    Q_UNUSED(contact);
+    Q_UNUSED(role);
+
+    return QVariant();
+}
+
+QList<QContact> SortedContactModel::fetchContacts(
+        const QList<QContactId>& ids) const
+{
+    Q_UNUSED(ids);
+
+    return QList<QContact>();
+}
+
+QList<QContact> SortedContactModel::fetchLabels(
+        const QList<QContactId>& ids) const
+{
+    return fetchContacts(ids);
+}
+
+QList<QContact> SortedContactModel::fetchUpdates(
+        const QList<QContactId>& ids) const
+{
+    if(m_mode == FullContacts)
+        return fetchContacts(ids);
+
+    QList<QContactId> cachedIds;
+    QList<QContactId> labelIds;
+    foreach(const QContactId& id, ids) {
+        if(m_cache.contains(id))
+            cachedIds << id;
+        else
+            labelIds << id;
+    }
+
+    QList<QContact> contacts;
+    if(!cachedIds.isEmpty())
+        contacts += fetchContacts(cachedIds);
+    if(!labelIds.isEmpty())
+        contacts += fetchLabels(labelIds);
+    return contacts;
+}
+
+QContact SortedContactModel::contact(
+        int row) const
+{
+    if(m_mode == FullContacts)
+        return m_rows.at(row).contact;
+
+    return fetchContacts(QList<QContactId>() << m_rows.at(row).id).value(0);
+}
+
+void SortedContactModel::fetchPending()
+{
+    const QSet<QContactId> pending = m_pendingIds;
+    m_pendingIds.clear();
+
+    // A page around every row asked for, the view is likely to scroll on
+    // to those next
+    QVector<int> rows;
+    foreach(const QContactId& id, pending) {
+        const int row = rowOf(id);
+        if(row < 0)
+            continue;
+
+        const int first = qMax(0, row - PageSize / 2);
+        const int last = qMin(m_rows.size() - 1, row + PageSize / 2);
+        for(int i = first; i <= last; ++i)
+            rows << i;
+    }
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    QList<QContactId> ids;
+    QVector<int> fetchedRows;
+    foreach(int row, rows) {
+        if(!m_cache.contains(m_rows.at(row).id)) {
+            ids << m_rows.at(row).id;
+            fetchedRows << row;
+        }
+    }
+    if(ids.isEmpty())
+        return;
+
+    foreach(const QContact& contact, fetchContacts(ids))
+        cacheRoleValues(contact);
+
+    // One dataChanged() per run of consecutive rows
+    for(int i = 0; i < fetchedRows.size();) {
+        int last = i;
+        while(last + 1 < fetchedRows.size() &&
+                fetchedRows.at(last + 1) == fetchedRows.at(last) + 1)
+            last++;
+        emit dataChanged(index(fetchedRows.at(i)), index(fetchedRows.at(last)));
+        i = last + 1;
+    }
+}
+
+void SortedContactModel::cacheRoleValues(
+        const QContact& contact)
+{
+    RoleValues *values = new RoleValues;
+    foreach(int role, roleNames().keys()) {
+        if(role != SectionRole)
+            values->insert(role, roleData(contact, role));
+    }
+    m_cache.insert(contact.id(), values);
+}
+
+int SortedContactModel::rowCount(
+        const QModelIndex& parent) const
+{
+    if(parent.isValid())
+        // This is not a tree, this should not happen
+        return 0;
+
+    return m_rows.size();
+}
+
+QHash<int, QByteArray> SortedContactModel::roleNames() const
+{
+    QHash<int, QByteArray> roles;
+    roles[SectionRole] = "section";
+    return roles;
+}
+
+QString SortedContactModel::sectionForLabel(
+        const QString& label)
+{
+    if(label.isEmpty() || !label.at(0).isLetter())
+        return QLatin1String("#");
+
+    return QString(label.at(0).toUpper());
+}
+
+QString SortedContactModel::sectionName(
+        int section) const
+{
+    if(section < 0 || section >= m_sections.size())
+        return QString();
+
+    return m_sections.at(section).name;
+}
+
+int SortedContactModel::sectionFirstRow(
+        int section) const
+{
+    if(section < 0 || section >= m_sections.size())
+        return -1;
+
+    return m_sections.at(section).first;
+}
+
+SortedContactModel::Row SortedContactModel::makeRow(
+        const QContact& contact) const
+{
+    // Copies of one empty contact share its data
+    static const QContact empty;
+
+    const QString label = contact.detail<QContactDisplayLabel>().label();
+    Row row = {
+        contact.id(),
+        m_collator.sortKey(label),
+        label,
+        sectionForLabel(label),
+        m_mode == FullContacts ? contact : empty
+    };
+    return row;
+}
+
+int SortedContactModel::lowerBound(
+        const QCollatorSortKey& key,
+        const QContactId& id) const
+{
+    // Contacts with the same label are ordered by id, so that every
+    // contact has exactly one row it belongs at
+    int low = 0;
+    int high = m_rows.size();
+    while(low < high) {
+        const int mid = (low + high) / 2;
+        const Row& row = m_rows.at(mid);
+        const int order = row.key.compare(key);
+        if(order < 0 || (order == 0 && row.id < id))
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+int SortedContactModel::rowOf(
+        const QContactId& id) const
+{
+    QHash<QContactId, QCollatorSortKey>::const_iterator it = m_keys.constFind(id);
+    if(it == m_keys.constEnd())
+        return -1;
+
+    const int row = lowerBound(it.value(), id);
+    if(row < m_rows.size() && m_rows.at(row).id == id)
+        return row;
+    return -1;
+}
+
+void SortedContactModel::insertContacts(
+        const QList<QContact>& contacts)
+{
+    // Each single insertion moves the rows after it, so a batch larger
+    // than the model (like the initial load) is sorted in one go instead
+    const bool reset = contacts.size() > m_rows.size();
+    QList<Row> rows = reset ? m_rows : QList<Row>();
+    QSet<QContactId> added;
+
+    QList<QContact> changed;
+    foreach(const QContact& contact, contacts) {
+        if(m_keys.contains(contact.id()))
+            changed << contact;
+        else if(reset && !added.contains(contact.id()))
+            rows << makeRow(contact);
+        else if(!reset)
+            insertRow(makeRow(contact));
+        added.insert(contact.id());
+    }
+
+    if(reset)
+        resetRows(rows);
+    if(!changed.isEmpty())
+        updateContacts(changed);
+    emitSectionsChanged();
+}
+
+void SortedContactModel::updateContacts(
+        const QList<QContact>& contacts,
+        const QVector<int>& roles)
+{
+    foreach(const QContact& contact, contacts) {
+        const int row = rowOf(contact.id());
+        if(row < 0)
+            continue;
+
+        if(m_mode == Windowed && m_cache.contains(contact.id()))
+            cacheRoleValues(contact);
+
+        const Row updated = makeRow(contact);
+        const bool sectionChanged = updated.section != m_rows.at(row).section;
+        QVector<int> changedRoles = roles;
+        if(sectionChanged && !roles.isEmpty())
+            changedRoles << SectionRole;
+
+        // The row it belongs at, counted with the old one still in place
+        const int destination = lowerBound(updated.key, contact.id());
+        m_keys.insert(contact.id(), updated.key);
+
+        if(destination == row || destination == row + 1) {
+            m_rows[row] = updated;
+            if(sectionChanged) {
+                sectionRemoved(row);
+                sectionInserted(row, updated.section);
+            }
+            emit dataChanged(index(row), index(row), changedRoles);
+            continue;
+        }
+
+        const int to = destination > row ? destination - 1 : destination;
+        beginMoveRows(QModelIndex(), row, row, QModelIndex(), destination);
+        m_rows.removeAt(row);
+        sectionRemoved(row);
+        m_rows.insert(to, updated);
+        sectionInserted(to, updated.section);
+        endMoveRows();
+        emit dataChanged(index(to), index(to), changedRoles);
+    }
+
+    emitSectionsChanged();
+}
+
+void SortedContactModel::removeContacts(
+        const QList<QContactId>& ids)
+{
+    foreach(const QContactId& id, ids) {
+        const int row = rowOf(id);
+        if(row >= 0)
+            removeRow(row);
+    }
+
+    emitSectionsChanged();
+}
+
+void SortedContactModel::insertRow(
+        const Row& row)
+{
+    const int at = lowerBound(row.key, row.id);
+    beginInsertRows(QModelIndex(), at, at);
+    m_rows.insert(at, row);
+    m_keys.insert(row.id, row.key);
+    sectionInserted(at, row.section);
+    endInsertRows();
+}
+
+void SortedContactModel::removeRow(
+        int row)
+{
+    beginRemoveRows(QModelIndex(), row, row);
+    m_keys.remove(m_rows.at(row).id);
+    m_cache.remove(m_rows.at(row).id);
+    m_rows.removeAt(row);
+    sectionRemoved(row);
+    endRemoveRows();
+}
+
+void SortedContactModel::resetRows(
+        const QList<Row>& rows)
+{
+    beginResetModel();
+
+    m_rows = rows;
+    std::sort(m_rows.begin(), m_rows.end(), [](const Row& a, const Row& b) {
+        const int order = a.key.compare(b.key);
+        return order < 0 || (order == 0 && a.id < b.id);
+    });
+
+    m_keys.clear();
+    m_keys.reserve(m_rows.size());
+    foreach(const Row& row, m_rows)
+        m_keys.insert(row.id, row.key);
+    rebuildSections();
+
+    endResetModel();
+    emitSectionsChanged();
+}
+
+int SortedContactModel::sectionAt(
+        int row) const
+{
+    // The last run starting at or before row
+    int low = 0;
+    int high = m_sections.size();
+    while(low < high) {
+        const int mid = (low + high) / 2;
+        if(m_sections.at(mid).first <= row)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low - 1;
+}
+
+void SortedContactModel::shiftSections(
+        int from,
+        int delta)
+{
+    for(int i = from; i < m_sections.size(); ++i)
+        m_sections[i].first += delta;
+}
+
+void SortedContactModel::sectionInserted(
+        int row,
+        const QString& name)
+{
+    // The runs of the rows before and after the new one; m_sections still
+    // has the rows as they were before the insertion
+    const int before = row > 0 ? sectionAt(row - 1) : -1;
+    const int after = row < m_rows.size() - 1 ? sectionAt(row) : -1;
+
+    if(before >= 0 && m_sections.at(before).name == name) {
+        m_sections[before].count++;
+        shiftSections(before + 1, 1);
+    } else if(after >= 0 && m_sections.at(after).name == name) {
+        // Now starts that run, which keeps its first row
+        m_sections[after].count++;
+        shiftSections(after + 1, 1);
+    } else if(before >= 0 && before == after) {
+        // Splits a run of another section in two
+        SectionRun& run = m_sections[before];
+        const SectionRun added = { name, row, 1 };
+        const SectionRun tail = { run.name, row + 1, run.first + run.count - row };
+        run.count = row - run.first;
+        shiftSections(before + 1, 1);
+        m_sections.insert(before + 1, tail);
+        m_sections.insert(before + 1, added);
+        m_sectionsChanged = true;
+    } else {
+        const SectionRun added = { name, row, 1 };
+        shiftSections(before + 1, 1);
+        m_sections.insert(before + 1, added);
+        m_sectionsChanged = true;
+    }
+}
+
+void SortedContactModel::sectionRemoved(
+        int row)
+{
+    const int section = sectionAt(row);
+    m_sections[section].count--;
+    shiftSections(section + 1, -1);
+    if(m_sections.at(section).count > 0)
+        return;
+
+    // The runs on either side may now be the same section
+    m_sections.remove(section);
+    if(section > 0 && section < m_sections.size() &&
+            m_sections.at(section - 1).name == m_sections.at(section).name) {
+        m_sections[section - 1].count += m_sections.at(section).count;
+        m_sections.remove(section);
+    }
+    m_sectionsChanged = true;
+}
+
+void SortedContactModel::rebuildSections()
+{
+    m_sections.clear();
+    for(int row = 0; row < m_rows.size(); ++row) {
+        const QString& name = m_rows.at(row).section;
+        if(!m_sections.isEmpty() && m_sections.last().name == name) {
+            m_sections.last().count++;
+        } else {
+            const SectionRun run = { name, row, 1 };
+            m_sections << run;
+        }
+    }
+    m_sectionsChanged = true;
+}
+
+void SortedContactModel::emitSectionsChanged()
+{
+    if(!m_sectionsChanged)
+        return;
+
+    m_sectionsChanged = false;
+    emit sectionsChanged();
+}
@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QAbstractListModel>
+#include <QCache>
+#include <QCollator>
+#include <QCollatorSortKey>
+#include <QContact>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QVector>
+
+#ifndef SORTED_CONTACT_MODEL_H
+#define SORTED_CONTACT_MODEL_H
+
+QTCONTACTS_USE_NAMESPACE
+
+// A list model keeping its contacts sorted by display label.
+//
+// Contacts are inserted, moved and removed one row at a time at the row a
+// binary search finds, instead of re-sorting everything on each change as
+// a QSortFilterProxyModel would. The runs of rows with the same section
+// (the first letter of the label) are maintained along with them, so a
+// view can show section headers and a fast-scroll index without scanning
+// the model.
+//
+// In Windowed mode rows only hold the id, label and sort key of their
+// contact. The values of the other roles are computed for the rows the
+// view asks for, and for a page of rows around them, from contacts
+// fetched in one batch. They are kept in a cache of the CacheSize most
+// recently used rows, so no row holds on to its whole contact. Until its
+// page arrives, a row shows what its label alone gives.
+//
+// Subclasses provide the roles after SectionRole with roleData(), feed the
+// contacts in with insertContacts(), updateContacts() and removeContacts(),
+// and for Windowed mode fetch them with fetchContacts() and fetchLabels().
+class SortedContactModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        SectionRole = Qt::UserRole
+    };
+
+    enum Mode {
+        FullContacts,
+        Windowed
+    };
+
+    enum {
+        PageSize = 64,
+        CacheSize = 1024
+    };
+
+    SortedContactModel(QObject *parent = 0, Mode mode = FullContacts);
+    ~SortedContactModel();
+
+    Mode mode() const { return m_mode; }
+
+    QVariant data(const QModelIndex& index, int role=Qt::DisplayRole) const;
+    int rowCount(const QModelIndex& parent=QModelIndex()) const;
+    QHash<int, QByteArray> roleNames() const;
+
+    // In Windowed mode this fetches the contact
+    QContact contact(int row) const;
+    // -1 if the contact isn't in the model
+    int rowOf(const QContactId& id) const;
+
+    // Adds contacts at their sorted rows. Contacts already in the model
+    // are updated instead.
+    void insertContacts(const QList<QContact>& contacts);
+    // Replaces contacts already in the model, moving those whose label
+    // changed to their new row. roles are passed on to dataChanged().
+    void updateContacts(const QList<QContact>& contacts,
+            const QVector<int>& roles = QVector<int>());
+    void removeContacts(const QList<QContactId>& ids);
+
+    // The runs of consecutive rows in the same section, in row order
+    Q_INVOKABLE int sectionCount() const { return m_sections.size(); }
+    Q_INVOKABLE QString sectionName(int section) const;
+    Q_INVOKABLE int sectionFirstRow(int section) const;
+
+    static QString sectionForLabel(const QString& label);
+
+    // The rows whose role values are cached, in Windowed mode
+    int cachedRows() const { return m_cache.size(); }
+
+Q_SIGNALS:
+    // A section run was added or removed, not only moved
+    void sectionsChanged();
+
+protected:
+    virtual QVariant roleData(const QContact& contact, int role) const;
+    // The contacts with ids, skipping those which don't exist anymore
+    virtual QList<QContact> fetchContacts(const QList<QContactId>& ids) const;
+    // fetchContacts() for contacts only needing their display label
+    virtual QList<QContact> fetchLabels(const QList<QContactId>& ids) const;
+    // The added or changed contacts with ids for insertContacts() and
+    // updateContacts(). In Windowed mode only cached rows get their whole
+    // contact, the others just need their label to find their row.
+    QList<QContact> fetchUpdates(const QList<QContactId>& ids) const;
+
+private slots:
+    void fetchPending();
+
+private:
+    typedef QHash<int, QVariant> RoleValues;
+
+    struct Row
+    {
+        QContactId id;
+        QCollatorSortKey key;
+        QString label;
+        QString section;
+        // Empty in Windowed mode
+        QContact contact;
+    };
+
+    struct SectionRun
+    {
+        QString name;
+        int first;
+        int count;
+    };
+
+    Mode m_mode;
+    QCollator m_collator;
+    QList<Row> m_rows;
+    // The sort key of every contact, to find its row by binary search
+    QHash<QContactId, QCollatorSortKey> m_keys;
+    QVector<SectionRun> m_sections;
+    bool m_sectionsChanged;
+    mutable QCache<QContactId, RoleValues> m_cache;
+    // Rows asked for which aren't cached, fetched with the next fetchPending()
+    mutable QSet<QContactId> m_pendingIds;
+
+    Row makeRow(const QContact& contact) const;
+    void cacheRoleValues(const QContact& contact);
+    // The row a contact with this key and id has, or would be inserted at
+    int lowerBound(const QCollatorSortKey& key, const QContactId& id) const;
+
+    void insertRow(const Row& row);
+    void removeRow(int row);
+    void resetRows(const QList<Row>& rows);
+
+    int sectionAt(int row) const;
+    void shiftSections(int from, int delta);
+    // Call with the row already inserted into or removed from m_rows
+    void sectionInserted(int row, const QString& name);
+    void sectionRemoved(int row);
+    void rebuildSections();
+    void emitSectionsChanged();
+};
+
+#endif // SORTED_CONTACT_MODEL_H
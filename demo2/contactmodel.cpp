@@ -35,6 +35,8 @@
 #include <QContactDisplayLabel>
 #include <QContactUrl>
 #include <QDebug>
+#include <QSet>
+#include <algorithm>
 #include "contactmodel.h"
 //#include "_gen/contactmodel.moc.hpp"
 
@@ -74,7 +76,7 @@ QVariant ContactModel::data(
 {
     Q_ASSERT(index.isValid());
 
-    if(index.row() < 0 || index.row() > m_contacts.size())
+    if(index.row() < 0 || index.row() >= m_contacts.size())
         return QVariant();
 
     const QContact& contact = m_contacts[index.row()];
@@ -139,17 +141,97 @@ int ContactModel::rowCount(
 QList<QContact> ContactModel::contactsFromIds(
         const QList<QContactId>& ids)
 {
-    QContactIdFilter idFilter;
-    idFilter.setIds(ids);
-    return m_manager->contacts(idFilter);
+    if(ids.isEmpty())
+        return QList<QContact>();
+
+    // Looked up by id, a QContactIdFilter would be tested against every
+    // contact of the engine
+    QList<QContact> contacts;
+    foreach(const QContact& contact, m_manager->contacts(ids)) {
+        // Contacts removed in the meantime come back empty
+        if(!contact.id().isNull())
+            contacts << contact;
+    }
+    return contacts;
+}
+
+QVector<int> ContactModel::rowsForIds(
+        const QList<QContactId>& ids) const
+{
+    QVector<int> rows;
+    rows.reserve(ids.size());
+    foreach(const QContactId& id, ids) {
+        const int row = m_rows.value(id, -1);
+        if(row >= 0)
+            rows << row;
+    }
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    return rows;
+}
+
+void ContactModel::reindexFrom(
+        int row)
+{
+    for(int i = row; i < m_contacts.size(); ++i)
+        m_rows[m_contacts.at(i).id()] = i;
+}
+
+QVector<ContactModel::RowRange> ContactModel::rowRanges(
+        const QVector<int>& rows)
+{
+    QVector<RowRange> ranges;
+    foreach(int row, rows) {
+        if(!ranges.isEmpty() && ranges.last().second + 1 == row)
+            ranges.last().second = row;
+        else
+            ranges << RowRange(row, row);
+    }
+    return ranges;
+}
+
+QVector<int> ContactModel::rolesForTypes(
+        const QList<QContactDetail::DetailType>& types)
+{
+    QVector<int> roles;
+    foreach(QContactDetail::DetailType type, types) {
+        switch(type) {
+        case QContactDetail::TypeDisplayLabel:
+            roles << DisplayNameRole;
+            break;
+        case QContactDetail::TypeGlobalPresence:
+        case QContactDetail::TypePresence:
+            roles << PresenceMessageRole << PresenceIconRole;
+            break;
+        case QContactDetail::TypeAvatar:
+            roles << AvatarImageRole;
+            break;
+        default:
+            break;
+        }
+    }
+
+    std::sort(roles.begin(), roles.end());
+    roles.erase(std::unique(roles.begin(), roles.end()), roles.end());
+    return roles;
 }
 
 void ContactModel::contactsAdded(
         const QList<QContactId>& ids)
 {
-        qWarning() << "contactsAdded";
+    // Contacts we already have, e.g. after the engine resynchronized, are
+    // not added twice
+    QList<QContactId> newIds;
+    QSet<QContactId> seen;
+    foreach(const QContactId& id, ids) {
+        if(!m_rows.contains(id) && !seen.contains(id)) {
+            newIds << id;
+            seen.insert(id);
+        }
+    }
 
-    QList<QContact> newContacts = contactsFromIds(ids);
+    QList<QContact> newContacts = contactsFromIds(newIds);
     if(newContacts.isEmpty())
         return;
 
@@ -157,48 +239,58 @@ void ContactModel::contactsAdded(
     int last = first + newContacts.size() - 1;
     beginInsertRows(QModelIndex(), first, last);
     m_contacts += newContacts;
+    reindexFrom(first);
     endInsertRows();
-
-detailsForContact(0);
 }
 
 void ContactModel::contactsRemoved(
         const QList<QContactId>& ids)
 {
-        qWarning() << "contactsRevmoed";
-    // FIXME: make this nicer and faster
-    foreach(const QContactId& contactId, ids) {
-        for(int i = m_contacts.size() - 1; i >= 0; i--) {
-            const QContact& contact = m_contacts[i];
-            if(contact.id() == contactId) {
-                beginRemoveRows(QModelIndex(), i, i);
-                m_contacts.removeAt(i);
-                endRemoveRows();
-                break;
-            }
-        }
+    const QVector<int> rows = rowsForIds(ids);
+    if(rows.isEmpty())
+        return;
+
+    // Last range first, so that the rows of the ones before stay valid
+    const QVector<RowRange> ranges = rowRanges(rows);
+    for(int i = ranges.size() - 1; i >= 0; --i) {
+        const RowRange& range = ranges.at(i);
+        beginRemoveRows(QModelIndex(), range.first, range.second);
+        for(int row = range.first; row <= range.second; ++row)
+            m_rows.remove(m_contacts.at(row).id());
+        m_contacts.erase(m_contacts.begin() + range.first,
+                m_contacts.begin() + range.second + 1);
+        endRemoveRows();
     }
+
+    reindexFrom(rows.first());
 }
 
 void ContactModel::contactsChanged(
         const QList<QContactId>& ids,
-const QList<QContactDetail::DetailType>& types)
+        const QList<QContactDetail::DetailType>& types)
 {
-        qWarning() << "contactsChanged";
-    // FIXME: make this nicer and faster
-    QList<QContact> changedContacts = contactsFromIds(ids);
-    foreach(const QContact& newContact, changedContacts) {
-        for(int i = 0; i < m_contacts.size(); ++i) {
-            if(m_contacts[i].id() == newContact.id()) {
-                m_contacts[i] = newContact;
-                // FIXME: we could avoid emitting too many signals if the
-                // changed contacts are one after each other
-                QModelIndex changedIndex = index(i, 0);
-                emit dataChanged(changedIndex, changedIndex);
-                // This is for QML
-                emit rowChanged(i);
-            }
-        }
+    const QVector<int> rows = rowsForIds(ids);
+    if(rows.isEmpty())
+        return;
+
+    QList<QContactId> changedIds;
+    changedIds.reserve(rows.size());
+    foreach(int row, rows)
+        changedIds << m_contacts.at(row).id();
+
+    foreach(const QContact& contact, contactsFromIds(changedIds))
+        m_contacts[m_rows.value(contact.id())] = contact;
+
+    // No types means anything could have changed. Changes to details no
+    // role shows, like phone numbers, don't need the views to repaint.
+    const QVector<int> roles = rolesForTypes(types);
+    const bool repaint = types.isEmpty() || !roles.isEmpty();
+
+    foreach(const RowRange& range, rowRanges(rows)) {
+        if(repaint)
+            emit dataChanged(index(range.first), index(range.second), roles);
+        // This is for QML
+        emit rowsChanged(range.first, range.second);
     }
 }
 
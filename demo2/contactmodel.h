@@ -19,6 +19,9 @@
 
 #include <QAbstractListModel>
 #include <QContact>
+#include <QHash>
+#include <QPair>
+#include <QVector>
 
 #ifndef CONTACT_MODEL_H
 #define CONTACT_MODEL_H
@@ -48,14 +51,25 @@ public:
     Q_INVOKABLE QStringList detailsForContact(int row);
 
 Q_SIGNALS:
-    void rowChanged(int row);
+    // Once per contiguous range of changed rows
+    void rowsChanged(int first, int last);
 
 private:
+    typedef QPair<int, int> RowRange;
+
     QContactManager *m_manager;
     QList<QContact> m_contacts;
+    // Row of every contact in m_contacts
+    QHash<QContactId, int> m_rows;
     QHash<int, QByteArray> m_roles;
 
     QList<QContact> contactsFromIds(const QList<QContactId>& ids);
+    QVector<int> rowsForIds(const QList<QContactId>& ids) const;
+    void reindexFrom(int row);
+
+    // Groups sorted rows into ranges of consecutive rows
+    static QVector<RowRange> rowRanges(const QVector<int>& rows);
+    static QVector<int> rolesForTypes(const QList<QContactDetail::DetailType>& types);
 
     template<typename PresenceDetail>
     QString presenceIconForDetail(PresenceDetail& presence) const;
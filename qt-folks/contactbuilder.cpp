@@ -0,0 +1,549 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <algorithm>
+#include <QUrl>
+#include <QContactAddress>
+#include <QContactAvatar>
+#include <QContactBirthday>
+#include <QContactDisplayLabel>
+#include <QContactEmailAddress>
+#include <QContactFavorite>
+#include <QContactGlobalPresence>
+#include <QContactName>
+#include <QContactNickname>
+#include <QContactNote>
+#include <QContactOnlineAccount>
+#include <QContactOrganization>
+#include <QContactPhoneNumber>
+#include <QContactType>
+#include <QContactUrl>
+#include "contactbuilder.h"
+#include "internpool.h"
+#include "utf8.h"
+#include "utils.h"
+
+namespace Folks
+{
+
+QByteArray dbIdToByteArray(quint32 dbId, bool isCollection)
+{
+    return isCollection ? (QByteArrayLiteral("col-") + QByteArray::number(dbId))
+                        : (QByteArrayLiteral("sql-") + QByteArray::number(dbId));
+}
+
+QList<int> ContactBuilder::valueSet(
+        QList<int> values)
+{
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+
+    return InternPool::intList(values);
+}
+
+QList<int> ContactBuilder::contexts(const QList<QByteArray> &types)
+{
+    QList<int> values;
+    Utils::contextsFromStrings(types, &values);
+
+    return valueSet(values);
+}
+
+QContactId ContactBuilder::contactId(
+        const QString &managerUri,
+        const QByteArray &folksId)
+{
+    return QContactId(managerUri,
+            dbIdToByteArray(qHash(QString::fromUtf8(folksId))));
+}
+
+QContactCollectionId ContactBuilder::aggregateCollectionId(
+        const QString &managerUri)
+{
+  /* alien tooling needs contacts to be in this collection and of this type because
+   * 1) it applies a filter for these two things when it calls contacts() and
+   * 2) it won't pick up any changes to contacts signalled via dbus otherwise
+   */
+    return InternPool::collectionId(
+            QContactCollectionId(managerUri, dbIdToByteArray(1, true)));
+}
+
+QContactCollection ContactBuilder::aggregateCollection(
+        const QString &managerUri)
+{
+    QContactCollection collection;
+    collection.setId(aggregateCollectionId(managerUri));
+    collection.setMetaData(QContactCollection::KeyName,
+            QStringLiteral("aggregate"));
+    collection.setMetaData(QContactCollection::KeyDescription,
+            QStringLiteral("Aggregated contacts of all persona stores"));
+
+    return collection;
+}
+
+QContactCollection ContactBuilder::storeCollection(
+        const QString &managerUri,
+        const PersonaStoreData &store)
+{
+    // There are only a handful of stores, but their strings are converted
+    // for every contact
+    const QString typeId = Utf8::cached(store.typeId);
+    const QString id = Utf8::cached(store.id);
+
+    // Store ids are only unique per backend
+    const QString uid = typeId + QLatin1Char(':') + id;
+
+    QContactCollection collection;
+    collection.setId(QContactCollectionId(managerUri,
+                dbIdToByteArray(qHash(uid), true)));
+    collection.setMetaData(QContactCollection::KeyName,
+            Utf8::cached(store.displayName));
+    collection.setExtendedMetaData(QStringLiteral("TypeId"), typeId);
+    collection.setExtendedMetaData(QStringLiteral("StoreId"), id);
+
+    return collection;
+}
+
+QList<QContactCollection> ContactBuilder::storeCollections(
+        const QString &managerUri,
+        const QList<PersonaStoreData> &stores)
+{
+    QList<QContactCollection> collections;
+    foreach(const PersonaStoreData &store, stores)
+        collections << storeCollection(managerUri, store);
+
+    return collections;
+}
+
+QString ContactBuilder::sortKey(const QContact &contact)
+{
+    return contact.detail<QContactDisplayLabel>().label().toCaseFolded();
+}
+
+ConvertedContact ContactBuilder::convert(
+        const IndividualData &data,
+        const QString &managerUri)
+{
+    ConvertedContact converted;
+    QContact &contact = converted.contact;
+
+    contact.setId(contactId(managerUri, data.id));
+    contact.setCollectionId(aggregateCollectionId(managerUri));
+
+    // Every contact gets a copy of the same detail, sharing its data
+    static const QContactType typeTemplate = [] {
+        QContactType type;
+        type.setType(QContactType::TypeContact);
+        return type;
+    }();
+    QContactType type = typeTemplate;
+    contact.saveDetail(&type);
+
+    setDisplayLabel(contact, data.names);
+    setName(contact, data.names);
+    setNickname(contact, data.names);
+    setPresence(contact, data.presence);
+    setBirthday(contact, data.birthday);
+    setEmailAddresses(contact, data.emailAddresses);
+    setImAddresses(contact, data.imAddresses);
+    setFavorite(contact, data.isFavourite);
+    setGender(contact, data.gender);
+    setNotes(contact, data.notes);
+    setOrganizations(contact, data.roles);
+    setPhoneNumbers(contact, data.phoneNumbers);
+    setPostalAddresses(contact, data.postalAddresses);
+    setUrls(contact, data.urls);
+    setAvatar(contact, data.avatar);
+
+    converted.sortKey = sortKey(contact);
+    converted.collections = storeCollections(managerUri, data.stores);
+
+    return converted;
+}
+
+void ContactBuilder::setDisplayLabel(
+        QContact &contact,
+        const NameData &names)
+{
+    // The full name wins over the nickname, which wins over the alias
+    const QByteArray &label = !names.fullName.isEmpty() ? names.fullName
+        : !names.nickname.isEmpty() ? names.nickname : names.alias;
+    if(label.isEmpty())
+        return;
+
+    QContactDisplayLabel displayLabelDetail =
+        contact.detail<QContactDisplayLabel>();
+    displayLabelDetail.setLabel(QString::fromUtf8(label));
+    contact.saveDetail(&displayLabelDetail);
+}
+
+void ContactBuilder::setName(
+        QContact &contact,
+        const NameData &names)
+{
+    QList<QContactName> details;
+
+    // yay, gnome-contacts only sets the structured name once on contact creation,
+    // then never updates it (instead only updating the full name)
+    // until that's fixed, let's always go with the full name as QContactName
+    if(!names.fullName.isEmpty()) {
+        QContactName name;
+        const QString fullName = QString::fromUtf8(names.fullName);
+        QStringList parts = fullName.split(' ');
+        if (parts.length() == 2) {
+            name.setFirstName(parts.at(0));
+            name.setLastName(parts.at(1));
+        } else {
+            name.setFirstName(fullName);
+        }
+        details << name;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setNickname(
+        QContact &contact,
+        const NameData &names)
+{
+    QList<QContactNickname> details;
+    if(!names.nickname.isEmpty()) {
+        QContactNickname detail;
+        detail.setNickname(QString::fromUtf8(names.nickname));
+        details << detail;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setPresence(
+        QContact &contact,
+        const PresenceData &presence)
+{
+    QList<QContactGlobalPresence> details;
+    QContactGlobalPresence detail;
+    if(fillPresenceDetail(detail, presence))
+        details << detail;
+
+    replaceDetails(contact, details);
+}
+
+bool ContactBuilder::updatePresence(
+        QContact &contact,
+        const PresenceData &presence)
+{
+    QContactGlobalPresence detail = contact.detail<QContactGlobalPresence>();
+    const bool hadPresence = !detail.isEmpty();
+
+    if(!presence.isSet) {
+        if(!hadPresence)
+            return false;
+        contact.removeDetail(&detail);
+        return true;
+    }
+
+    const QString message = QString::fromUtf8(presence.message);
+    const QString nickname = QString::fromUtf8(presence.alias);
+    if(hadPresence && detail.presenceState() == presence.state
+            && detail.customMessage() == message
+            && detail.nickname() == nickname)
+        return false;
+
+    fillPresenceDetail(detail, presence);
+    contact.saveDetail(&detail);
+    return true;
+}
+
+void ContactBuilder::setAvatar(
+        QContact &contact,
+        const AvatarData &avatar)
+{
+    QList<QContactAvatar> details;
+    if(!avatar.uri.isEmpty() && !avatar.needsCaching) {
+        QContactAvatar detail;
+        detail.setImageUrl(QUrl(QString::fromUtf8(avatar.uri)));
+        details << detail;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setBirthday(
+        QContact &contact,
+        const QDateTime &birthday)
+{
+    QList<QContactBirthday> details;
+    if(birthday.isValid()) {
+        QContactBirthday detail;
+        detail.setDateTime(birthday);
+        details << detail;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setEmailAddresses(
+        QContact &contact,
+        const QList<FieldData> &addresses)
+{
+    QList<QContactEmailAddress> details;
+    foreach(const FieldData &field, addresses) {
+        QContactEmailAddress addr;
+        addr.setEmailAddress(QString::fromUtf8(field.value));
+        addr.setContexts(contexts(field.types));
+        details << addr;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setImAddresses(
+        QContact &contact,
+        const QList<ImAddressData> &addresses)
+{
+    // The accounts of personas with their own presence are managed by
+    // setPersonaAccount(), only replace the plain addresses
+    QStringList personaUris;
+    foreach(const QContactOnlineAccount &oldDetail,
+            contact.details<QContactOnlineAccount>()) {
+        if(isPersonaAccount(oldDetail))
+            personaUris << oldDetail.accountUri();
+    }
+
+    QList<QContactOnlineAccount> details;
+    foreach(const ImAddressData &field, addresses) {
+        if(personaUris.contains(QString::fromUtf8(field.uri)))
+            continue;
+
+        QContactOnlineAccount addr;
+        addr.setAccountUri(QString::fromUtf8(field.uri));
+        addr.setProtocol(Utils::onlineAccountProtocolFromString(field.protocol));
+
+        // Set Im type and contexts
+        QList<int> subTypes;
+        Utils::onlineAccountSubTypesFromStrings(field.types, &subTypes);
+        addr.setContexts(contexts(field.types));
+        addr.setSubTypes(valueSet(subTypes));
+
+        details << addr;
+    }
+
+    replaceDetails(contact, details, isPersonaAccount);
+}
+
+bool ContactBuilder::isPersonaAccount(const QContactOnlineAccount &account)
+{
+    return !account.detailUri().isEmpty();
+}
+
+QString ContactBuilder::personaAccountUri(const QByteArray &uid)
+{
+    return QLatin1String("account:") + QString::fromUtf8(uid);
+}
+
+QString ContactBuilder::personaPresenceUri(const QByteArray &uid)
+{
+    return QLatin1String("presence:") + QString::fromUtf8(uid);
+}
+
+void ContactBuilder::setPersonaAccount(
+        QContact &contact,
+        const PersonaData &persona)
+{
+    const QString accountUri = personaAccountUri(persona.uid);
+    const QString presenceUri = personaPresenceUri(persona.uid);
+    const QString displayId = QString::fromUtf8(persona.displayId);
+
+    // The persona's own account replaces the plain address of the same
+    // account, if setImAddresses() added one already
+    QContactOnlineAccount account;
+    foreach(QContactOnlineAccount oldDetail,
+            contact.details<QContactOnlineAccount>()) {
+        if(oldDetail.detailUri() == accountUri) {
+            account = oldDetail;
+        } else if(oldDetail.detailUri().isEmpty() &&
+                oldDetail.accountUri() == displayId) {
+            account.setContexts(oldDetail.contexts());
+            account.setSubTypes(oldDetail.subTypes());
+            contact.removeDetail(&oldDetail);
+        }
+    }
+
+    QContactPresence presence;
+    foreach(const QContactPresence &oldDetail,
+            contact.details<QContactPresence>()) {
+        if(oldDetail.detailUri() == presenceUri) {
+            presence = oldDetail;
+            break;
+        }
+    }
+
+    account.setDetailUri(accountUri);
+    account.setAccountUri(displayId);
+    account.setProtocol(Utils::onlineAccountProtocolFromString(persona.protocol));
+
+    if(fillPresenceDetail(presence, persona.presence)) {
+        presence.setDetailUri(presenceUri);
+        contact.saveDetail(&presence);
+        account.setLinkedDetailUris(presenceUri);
+    } else {
+        if(!presence.isEmpty())
+            contact.removeDetail(&presence);
+        account.setLinkedDetailUris(QStringList());
+    }
+
+    contact.saveDetail(&account);
+}
+
+void ContactBuilder::removePersonaAccount(
+        QContact &contact,
+        const QByteArray &uid)
+{
+    const QString accountUri = personaAccountUri(uid);
+    foreach(QContactOnlineAccount account,
+            contact.details<QContactOnlineAccount>()) {
+        if(account.detailUri() == accountUri)
+            contact.removeDetail(&account);
+    }
+
+    const QString presenceUri = personaPresenceUri(uid);
+    foreach(QContactPresence presence, contact.details<QContactPresence>()) {
+        if(presence.detailUri() == presenceUri)
+            contact.removeDetail(&presence);
+    }
+}
+
+void ContactBuilder::setFavorite(
+        QContact &contact,
+        bool isFavourite)
+{
+    QContactFavorite favorite;
+    favorite.setFavorite(isFavourite);
+
+    replaceDetails(contact, QList<QContactFavorite>() << favorite);
+}
+
+void ContactBuilder::setGender(
+        QContact &contact,
+        QContactGender::GenderField gender)
+{
+    // What's the difference between not having this field or having it
+    // set to GenderUnspecified? Let's just not save the detail at all.
+    QList<QContactGender> details;
+    if(gender != QContactGender::GenderUnspecified) {
+        QContactGender detail;
+        detail.setGender(gender);
+        details << detail;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setNotes(
+        QContact &contact,
+        const QList<FieldData> &notes)
+{
+    QList<QContactNote> details;
+    foreach(const FieldData &field, notes) {
+        QContactNote note;
+        note.setNote(QString::fromUtf8(field.value));
+        note.setContexts(contexts(field.types));
+        details << note;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setOrganizations(
+        QContact &contact,
+        const QList<RoleData> &roles)
+{
+    QList<QContactOrganization> details;
+    foreach(const RoleData &role, roles) {
+        QContactOrganization org;
+        org.setName(QString::fromUtf8(role.organisation));
+        org.setTitle(QString::fromUtf8(role.title));
+        org.setContexts(contexts(role.types));
+        details << org;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setPhoneNumbers(
+        QContact &contact,
+        const QList<FieldData> &numbers)
+{
+    QList<QContactPhoneNumber> details;
+    foreach(const FieldData &field, numbers) {
+        QContactPhoneNumber number;
+        number.setNumber(QString::fromUtf8(field.value));
+
+        // Set phone type
+        QList<int> subTypes;
+        Utils::phoneSubTypesFromStrings(field.types, &subTypes);
+        number.setContexts(contexts(field.types));
+        number.setSubTypes(valueSet(subTypes));
+
+        details << number;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setPostalAddresses(
+        QContact &contact,
+        const QList<PostalAddressData> &addresses)
+{
+    QList<QContactAddress> details;
+    foreach(const PostalAddressData &field, addresses) {
+        QContactAddress address;
+        address.setCountry(QString::fromUtf8(field.country));
+        address.setLocality(QString::fromUtf8(field.locality));
+        address.setPostOfficeBox(QString::fromUtf8(field.poBox));
+        address.setPostcode(QString::fromUtf8(field.postcode));
+        address.setRegion(QString::fromUtf8(field.region));
+        address.setStreet(QString::fromUtf8(field.street));
+
+        QList<int> subTypes;
+        Utils::addressSubTypesFromStrings(field.types, &subTypes);
+        address.setContexts(contexts(field.types));
+        address.setSubTypes(valueSet(subTypes));
+
+        details << address;
+    }
+
+    replaceDetails(contact, details);
+}
+
+void ContactBuilder::setUrls(
+        QContact &contact,
+        const QList<FieldData> &urls)
+{
+    QList<QContactUrl> details;
+    foreach(const FieldData &field, urls) {
+        QContactUrl url;
+        url.setUrl(QString::fromUtf8(field.value));
+        url.setContexts(contexts(field.types));
+        details << url;
+    }
+
+    replaceDetails(contact, details);
+}
+
+} // namespace Folks
@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CONTACT_BUILDER_H
+#define CONTACT_BUILDER_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QList>
+#include <QStringList>
+#include <QContact>
+#include <QContactCollection>
+#include <QContactCollectionId>
+#include <QContactGender>
+#include <QContactOnlineAccount>
+#include <QContactPresence>
+#include "internpool.h"
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+// Plain copies of the data IndividualReader extracts from a FolksIndividual.
+// Strings are kept as the UTF-8 Folks gave us; decoding them is left to
+// ContactBuilder so that it can happen on any thread.
+
+struct FieldData
+{
+    QByteArray value;
+    // Values of the vCard "type" parameter
+    QList<QByteArray> types;
+};
+
+struct ImAddressData
+{
+    QByteArray protocol;
+    QByteArray uri;
+    QList<QByteArray> types;
+};
+
+struct PostalAddressData
+{
+    QByteArray poBox;
+    QByteArray street;
+    QByteArray locality;
+    QByteArray region;
+    QByteArray postcode;
+    QByteArray country;
+    QList<QByteArray> types;
+};
+
+struct RoleData
+{
+    QByteArray organisation;
+    QByteArray title;
+    QList<QByteArray> types;
+};
+
+struct NameData
+{
+    QByteArray fullName;
+    QByteArray nickname;
+    QByteArray alias;
+};
+
+struct PresenceData
+{
+    PresenceData()
+        : isSet(false)
+        , state(QContactPresence::PresenceUnknown) {}
+
+    bool isSet;
+    QContactPresence::PresenceState state;
+    QByteArray message;
+    QByteArray alias;
+};
+
+struct AvatarData
+{
+    AvatarData()
+        : needsCaching(false) {}
+
+    QByteArray uri;
+    // The avatar is not a file yet and must be written to the Folks avatar
+    // cache (on the main thread) before the uri can be used.
+    bool needsCaching;
+};
+
+// A persona with a presence of its own, like a chat account. It becomes a
+// QContactOnlineAccount linked to a QContactPresence, both tagged with the
+// persona's uid so they can be found again when the persona changes.
+struct PersonaData
+{
+    QByteArray uid;
+    QByteArray displayId;
+    QByteArray protocol;
+    PresenceData presence;
+};
+
+// A Folks persona store (an EDS address book, a Telepathy account, the
+// key-file store...), which is exposed as a QContactCollection
+struct PersonaStoreData
+{
+    QByteArray typeId;
+    QByteArray id;
+    QByteArray displayName;
+};
+
+struct IndividualData
+{
+    IndividualData()
+        : isFavourite(false)
+        , gender(QContactGender::GenderUnspecified) {}
+
+    QByteArray id;
+    NameData names;
+    PresenceData presence;
+    AvatarData avatar;
+    QDateTime birthday;
+    QList<FieldData> emailAddresses;
+    QList<ImAddressData> imAddresses;
+    bool isFavourite;
+    QContactGender::GenderField gender;
+    QList<FieldData> notes;
+    QList<RoleData> roles;
+    QList<FieldData> phoneNumbers;
+    QList<PostalAddressData> postalAddresses;
+    QList<FieldData> urls;
+    // The stores the personas of the individual come from
+    QList<PersonaStoreData> stores;
+};
+
+struct ConvertedContact
+{
+    QContact contact;
+    QString sortKey;
+    QList<QContactCollection> collections;
+};
+
+QByteArray dbIdToByteArray(quint32 dbId, bool isCollection = false);
+
+// Turns IndividualData into QContact details.
+//
+// Nothing in here touches GObject, so all of it is safe to call from worker
+// threads, as long as each thread works on its own QContact.
+class ContactBuilder
+{
+public:
+    static ConvertedContact convert(const IndividualData &data,
+            const QString &managerUri);
+
+    static QContactId contactId(const QString &managerUri,
+            const QByteArray &folksId);
+    static QContactCollectionId aggregateCollectionId(const QString &managerUri);
+    static QContactCollection aggregateCollection(const QString &managerUri);
+    static QContactCollection storeCollection(const QString &managerUri,
+            const PersonaStoreData &store);
+    static QList<QContactCollection> storeCollections(
+            const QString &managerUri, const QList<PersonaStoreData> &stores);
+    static QString sortKey(const QContact &contact);
+
+    static void setDisplayLabel(QContact &contact, const NameData &names);
+    static void setName(QContact &contact, const NameData &names);
+    static void setNickname(QContact &contact, const NameData &names);
+    static void setPresence(QContact &contact, const PresenceData &presence);
+    // Like setPresence(), but edits the existing detail in place and returns
+    // false without touching contact if the presence didn't change
+    static bool updatePresence(QContact &contact,
+            const PresenceData &presence);
+    static void setAvatar(QContact &contact, const AvatarData &avatar);
+    static void setBirthday(QContact &contact, const QDateTime &birthday);
+    static void setEmailAddresses(QContact &contact,
+            const QList<FieldData> &addresses);
+    static void setImAddresses(QContact &contact,
+            const QList<ImAddressData> &addresses);
+    static void setFavorite(QContact &contact, bool isFavourite);
+    static void setGender(QContact &contact,
+            QContactGender::GenderField gender);
+    static void setNotes(QContact &contact, const QList<FieldData> &notes);
+    static void setOrganizations(QContact &contact,
+            const QList<RoleData> &roles);
+    static void setPhoneNumbers(QContact &contact,
+            const QList<FieldData> &numbers);
+    static void setPostalAddresses(QContact &contact,
+            const QList<PostalAddressData> &addresses);
+    static void setUrls(QContact &contact, const QList<FieldData> &urls);
+
+    static QString personaAccountUri(const QByteArray &uid);
+    static QString personaPresenceUri(const QByteArray &uid);
+    // Adds or updates the account and presence details of persona
+    static void setPersonaAccount(QContact &contact,
+            const PersonaData &persona);
+    static void removePersonaAccount(QContact &contact, const QByteArray &uid);
+    // Whether account was added by setPersonaAccount()
+    static bool isPersonaAccount(const QContactOnlineAccount &account);
+
+    // DetailType can be a QContactGlobalPresence or a QContactPresence
+    template<typename DetailType>
+    static bool fillPresenceDetail(DetailType &detail,
+            const PresenceData &presence)
+    {
+        if(!presence.isSet)
+            return false;
+
+        // Status messages like "Away" are shared by many contacts
+        detail.setCustomMessage(
+                InternPool::string(QString::fromUtf8(presence.message)));
+        detail.setPresenceState(presence.state);
+        detail.setNickname(QString::fromUtf8(presence.alias));
+        return true;
+    }
+
+    // Makes the details of DetailType in contact equal to details, which
+    // are freshly built. Existing details with the same values (contexts
+    // included) are kept as they are, with their keys and linked detail
+    // URIs; only the ones which are gone are removed and only new ones are
+    // saved. Existing details for which skip() returns true are left alone.
+    template<typename DetailType>
+    static void replaceDetails(QContact &contact, QList<DetailType> details,
+            bool (*skip)(const DetailType &) = 0)
+    {
+        foreach(DetailType oldDetail, contact.details<DetailType>()) {
+            if(skip && skip(oldDetail))
+                continue;
+
+            bool unchanged = false;
+            for(int i = 0; i < details.size(); ++i) {
+                if(details.at(i).values() == oldDetail.values()) {
+                    details.removeAt(i);
+                    unchanged = true;
+                    break;
+                }
+            }
+            if(!unchanged)
+                contact.removeDetail(&oldDetail);
+        }
+
+        for(int i = 0; i < details.size(); ++i)
+            contact.saveDetail(&details[i]);
+    }
+
+private:
+    // values sorted without duplicates and interned, the form ContactRecord
+    // stores as a bitmask
+    static QList<int> valueSet(QList<int> values);
+    // The QContactDetail contexts of the vCard types of a field
+    static QList<int> contexts(const QList<QByteArray> &types);
+};
+
+} // namespace Folks
+
+#endif // CONTACT_BUILDER_H
@@ -0,0 +1,396 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QContactDisplayLabel>
+#include <QContactEmailAddress>
+#include <QContactName>
+#include <QContactNickname>
+#include <QContactOnlineAccount>
+#include <QContactPhoneNumber>
+#include "contactindex.h"
+#include "phonenumber.h"
+
+namespace Folks
+{
+
+void PrefixIndex::insert(const QString &key, const QContactId &id)
+{
+    Bucket &bucket = m_buckets[key.left(BucketKeyLength)];
+    if(!bucket.contains(key, id))
+        bucket.insert(key, id);
+}
+
+void PrefixIndex::remove(const QString &key, const QContactId &id)
+{
+    const QString bucketKey = key.left(BucketKeyLength);
+    QHash<QString, Bucket>::iterator it = m_buckets.find(bucketKey);
+    if(it == m_buckets.end())
+        return;
+
+    it->remove(key, id);
+    if(it->isEmpty())
+        m_buckets.erase(it);
+}
+
+void PrefixIndex::exact(const QString &key, QSet<QContactId> *ids) const
+{
+    const Bucket bucket = m_buckets.value(key.left(BucketKeyLength));
+    for(Bucket::const_iterator it = bucket.constFind(key);
+            it != bucket.constEnd() && it.key() == key; ++it)
+        ids->insert(it.value());
+}
+
+void PrefixIndex::withPrefix(const QString &prefix, QSet<QContactId> *ids) const
+{
+    if(prefix.size() >= BucketKeyLength) {
+        collect(m_buckets.value(prefix.left(BucketKeyLength)), prefix, ids);
+        return;
+    }
+
+    // Short prefixes span several buckets
+    for(QHash<QString, Bucket>::const_iterator it = m_buckets.constBegin();
+            it != m_buckets.constEnd(); ++it) {
+        if(it.key().startsWith(prefix))
+            collect(it.value(), prefix, ids);
+    }
+}
+
+void PrefixIndex::collect(
+        const Bucket &bucket,
+        const QString &prefix,
+        QSet<QContactId> *ids)
+{
+    for(Bucket::const_iterator it = bucket.lowerBound(prefix);
+            it != bucket.constEnd() && it.key().startsWith(prefix); ++it)
+        ids->insert(it.value());
+}
+
+HashIndex::HashIndex()
+    : m_shards(ShardCount)
+{
+}
+
+void HashIndex::insert(const QString &key, const QContactId &id)
+{
+    const int index = qHash(key) % ShardCount;
+    if(m_shards.at(index).value(key).contains(id))
+        return;
+
+    m_shards[index][key].append(id);
+}
+
+void HashIndex::remove(const QString &key, const QContactId &id)
+{
+    const int index = qHash(key) % ShardCount;
+    if(!m_shards.at(index).value(key).contains(id))
+        return;
+
+    Shard &shard = m_shards[index];
+    Shard::iterator it = shard.find(key);
+    it->removeOne(id);
+    if(it->isEmpty())
+        shard.erase(it);
+}
+
+QVector<QContactId> HashIndex::values(const QString &key) const
+{
+    return m_shards.at(qHash(key) % ShardCount).value(key);
+}
+
+QStringList PhoneIndex::keys(const QContact &contact)
+{
+    QStringList numbers;
+    foreach(const QContactPhoneNumber &detail,
+            contact.details<QContactPhoneNumber>()) {
+        const QString number = PhoneNumber::normalize(detail.number());
+        if(!number.isEmpty() && !numbers.contains(number))
+            numbers << number;
+    }
+
+    return numbers;
+}
+
+void PhoneIndex::insert(const QContactId &id, const QStringList &numbers)
+{
+    foreach(const QString &number, numbers) {
+        m_numbers.insert(number, id);
+        m_reversedDigits.insert(
+                PhoneNumber::reversed(PhoneNumber::digits(number)), id);
+    }
+}
+
+void PhoneIndex::remove(const QContactId &id, const QStringList &numbers)
+{
+    foreach(const QString &number, numbers) {
+        m_numbers.remove(number, id);
+        m_reversedDigits.remove(
+                PhoneNumber::reversed(PhoneNumber::digits(number)), id);
+    }
+}
+
+bool PhoneIndex::lookup(
+        const QString &query,
+        QContactFilter::MatchFlags flags,
+        QSet<QContactId> *ids) const
+{
+    const QString digits = PhoneNumber::digits(query);
+    if(digits.isEmpty())
+        return false;
+
+    switch(int(flags) & PhoneNumber::MatchTypeMask) {
+    case QContactFilter::MatchStartsWith:
+        m_numbers.withPrefix(PhoneNumber::normalize(query), ids);
+        return true;
+    case QContactFilter::MatchEndsWith:
+        m_reversedDigits.withPrefix(PhoneNumber::reversed(digits), ids);
+        return true;
+    case QContactFilter::MatchContains:
+        return false;
+    default:
+        // Caller-id: only the last CallerIdDigits digits of long numbers
+        // have to match, short ones have to match completely
+        if(digits.size() >= PhoneNumber::CallerIdDigits)
+            m_reversedDigits.withPrefix(PhoneNumber::reversed(
+                        digits.right(PhoneNumber::CallerIdDigits)), ids);
+        else
+            m_reversedDigits.exact(PhoneNumber::reversed(digits), ids);
+        return true;
+    }
+}
+
+QString NameIndex::fold(const QString &text)
+{
+    const QString decomposed =
+        text.normalized(QString::NormalizationForm_KD);
+
+    QString folded;
+    folded.reserve(decomposed.size());
+    foreach(const QChar &c, decomposed) {
+        if(c.isMark())
+            continue;
+        folded += c;
+    }
+
+    return folded.toCaseFolded();
+}
+
+QStringList NameIndex::words(const QString &text)
+{
+    QStringList words;
+    QString word;
+
+    foreach(const QChar &c, fold(text)) {
+        if(c.isLetterOrNumber()) {
+            word += c;
+        } else if(!word.isEmpty()) {
+            words << word;
+            word.clear();
+        }
+    }
+    if(!word.isEmpty())
+        words << word;
+
+    return words;
+}
+
+bool NameIndex::isIndexedField(int detailType, int field)
+{
+    switch(detailType) {
+    case QContactDisplayLabel::Type:
+        return field == QContactDisplayLabel::FieldLabel;
+    case QContactName::Type:
+        return field == QContactName::FieldFirstName
+            || field == QContactName::FieldLastName
+            || field == QContactName::FieldMiddleName
+            || field == QContactName::FieldPrefix
+            || field == QContactName::FieldSuffix;
+    case QContactNickname::Type:
+        return field == QContactNickname::FieldNickname;
+    default:
+        return false;
+    }
+}
+
+QStringList NameIndex::keys(const QContact &contact)
+{
+    QStringList texts;
+    foreach(const QContactDisplayLabel &label,
+            contact.details<QContactDisplayLabel>())
+        texts << label.label();
+    foreach(const QContactName &name, contact.details<QContactName>())
+        texts << name.prefix() << name.firstName() << name.middleName()
+              << name.lastName() << name.suffix();
+    foreach(const QContactNickname &nickname,
+            contact.details<QContactNickname>())
+        texts << nickname.nickname();
+
+    QStringList keys;
+    foreach(const QString &text, texts) {
+        foreach(const QString &word, words(text)) {
+            if(!keys.contains(word))
+                keys << word;
+        }
+    }
+
+    return keys;
+}
+
+QSet<QString> NameIndex::trigrams(const QStringList &words)
+{
+    QSet<QString> trigrams;
+    foreach(const QString &word, words) {
+        for(int i = 0; i + TrigramLength <= word.size(); ++i)
+            trigrams.insert(word.mid(i, TrigramLength));
+    }
+
+    return trigrams;
+}
+
+void NameIndex::insert(const QContactId &id, const QStringList &words)
+{
+    foreach(const QString &word, words)
+        m_words.insert(word, id);
+    foreach(const QString &trigram, trigrams(words))
+        m_trigrams.insert(trigram, id);
+}
+
+void NameIndex::remove(const QContactId &id, const QStringList &words)
+{
+    foreach(const QString &word, words)
+        m_words.remove(word, id);
+    foreach(const QString &trigram, trigrams(words))
+        m_trigrams.remove(trigram, id);
+}
+
+bool NameIndex::lookup(
+        const QString &query,
+        QContactFilter::MatchFlags flags,
+        QSet<QContactId> *ids) const
+{
+    if(flags & (QContactFilter::MatchKeypadCollation |
+                QContactFilter::MatchPhoneNumber))
+        return false;
+
+    const QStringList queryWords = words(query);
+    if(queryWords.isEmpty())
+        return false;
+
+    switch(int(flags) & PhoneNumber::MatchTypeMask) {
+    case QContactFilter::MatchStartsWith:
+        // A value starting with the query has a word starting with the
+        // first word of the query
+        m_words.withPrefix(queryWords.first(), ids);
+        return true;
+
+    case QContactFilter::MatchContains:
+    {
+        // Every word of the query is part of a word of a matching value
+        QString longest;
+        foreach(const QString &word, queryWords) {
+            if(word.size() > longest.size())
+                longest = word;
+        }
+        if(longest.size() < TrigramLength)
+            return false;
+
+        QSet<QContactId> found;
+        bool first = true;
+        foreach(const QString &trigram, trigrams(QStringList() << longest)) {
+            QSet<QContactId> trigramIds;
+            foreach(const QContactId &id, m_trigrams.values(trigram))
+                trigramIds.insert(id);
+            if(first) {
+                found = trigramIds;
+                first = false;
+            } else {
+                found.intersect(trigramIds);
+            }
+            if(found.isEmpty())
+                break;
+        }
+        ids->unite(found);
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+QString AddressIndex::normalize(const QString &address)
+{
+    return address.trimmed().toCaseFolded();
+}
+
+void AddressIndex::insert(const QContactId &id, const QStringList &addresses)
+{
+    foreach(const QString &address, addresses)
+        m_addresses.insert(address, id);
+}
+
+void AddressIndex::remove(const QContactId &id, const QStringList &addresses)
+{
+    foreach(const QString &address, addresses)
+        m_addresses.remove(address, id);
+}
+
+bool AddressIndex::lookup(
+        const QString &query,
+        QContactFilter::MatchFlags flags,
+        QSet<QContactId> *ids) const
+{
+    // MatchExactly and MatchFixedString, with or without MatchCaseSensitive
+    if(int(flags) & PhoneNumber::MatchTypeMask)
+        return false;
+    if(flags & (QContactFilter::MatchKeypadCollation |
+                QContactFilter::MatchPhoneNumber))
+        return false;
+
+    foreach(const QContactId &id, m_addresses.values(normalize(query)))
+        ids->insert(id);
+
+    return true;
+}
+
+QStringList EmailIndex::keys(const QContact &contact)
+{
+    QStringList addresses;
+    foreach(const QContactEmailAddress &detail,
+            contact.details<QContactEmailAddress>()) {
+        const QString address = normalize(detail.emailAddress());
+        if(!address.isEmpty() && !addresses.contains(address))
+            addresses << address;
+    }
+
+    return addresses;
+}
+
+QStringList ImIndex::keys(const QContact &contact)
+{
+    QStringList uris;
+    foreach(const QContactOnlineAccount &detail,
+            contact.details<QContactOnlineAccount>()) {
+        const QString uri = normalize(detail.accountUri());
+        if(!uri.isEmpty() && !uris.contains(uri))
+            uris << uri;
+    }
+
+    return uris;
+}
+
+} // namespace Folks
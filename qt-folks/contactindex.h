@@ -0,0 +1,196 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CONTACT_INDEX_H
+#define CONTACT_INDEX_H
+
+#include <QContact>
+#include <QContactFilter>
+#include <QContactId>
+#include <QHash>
+#include <QMultiMap>
+#include <QSet>
+#include <QStringList>
+#include <QVector>
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+// Maps string keys to the contacts they belong to and answers exact and
+// prefix lookups.
+//
+// Keys are kept sorted in buckets grouped by their first BucketKeyLength
+// characters. The buckets are implicitly shared, so copying the index when
+// a snapshot is published is cheap and only the buckets changed afterwards
+// are duplicated.
+class PrefixIndex
+{
+public:
+    enum { BucketKeyLength = 2 };
+
+    void insert(const QString &key, const QContactId &id);
+    void remove(const QString &key, const QContactId &id);
+
+    void exact(const QString &key, QSet<QContactId> *ids) const;
+    void withPrefix(const QString &prefix, QSet<QContactId> *ids) const;
+
+private:
+    typedef QMultiMap<QString, QContactId> Bucket;
+
+    static void collect(const Bucket &bucket, const QString &prefix,
+            QSet<QContactId> *ids);
+
+    QHash<QString, Bucket> m_buckets;
+};
+
+// Maps string keys to the contacts they belong to and only answers exact
+// lookups, in constant time.
+//
+// Like PrefixIndex it is split into implicitly shared shards, so that a
+// published copy only duplicates the shards changed afterwards. The
+// contacts of each key are shared on their own too: a trigram of a common
+// name has thousands of them in a large address book, and changing another
+// key of its shard mustn't copy them. Changing one key copies its shard's
+// table of keys and its own contacts, nothing else.
+class HashIndex
+{
+public:
+    enum { ShardCount = 1024 };
+
+    HashIndex();
+
+    void insert(const QString &key, const QContactId &id);
+    void remove(const QString &key, const QContactId &id);
+
+    QVector<QContactId> values(const QString &key) const;
+
+private:
+    typedef QVector<QContactId> Ids;
+    typedef QHash<QString, Ids> Shard;
+
+    QVector<Shard> m_shards;
+};
+
+// Phone numbers of all contacts, for caller-id and dialer lookups.
+//
+// Every number is indexed twice: normalized, to find the numbers starting
+// with what has been dialed so far, and as its digits reversed, so that
+// matching the last N digits of a number is a prefix lookup as well.
+class PhoneIndex
+{
+public:
+    // The normalized phone numbers of contact, as they are indexed
+    static QStringList keys(const QContact &contact);
+
+    void insert(const QContactId &id, const QStringList &numbers);
+    void remove(const QContactId &id, const QStringList &numbers);
+
+    // Adds the contacts with a number matching query to ids, see
+    // PhoneNumber::matches(). Returns false if this kind of match can't be
+    // answered from the index.
+    bool lookup(const QString &query, QContactFilter::MatchFlags flags,
+            QSet<QContactId> *ids) const;
+
+private:
+    PrefixIndex m_numbers;
+    PrefixIndex m_reversedDigits;
+};
+
+// Words of the display label, name and nickname of all contacts, for
+// type-ahead search.
+//
+// Words are folded (case-folded, with accents and other marks removed).
+// MatchStartsWith filters are looked up by the first word of the query in a
+// PrefixIndex, MatchContains filters by the trigrams of its longest word.
+// Both only narrow the contacts down: the filter is still tested on every
+// contact found, so the results are exactly those of a full scan.
+class NameIndex
+{
+public:
+    enum { TrigramLength = 3 };
+
+    // The folded words of the name details of contact, as they are indexed
+    static QStringList keys(const QContact &contact);
+
+    static QString fold(const QString &text);
+    // The folded words of text
+    static QStringList words(const QString &text);
+
+    // Whether filters on this field can be looked up here
+    static bool isIndexedField(int detailType, int field);
+
+    void insert(const QContactId &id, const QStringList &words);
+    void remove(const QContactId &id, const QStringList &words);
+
+    // Adds the contacts which can match query to ids. Returns false if this
+    // kind of match can't be answered from the index.
+    bool lookup(const QString &query, QContactFilter::MatchFlags flags,
+            QSet<QContactId> *ids) const;
+
+private:
+    static QSet<QString> trigrams(const QStringList &words);
+
+    PrefixIndex m_words;
+    HashIndex m_trigrams;
+};
+
+// Addresses of all contacts, for looking a contact up by the address a
+// message or call came from.
+//
+// Addresses are compared case-insensitively, so only MatchExactly and
+// MatchFixedString filters are answered here; any contact found is still
+// tested with the filter itself.
+class AddressIndex
+{
+public:
+    static QString normalize(const QString &address);
+
+    void insert(const QContactId &id, const QStringList &addresses);
+    void remove(const QContactId &id, const QStringList &addresses);
+
+    // Adds the contacts with an address equal to query to ids. Returns false
+    // if this kind of match can't be answered from the index.
+    bool lookup(const QString &query, QContactFilter::MatchFlags flags,
+            QSet<QContactId> *ids) const;
+
+private:
+    HashIndex m_addresses;
+};
+
+class EmailIndex : public AddressIndex
+{
+public:
+    // The normalized email addresses of contact, as they are indexed
+    static QStringList keys(const QContact &contact);
+};
+
+// A detail filter only ever constrains one field, so IM addresses are
+// indexed by their account URI alone. The protocol is checked when the
+// contacts found are tested with the filter.
+class ImIndex : public AddressIndex
+{
+public:
+    // The normalized account URIs of contact, as they are indexed
+    static QStringList keys(const QContact &contact);
+};
+
+} // namespace Folks
+
+#endif // CONTACT_INDEX_H
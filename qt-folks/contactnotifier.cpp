@@ -31,20 +31,21 @@
  */
 
 #include "contactnotifier.h"
+#include "debug.h"
+#include "metrics.h"
 
 #include <QDBusConnection>
 #include <QDBusConnectionInterface>
 #include <QDBusMessage>
 #include <QDBusMetaType>
+#include <QDBusUnixFileDescriptor>
 #include <QVector>
 #include <QUuid>
 
-
-#include <QDebug>
-
 #define NOTIFIER_NAME "org.nemomobile.contacts.sqlite.uuid_%1"
 #define NOTIFIER_PATH "/org/nemomobile/contacts/sqlite"
 #define NOTIFIER_INTERFACE "org.nemomobile.contacts.sqlite"
+#define NOTIFIER_CONNECTION "qtfolks-notifier"
 
 Q_DECLARE_METATYPE(QVector<quint32>)
 
@@ -56,6 +57,7 @@ void initialize()
     if (!initialized) {
         initialized = true;
         qDBusRegisterMetaType<QVector<quint32> >();
+        qDBusRegisterMetaType<QList<QDBusUnixFileDescriptor> >();
     }
 }
 
@@ -80,36 +82,46 @@ QVector<quint32> idVector(const QList<QContactId> &contactIds)
     ids.reserve(contactIds.size());
     foreach (const QContactId &id, contactIds) {
 //        ids.append(ContactId::databaseId(id));
-        ids.append(qHash(id.toString()));
+        ids.append(ContactNotifier::contactIdHash(id));
     }
     return ids;
 }
-/*
+
 QVector<quint32> idVector(const QList<QContactCollectionId> &collectionIds)
 {
     QVector<quint32> ids;
     ids.reserve(collectionIds.size());
     foreach (const QContactCollectionId &id, collectionIds) {
 //        ids.append(ContactCollectionId::databaseId(id));
+        ids.append(qHash(id.toString()));
     }
     return ids;
 }
-*/
+
 }
 
-ContactNotifier::ContactNotifier(bool nonprivileged)
+ContactNotifier::ContactNotifier(bool nonprivileged, bool batchSignal)
     : m_nonprivileged(nonprivileged)
+    , m_connection(QDBusConnection::connectToBus(QDBusConnection::SessionBus,
+                QString::fromLatin1(NOTIFIER_CONNECTION)))
+    , m_batchSignal(batchSignal)
+    , m_flushSource(0)
 {
     initialize();
 }
 
 ContactNotifier::~ContactNotifier()
 {
-    if (QDBusConnection::sessionBus().isConnected() && !m_serviceName.isEmpty()) {
-        QDBusConnection::sessionBus().unregisterService(m_serviceName);
+    flush();
+
+    if (m_connection.isConnected()) {
+        foreach (const QString &name, m_claimedNames)
+            m_connection.unregisterService(name);
+        if (!m_serviceName.isEmpty())
+            m_connection.unregisterService(m_serviceName);
     }
 }
-/*
+
 void ContactNotifier::collectionsAdded(const QList<QContactCollectionId> &collectionIds)
 {
     if (!collectionIds.isEmpty()) {
@@ -118,7 +130,7 @@ void ContactNotifier::collectionsAdded(const QList<QContactCollectionId> &collec
         sendMessage(message);
     }
 }
-
+/*
 void ContactNotifier::collectionsChanged(const QList<QContactCollectionId> &collectionIds)
 {
     if (!collectionIds.isEmpty()) {
@@ -127,7 +139,7 @@ void ContactNotifier::collectionsChanged(const QList<QContactCollectionId> &coll
         sendMessage(message);
     }
 }
-
+*/
 void ContactNotifier::collectionsRemoved(const QList<QContactCollectionId> &collectionIds)
 {
     if (!collectionIds.isEmpty()) {
@@ -136,34 +148,47 @@ void ContactNotifier::collectionsRemoved(const QList<QContactCollectionId> &coll
         sendMessage(message);
     }
 }
-*/
+
 void ContactNotifier::contactsAdded(const QList<QContactId> &contactIds)
 {
-qWarning("contacts NOTIFYING ADDED");
-    if (!contactIds.isEmpty()) {
-        QDBusMessage message = createSignal("contactsAdded", m_nonprivileged);
-        message.setArguments(QVariantList() << QVariant::fromValue(idVector(contactIds)));
-        sendMessage(message);
+    FOLKS_TRACE(Folks::lcNotify) << "contactsAdded" << contactIds.size();
+    foreach (const QContactId &id, contactIds) {
+        if (m_removed.remove(id)) {
+            // Gone and back again, clients still have the old one
+            m_changed.insert(id);
+        } else {
+            m_added.insert(id);
+        }
     }
+    scheduleFlush();
 }
 
 void ContactNotifier::contactsChanged(const QList<QContactId> &contactIds)
 {
-qWarning("contacts NOTIFYING CHANGED");
-    if (!contactIds.isEmpty()) {
-        QDBusMessage message = createSignal("contactsChanged", m_nonprivileged);
-        message.setArguments(QVariantList() << QVariant::fromValue(idVector(contactIds)));
-        sendMessage(message);
+    FOLKS_TRACE(Folks::lcNotify) << "contactsChanged" << contactIds.size();
+    foreach (const QContactId &id, contactIds) {
+        // A full change covers a presence change, and clients will fetch
+        // a contact they are told about as added anyway
+        m_presenceChanged.remove(id);
+        if (m_added.contains(id) || m_changed.contains(id)) {
+            Folks::Metrics::increment(Folks::Metrics::NotificationsSuppressed);
+        } else {
+            m_changed.insert(id);
+        }
     }
+    scheduleFlush();
 }
 
 void ContactNotifier::contactsPresenceChanged(const QList<QContactId> &contactIds)
 {
-    if (!contactIds.isEmpty()) {
-        QDBusMessage message = createSignal("contactsPresenceChanged", m_nonprivileged);
-        message.setArguments(QVariantList() << QVariant::fromValue(idVector(contactIds)));
-        sendMessage(message);
+    foreach (const QContactId &id, contactIds) {
+        if (m_added.contains(id) || m_changed.contains(id) || m_presenceChanged.contains(id)) {
+            Folks::Metrics::increment(Folks::Metrics::NotificationsSuppressed);
+        } else {
+            m_presenceChanged.insert(id);
+        }
     }
+    scheduleFlush();
 }
 
 // notify that synced contacts have changed in the given collections
@@ -179,11 +204,17 @@ void ContactNotifier::collectionContactsChanged(const QList<QContactCollectionId
 */
 void ContactNotifier::contactsRemoved(const QList<QContactId> &contactIds)
 {
-    if (!contactIds.isEmpty()) {
-        QDBusMessage message = createSignal("contactsRemoved", m_nonprivileged);
-        message.setArguments(QVariantList() << QVariant::fromValue(idVector(contactIds)));
-        sendMessage(message);
+    foreach (const QContactId &id, contactIds) {
+        m_changed.remove(id);
+        m_presenceChanged.remove(id);
+        if (m_added.remove(id)) {
+            // Nobody has heard of it yet
+            Folks::Metrics::increment(Folks::Metrics::NotificationsSuppressed);
+        } else {
+            m_removed.insert(id);
+        }
     }
+    scheduleFlush();
 }
 
 void ContactNotifier::selfContactIdChanged(QContactId oldId, QContactId newId)
@@ -191,10 +222,18 @@ void ContactNotifier::selfContactIdChanged(QContactId oldId, QContactId newId)
     if (oldId != newId) {
         QDBusMessage message = createSignal("selfContactIdChanged", m_nonprivileged);
    //     message.setArguments(QVariantList() << QVariant::fromValue(ContactId::databaseId(oldId)) << QVariant::fromValue(ContactId::databaseId(newId)));
+        message.setArguments(QVariantList() << QVariant::fromValue(contactIdHash(oldId)) << QVariant::fromValue(contactIdHash(newId)));
         sendMessage(message);
     }
 }
 
+void ContactNotifier::snapshotChanged(quint64 generation)
+{
+    QDBusMessage message = createSignal("snapshotChanged", m_nonprivileged);
+    message.setArguments(QVariantList() << QVariant::fromValue(generation));
+    sendMessage(message);
+}
+
 void ContactNotifier::relationshipsAdded(const QSet<QContactId> &contactIds)
 {
     if (!contactIds.isEmpty()) {
@@ -219,51 +258,175 @@ void ContactNotifier::displayLabelGroupsChanged()
     sendMessage(message);
 }
 
-bool ContactNotifier::connect(const char *name, const char *signature, QObject *receiver, const char *slot)
+bool ContactNotifier::connect(const char *name, const char *signature, QObject *receiver, const char *slot,
+                              const QString &service)
 {
-    static QDBusConnection connection(QDBusConnection::sessionBus());
-
-    if (!connection.isConnected()) {
-        qWarning("Session Bus is not connected");
+    if (!m_connection.isConnected()) {
+        qCWarning(Folks::lcNotify) << "Session Bus is not connected";
         return false;
     }
 
-    if (!connection.connect(QString(),
-                            pathName(),
-                            interfaceName(m_nonprivileged),
-                            QLatin1String(name),
-                            QLatin1String(signature),
-                            receiver,
-                            slot)) {
-        qWarning("Unable to connect DBUS signal: %s", name);
+    if (!m_connection.connect(service,
+                              pathName(),
+                              interfaceName(m_nonprivileged),
+                              QLatin1String(name),
+                              QLatin1String(signature),
+                              receiver,
+                              slot)) {
+        qCWarning(Folks::lcNotify) << "Unable to connect DBUS signal:" << name;
         return false;
     }
 
     return true;
 }
 
-void ContactNotifier::sendMessage(const QDBusMessage &message)
+void ContactNotifier::flush()
 {
-    static QDBusConnection connection(QDBusConnection::sessionBus());
+    if (m_flushSource) {
+        g_source_remove(m_flushSource);
+        m_flushSource = 0;
+    }
 
-    if (!connection.isConnected()) {
-        qWarning("Session Bus is not connected");
+    if (m_added.isEmpty() && m_changed.isEmpty() && m_presenceChanged.isEmpty() && m_removed.isEmpty())
         return;
+
+    if (m_batchSignal) {
+        QDBusMessage message = createSignal("contactsBatchChanged", m_nonprivileged);
+        message.setArguments(QVariantList()
+                << QVariant::fromValue(idVector(m_added.toList()))
+                << QVariant::fromValue(idVector(m_changed.toList()))
+                << QVariant::fromValue(idVector(m_presenceChanged.toList()))
+                << QVariant::fromValue(idVector(m_removed.toList())));
+        send(message);
+    } else {
+        const struct {
+            const char *name;
+            const QSet<QContactId> &ids;
+        } kinds[] = {
+            { "contactsRemoved", m_removed },
+            { "contactsAdded", m_added },
+            { "contactsChanged", m_changed },
+            { "contactsPresenceChanged", m_presenceChanged }
+        };
+        for (const auto &kind : kinds) {
+            if (kind.ids.isEmpty())
+                continue;
+
+            QDBusMessage message = createSignal(kind.name, m_nonprivileged);
+            message.setArguments(QVariantList() << QVariant::fromValue(idVector(kind.ids.toList())));
+            send(message);
+        }
     }
 
+    m_added.clear();
+    m_changed.clear();
+    m_presenceChanged.clear();
+    m_removed.clear();
+}
+
+gboolean ContactNotifier::flushCb(gpointer userData)
+{
+    ContactNotifier *notifier = static_cast<ContactNotifier *>(userData);
+    notifier->m_flushSource = 0;
+    notifier->flush();
+
+    return G_SOURCE_REMOVE;
+}
+
+void ContactNotifier::scheduleFlush()
+{
+    const int pending = m_added.size() + m_changed.size() + m_presenceChanged.size() + m_removed.size();
+    if (pending >= FlushThreshold) {
+        flush();
+    } else if (pending > 0 && !m_flushSource) {
+        m_flushSource = g_timeout_add(FlushInterval, flushCb, this);
+    }
+}
+
+bool ContactNotifier::exportObject(const char *name, QObject *object)
+{
+    if (!m_connection.isConnected()) {
+        qCWarning(Folks::lcNotify) << "Session Bus is not connected";
+        return false;
+    }
+
+    if (!registerService())
+        return false;
+
+    const QString path = objectPath(name);
+    if (!m_connection.registerObject(path, object, QDBusConnection::ExportAllSlots)) {
+        qCWarning(Folks::lcNotify) << "Unable to export D-Bus object:" << path;
+        return false;
+    }
+
+    return true;
+}
+
+QString ContactNotifier::objectPath(const char *name)
+{
+    return pathName() + QLatin1Char('/') + QLatin1String(name);
+}
+
+bool ContactNotifier::claimName(const QString &name)
+{
+    if (!m_connection.isConnected()) {
+        qCWarning(Folks::lcNotify) << "Session Bus is not connected";
+        return false;
+    }
+
+    if (!m_connection.registerService(name)) {
+        qCWarning(Folks::lcNotify) << "Failed to register D-Bus service name" << name << ":"
+                                   << m_connection.lastError().name() << m_connection.lastError().message();
+        return false;
+    }
+
+    m_claimedNames << name;
+    return true;
+}
+
+quint32 ContactNotifier::contactIdHash(const QContactId &id)
+{
+    return qHash(id.toString());
+}
+
+bool ContactNotifier::registerService()
+{
     if (m_serviceName.isEmpty()) {
         // Register a unique name for this signal source on the session bus.
         // Remove surrounding braces and hyphens from the generated uuid.
         const QString uuid = QUuid::createUuid().toString();
         const QString serviceName = QString(NOTIFIER_NAME)
                 .arg(uuid.mid(1, uuid.length() - 2).replace('-', QString()));
-        if (connection.registerService(serviceName)) {
+        if (m_connection.registerService(serviceName)) {
             m_serviceName = serviceName;
         } else {
-            qWarning("Failed to register D-Bus service name %s for contact change notifications: %s %s" ,serviceName, connection.lastError().name(), connection.lastError().message());
-            return;
+            qCWarning(Folks::lcNotify) << "Failed to register D-Bus service name" << serviceName
+                                       << "for contact change notifications:"
+                                       << m_connection.lastError().name() << m_connection.lastError().message();
+            return false;
         }
     }
 
-    connection.send(message);
+    return true;
+}
+
+void ContactNotifier::sendMessage(const QDBusMessage &message)
+{
+    // Whatever happened to contacts before has to reach clients first
+    flush();
+    send(message);
+}
+
+void ContactNotifier::send(const QDBusMessage &message)
+{
+    if (!m_connection.isConnected()) {
+        qCWarning(Folks::lcNotify) << "Session Bus is not connected";
+        return;
+    }
+
+    if (!registerService())
+        return;
+
+    m_connection.send(message);
+    Folks::Metrics::increment(Folks::Metrics::NotificationsEmitted);
 }
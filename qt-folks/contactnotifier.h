@@ -34,26 +34,46 @@
 #define QTCONTACTSSQLITE_CONTACTNOTIFIER_H
 
 
+#include <glib.h>
 #include <QContact>
+#include <QContactCollectionId>
 #include <QContactId>
+#include <QDBusConnection>
 #include <QObject>
 #include <QSet>
+#include <QStringList>
 
 class QDBusMessage;
 
 QTCONTACTS_USE_NAMESPACE
 
+// Sends the change signals of the contacts sqlite backend, so that clients
+// written for it notice our changes too.
+//
+// Contact ids are not sent right away but collected per kind of change,
+// and sent as one signal per kind from the GLib main loop, after
+// FlushInterval or once FlushThreshold ids are pending. Ids cancel out
+// while they are pending: a contact added and removed again is never
+// announced, one added and changed is only announced as added.
+//
+// With batchSignal set, a single contactsBatchChanged(au added, au changed,
+// au presenceChanged, au removed) signal is sent instead.
 class ContactNotifier
 {
     bool m_nonprivileged;
 
 public:
-    ContactNotifier(bool nonprivileged);
+    enum {
+        FlushInterval = 50, // ms
+        FlushThreshold = 500
+    };
+
+    ContactNotifier(bool nonprivileged, bool batchSignal = false);
     ~ContactNotifier();
-/*
     void collectionsAdded(const QList<QContactCollectionId> &collectionIds);
-    void collectionsChanged(const QList<QContactCollectionId> &collectionIds);
     void collectionsRemoved(const QList<QContactCollectionId> &collectionIds);
+/*
+    void collectionsChanged(const QList<QContactCollectionId> &collectionIds);
     void collectionContactsChanged(const QList<QContactCollectionId> &collectionIds);
 */
     void contactsAdded(const QList<QContactId> &contactIds);
@@ -61,16 +81,53 @@ public:
     void contactsPresenceChanged(const QList<QContactId> &contactIds);
     void contactsRemoved(const QList<QContactId> &contactIds);
     void selfContactIdChanged(QContactId oldId, QContactId newId);
+    // A new segment of the SharedSnapshot is ready, after the changes it
+    // contains
+    void snapshotChanged(quint64 generation);
     void relationshipsAdded(const QSet<QContactId> &contactIds);
     void relationshipsRemoved(const QSet<QContactId> &contactIds);
     void displayLabelGroupsChanged();
 
-    bool connect(const char *name, const char *signature, QObject *receiver, const char *slot);
+    // Only signals sent by service are delivered if it is set
+    bool connect(const char *name, const char *signature, QObject *receiver, const char *slot,
+                 const QString &service = QString());
+
+    // Makes the slots of object callable on the notifier's service name, at
+    // objectPath(name)
+    bool exportObject(const char *name, QObject *object);
+    static QString objectPath(const char *name);
+
+    // Registers a well-known name for the notifier's connection as well
+    bool claimName(const QString &name);
+    QDBusConnection connection() const { return m_connection; }
+
+    // The number contact ids are sent as
+    static quint32 contactIdHash(const QContactId &id);
+
+    // Sends the pending contact changes now
+    void flush();
 
 private:
+    static gboolean flushCb(gpointer userData);
+    void scheduleFlush();
+
+    bool registerService();
+    // Sends message after the pending contact changes
     void sendMessage(const QDBusMessage &message);
+    void send(const QDBusMessage &message);
 
     QString m_serviceName;
+    QStringList m_claimedNames;
+    // Not the application's session bus connection, so our signals don't
+    // queue up behind its traffic
+    QDBusConnection m_connection;
+    bool m_batchSignal;
+
+    QSet<QContactId> m_added;
+    QSet<QContactId> m_changed;
+    QSet<QContactId> m_presenceChanged;
+    QSet<QContactId> m_removed;
+    guint m_flushSource;
 };
 
 #endif
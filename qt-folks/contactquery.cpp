@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QContactCollectionFilter>
+#include <QContactDetailFilter>
+#include <QContactEmailAddress>
+#include <QContactIntersectionFilter>
+#include <QContactManagerEngine>
+#include <QContactOnlineAccount>
+#include <QContactPhoneNumber>
+#include <QContactUnionFilter>
+#include "contactquery.h"
+#include "phonenumber.h"
+
+namespace Folks
+{
+
+bool ContactQuery::isPhoneNumberFilter(const QContactFilter &filter)
+{
+    if(filter.type() != QContactFilter::ContactDetailFilter)
+        return false;
+
+    const QContactDetailFilter detailFilter(filter);
+    return detailFilter.detailType() == QContactPhoneNumber::Type
+        && detailFilter.detailField() == QContactPhoneNumber::FieldNumber
+        && (detailFilter.matchFlags() & QContactFilter::MatchPhoneNumber);
+}
+
+bool ContactQuery::candidates(
+        const QContactFilter &filter,
+        const ContactSnapshot &snapshot,
+        QSet<QContactId> *ids)
+{
+    switch(filter.type()) {
+    case QContactFilter::ContactDetailFilter:
+    {
+        const QContactDetailFilter detailFilter(filter);
+        if(isPhoneNumberFilter(filter))
+            return snapshot.phoneIndex().lookup(
+                    detailFilter.value().toString(),
+                    detailFilter.matchFlags(), ids);
+        if(detailFilter.value().type() != QVariant::String)
+            return false;
+
+        const QString value = detailFilter.value().toString();
+        const int type = detailFilter.detailType();
+        const int field = detailFilter.detailField();
+        if(NameIndex::isIndexedField(type, field))
+            return snapshot.nameIndex().lookup(value,
+                    detailFilter.matchFlags(), ids);
+        if(type == QContactEmailAddress::Type &&
+                field == QContactEmailAddress::FieldEmailAddress)
+            return snapshot.emailIndex().lookup(value,
+                    detailFilter.matchFlags(), ids);
+        if(type == QContactOnlineAccount::Type &&
+                field == QContactOnlineAccount::FieldAccountUri)
+            return snapshot.imIndex().lookup(value,
+                    detailFilter.matchFlags(), ids);
+        return false;
+    }
+
+    case QContactFilter::CollectionFilter:
+    {
+        // Only store collections have member sets, anything else (like the
+        // aggregate collection every contact is in) needs a scan
+        QSet<QContactId> collectionIds;
+        foreach(const QContactCollectionId &id,
+                QContactCollectionFilter(filter).collectionIds()) {
+            const QSet<QContactId> *members = snapshot.members(id);
+            if(!members)
+                return false;
+            collectionIds.unite(*members);
+        }
+        ids->unite(collectionIds);
+        return true;
+    }
+
+    case QContactFilter::IntersectionFilter:
+    {
+        // Every term which can be looked up narrows the result down
+        bool planned = false;
+        foreach(const QContactFilter &term,
+                QContactIntersectionFilter(filter).filters()) {
+            QSet<QContactId> termIds;
+            if(!candidates(term, snapshot, &termIds))
+                continue;
+
+            if(planned) {
+                ids->intersect(termIds);
+            } else {
+                *ids = termIds;
+                planned = true;
+            }
+        }
+        return planned;
+    }
+
+    case QContactFilter::UnionFilter:
+    {
+        // All terms have to be looked up, one scan would be needed anyway
+        const QList<QContactFilter> terms = QContactUnionFilter(filter).filters();
+        if(terms.isEmpty())
+            return false;
+
+        // Each term gets a set of its own: an intersection term replaces
+        // what it is given instead of adding to it
+        QSet<QContactId> unionIds;
+        foreach(const QContactFilter &term, terms) {
+            QSet<QContactId> termIds;
+            if(!candidates(term, snapshot, &termIds))
+                return false;
+            unionIds.unite(termIds);
+        }
+        ids->unite(unionIds);
+        return true;
+    }
+
+    default:
+        return false;
+    }
+}
+
+bool ContactQuery::matches(
+        const QContactFilter &filter,
+        const ContactEntry &entry,
+        const QContact &contact)
+{
+    switch(filter.type()) {
+    case QContactFilter::ContactDetailFilter:
+    {
+        if(!isPhoneNumberFilter(filter))
+            break;
+
+        const QContactDetailFilter detailFilter(filter);
+        const QString query = detailFilter.value().toString();
+        foreach(const QContactPhoneNumber &number,
+                contact.details<QContactPhoneNumber>()) {
+            if(PhoneNumber::matches(number.number(), query,
+                        detailFilter.matchFlags()))
+                return true;
+        }
+        return false;
+    }
+
+    case QContactFilter::CollectionFilter:
+    {
+        const QSet<QContactCollectionId> ids =
+            QContactCollectionFilter(filter).collectionIds();
+        return ids.contains(contact.collectionId())
+            || ids.intersects(entry.collections);
+    }
+
+    case QContactFilter::IntersectionFilter:
+    {
+        const QList<QContactFilter> terms =
+            QContactIntersectionFilter(filter).filters();
+        if(terms.isEmpty())
+            break;
+
+        foreach(const QContactFilter &term, terms) {
+            if(!matches(term, entry, contact))
+                return false;
+        }
+        return true;
+    }
+
+    case QContactFilter::UnionFilter:
+    {
+        const QList<QContactFilter> terms = QContactUnionFilter(filter).filters();
+        if(terms.isEmpty())
+            break;
+
+        foreach(const QContactFilter &term, terms) {
+            if(matches(term, entry, contact))
+                return true;
+        }
+        return false;
+    }
+
+    default:
+        break;
+    }
+
+    return QContactManagerEngine::testFilter(filter, contact);
+}
+
+} // namespace Folks
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CONTACT_QUERY_H
+#define CONTACT_QUERY_H
+
+#include <QContact>
+#include <QContactFilter>
+#include <QSet>
+#include "contactstore.h"
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+// Decides how contacts() answers a filter: from the snapshot's indexes when
+// they cover it, by testing every contact otherwise.
+class ContactQuery
+{
+public:
+    // Collects every contact which can match filter from the indexes of
+    // snapshot. The result may contain contacts which don't match, so each
+    // one still has to be checked with matches(). Returns false if the
+    // filter can't be answered from the indexes.
+    static bool candidates(const QContactFilter &filter,
+            const ContactSnapshot &snapshot, QSet<QContactId> *ids);
+
+    // QContactManagerEngine::testFilter(), with the phone number matching
+    // from PhoneNumber so that scans and index lookups agree, and with
+    // collection filters also matching the store collections of the entry.
+    // contact is the one of entry, decoded once for every term of filter.
+    static bool matches(const QContactFilter &filter, const ContactEntry &entry,
+            const QContact &contact);
+
+private:
+    static bool isPhoneNumberFilter(const QContactFilter &filter);
+};
+
+} // namespace Folks
+
+#endif // CONTACT_QUERY_H
@@ -0,0 +1,687 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QContactAddress>
+#include <QContactAvatar>
+#include <QContactBirthday>
+#include <QContactDisplayLabel>
+#include <QContactEmailAddress>
+#include <QContactFavorite>
+#include <QContactGender>
+#include <QContactGlobalPresence>
+#include <QContactName>
+#include <QContactNickname>
+#include <QContactNote>
+#include <QContactOnlineAccount>
+#include <QContactOrganization>
+#include <QContactPhoneNumber>
+#include <QContactPresence>
+#include <QContactType>
+#include <QContactUrl>
+#include <QDataStream>
+#include <QDateTime>
+#include <QHash>
+#include <QStringList>
+#include <QUrl>
+#include <QVarLengthArray>
+#include "contactrecord.h"
+#include "internpool.h"
+#include "utf8.h"
+
+namespace Folks
+{
+
+namespace
+{
+
+const QDataStream::Version StreamVersion = QDataStream::Qt_5_6;
+
+enum Kind { String, Int, Bool, DateTime, Url, StringList, IntList };
+
+struct Field
+{
+    int field;
+    Kind kind;
+};
+
+struct Spec
+{
+    QContactDetail::DetailType type;
+    const Field *fields;
+    int fieldCount;
+};
+
+template<int N>
+constexpr int countOf(const Field (&)[N])
+{
+    return N;
+}
+
+// Every detail can have these, they take the lowest bits of the field mask
+const Field commonFields[] = {
+    { QContactDetail::FieldContext, IntList },
+    { QContactDetail::FieldDetailUri, String },
+    { QContactDetail::FieldLinkedDetailUris, StringList }
+};
+const int CommonFieldCount = countOf(commonFields);
+
+const Field typeFields[] = {
+    { QContactType::FieldType, Int }
+};
+const Field displayLabelFields[] = {
+    { QContactDisplayLabel::FieldLabel, String }
+};
+const Field nameFields[] = {
+    { QContactName::FieldPrefix, String },
+    { QContactName::FieldFirstName, String },
+    { QContactName::FieldMiddleName, String },
+    { QContactName::FieldLastName, String },
+    { QContactName::FieldSuffix, String }
+};
+const Field nicknameFields[] = {
+    { QContactNickname::FieldNickname, String }
+};
+const Field phoneNumberFields[] = {
+    { QContactPhoneNumber::FieldNumber, String },
+    { QContactPhoneNumber::FieldSubTypes, IntList }
+};
+const Field emailAddressFields[] = {
+    { QContactEmailAddress::FieldEmailAddress, String }
+};
+const Field onlineAccountFields[] = {
+    { QContactOnlineAccount::FieldAccountUri, String },
+    { QContactOnlineAccount::FieldServiceProvider, String },
+    { QContactOnlineAccount::FieldProtocol, Int },
+    { QContactOnlineAccount::FieldCapabilities, StringList },
+    { QContactOnlineAccount::FieldSubTypes, IntList }
+};
+const Field addressFields[] = {
+    { QContactAddress::FieldStreet, String },
+    { QContactAddress::FieldLocality, String },
+    { QContactAddress::FieldRegion, String },
+    { QContactAddress::FieldPostcode, String },
+    { QContactAddress::FieldCountry, String },
+    { QContactAddress::FieldPostOfficeBox, String },
+    { QContactAddress::FieldSubTypes, IntList }
+};
+const Field urlFields[] = {
+    { QContactUrl::FieldUrl, String },
+    { QContactUrl::FieldSubType, Int }
+};
+const Field noteFields[] = {
+    { QContactNote::FieldNote, String }
+};
+const Field organizationFields[] = {
+    { QContactOrganization::FieldName, String },
+    { QContactOrganization::FieldLogoUrl, Url },
+    { QContactOrganization::FieldDepartment, StringList },
+    { QContactOrganization::FieldLocation, String },
+    { QContactOrganization::FieldRole, String },
+    { QContactOrganization::FieldTitle, String },
+    { QContactOrganization::FieldAssistantName, String }
+};
+const Field birthdayFields[] = {
+    { QContactBirthday::FieldBirthday, DateTime },
+    { QContactBirthday::FieldCalendarId, String }
+};
+const Field genderFields[] = {
+    { QContactGender::FieldGender, Int }
+};
+const Field favoriteFields[] = {
+    { QContactFavorite::FieldFavorite, Bool },
+    { QContactFavorite::FieldIndex, Int }
+};
+const Field avatarFields[] = {
+    { QContactAvatar::FieldImageUrl, Url },
+    { QContactAvatar::FieldVideoUrl, Url }
+};
+// QContactGlobalPresence has the same fields
+const Field presenceFields[] = {
+    { QContactPresence::FieldTimestamp, DateTime },
+    { QContactPresence::FieldNickname, String },
+    { QContactPresence::FieldPresenceState, Int },
+    { QContactPresence::FieldPresenceStateText, String },
+    { QContactPresence::FieldPresenceStateImageUrl, Url },
+    { QContactPresence::FieldCustomMessage, String }
+};
+
+// Indexed by ContactRecord::Group
+const Spec specs[] = {
+    { QContactDetail::TypeType, typeFields, countOf(typeFields) },
+    { QContactDetail::TypeDisplayLabel, displayLabelFields, countOf(displayLabelFields) },
+    { QContactDetail::TypeName, nameFields, countOf(nameFields) },
+    { QContactDetail::TypeNickname, nicknameFields, countOf(nicknameFields) },
+    { QContactDetail::TypePhoneNumber, phoneNumberFields, countOf(phoneNumberFields) },
+    { QContactDetail::TypeEmailAddress, emailAddressFields, countOf(emailAddressFields) },
+    { QContactDetail::TypeOnlineAccount, onlineAccountFields, countOf(onlineAccountFields) },
+    { QContactDetail::TypeAddress, addressFields, countOf(addressFields) },
+    { QContactDetail::TypeUrl, urlFields, countOf(urlFields) },
+    { QContactDetail::TypeNote, noteFields, countOf(noteFields) },
+    { QContactDetail::TypeOrganization, organizationFields, countOf(organizationFields) },
+    { QContactDetail::TypeBirthday, birthdayFields, countOf(birthdayFields) },
+    { QContactDetail::TypeGender, genderFields, countOf(genderFields) },
+    { QContactDetail::TypeFavorite, favoriteFields, countOf(favoriteFields) },
+    { QContactDetail::TypeAvatar, avatarFields, countOf(avatarFields) },
+    { QContactDetail::TypeGlobalPresence, presenceFields, countOf(presenceFields) },
+    { QContactDetail::TypePresence, presenceFields, countOf(presenceFields) }
+};
+static_assert(sizeof(specs) / sizeof(specs[0]) == ContactRecord::OtherGroup,
+        "every group but OtherGroup needs a spec");
+
+int groupOf(QContactDetail::DetailType type)
+{
+    for(int group = 0; group < ContactRecord::OtherGroup; ++group) {
+        if(specs[group].type == type)
+            return group;
+    }
+    return ContactRecord::OtherGroup;
+}
+
+const Field &fieldAt(const Spec &spec, int index)
+{
+    return index < CommonFieldCount ? commonFields[index]
+        : spec.fields[index - CommonFieldCount];
+}
+
+quint64 zigzag(qint64 value)
+{
+    return (quint64(value) << 1) ^ quint64(value >> 63);
+}
+
+qint64 unzigzag(quint64 value)
+{
+    return qint64(value >> 1) ^ -qint64(value & 1);
+}
+
+void putVarint(QByteArray &out, quint64 value)
+{
+    while(value >= 0x80) {
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+// Contexts and sub-types as ContactBuilder makes them
+bool isBitmask(const QList<int> &values)
+{
+    int previous = -1;
+    foreach(int value, values) {
+        if(value <= previous || value >= 32)
+            return false;
+        previous = value;
+    }
+    return true;
+}
+
+bool fits(const QVariant &value, Kind kind)
+{
+    switch(kind) {
+    case String:
+        return value.userType() == QMetaType::QString;
+    case Int:
+        return value.userType() == QMetaType::Int;
+    case Bool:
+        return value.userType() == QMetaType::Bool;
+    case DateTime:
+    {
+        if(value.userType() != QMetaType::QDateTime)
+            return false;
+        const QDateTime dateTime = value.toDateTime();
+        return dateTime.isValid() && dateTime.timeSpec() != Qt::TimeZone;
+    }
+    case Url:
+        return value.userType() == QMetaType::QUrl;
+    case StringList:
+        return value.userType() == QMetaType::QStringList;
+    case IntList:
+        return value.userType() == qMetaTypeId<QList<int> >();
+    }
+    return false;
+}
+
+class StringTable
+{
+public:
+    int index(const QString &string)
+    {
+        QHash<QString, int>::const_iterator it = m_indices.constFind(string);
+        if(it != m_indices.constEnd())
+            return it.value();
+
+        const int index = m_strings.size();
+        m_indices.insert(string, index);
+        m_strings.append(string);
+        return index;
+    }
+
+    const QStringList &strings() const { return m_strings; }
+
+private:
+    QHash<QString, int> m_indices;
+    QStringList m_strings;
+};
+
+void putValue(QByteArray &out, StringTable &strings, const QVariant &value,
+        Kind kind)
+{
+    switch(kind) {
+    case String:
+        putVarint(out, strings.index(value.toString()));
+        break;
+    case Int:
+        putVarint(out, zigzag(value.toInt()));
+        break;
+    case Bool:
+        out.append(char(value.toBool()));
+        break;
+    case DateTime:
+    {
+        const QDateTime dateTime = value.toDateTime();
+        putVarint(out, zigzag(dateTime.toMSecsSinceEpoch()));
+        out.append(char(dateTime.timeSpec()));
+        if(dateTime.timeSpec() == Qt::OffsetFromUTC)
+            putVarint(out, zigzag(dateTime.offsetFromUtc()));
+        break;
+    }
+    case Url:
+        putVarint(out, strings.index(
+                    value.toUrl().toString(QUrl::FullyEncoded)));
+        break;
+    case StringList:
+    {
+        const QStringList list = value.toStringList();
+        putVarint(out, list.size());
+        foreach(const QString &string, list)
+            putVarint(out, strings.index(string));
+        break;
+    }
+    case IntList:
+    {
+        // The lowest bit tells a bitmask from a count of values
+        const QList<int> list = value.value<QList<int> >();
+        if(isBitmask(list)) {
+            quint32 mask = 0;
+            foreach(int bit, list)
+                mask |= 1u << bit;
+            putVarint(out, (quint64(mask) << 1) | 1);
+        } else {
+            putVarint(out, quint64(list.size()) << 1);
+            foreach(int item, list)
+                putVarint(out, zigzag(item));
+        }
+        break;
+    }
+    }
+}
+
+// Returns false, without writing anything, if detail has fields or values
+// spec doesn't expect
+bool putDetail(QByteArray &out, StringTable &strings,
+        const QContactDetail &detail, const Spec &spec)
+{
+    const QMap<int, QVariant> values = detail.values();
+    const int fieldCount = CommonFieldCount + spec.fieldCount;
+
+    quint64 mask = 0;
+    int found = 0;
+    for(int i = 0; i < fieldCount; ++i) {
+        QMap<int, QVariant>::const_iterator it =
+            values.constFind(fieldAt(spec, i).field);
+        if(it == values.constEnd())
+            continue;
+        if(!fits(it.value(), fieldAt(spec, i).kind))
+            return false;
+
+        mask |= Q_UINT64_C(1) << i;
+        found++;
+    }
+    if(found != values.size())
+        return false;
+
+    putVarint(out, mask);
+    for(int i = 0; i < fieldCount; ++i) {
+        if(mask & (Q_UINT64_C(1) << i))
+            putValue(out, strings, values.value(fieldAt(spec, i).field),
+                    fieldAt(spec, i).kind);
+    }
+    return true;
+}
+
+class Reader
+{
+public:
+    Reader(const uchar *data, quint64 size)
+        : m_pos(data)
+        , m_end(data + size)
+        , m_ok(true) {}
+
+    bool ok() const { return m_ok; }
+    bool atEnd() const { return m_pos == m_end; }
+
+    quint8 byte()
+    {
+        if(m_pos == m_end) {
+            m_ok = false;
+            return 0;
+        }
+        return *m_pos++;
+    }
+
+    quint64 varint()
+    {
+        quint64 value = 0;
+        for(int shift = 0; shift < 64 && m_pos != m_end; shift += 7) {
+            const uchar b = *m_pos++;
+            value |= quint64(b & 0x7f) << shift;
+            if(!(b & 0x80))
+                return value;
+        }
+
+        m_ok = false;
+        return 0;
+    }
+
+    const uchar *take(quint64 size)
+    {
+        if(quint64(m_end - m_pos) < size) {
+            m_ok = false;
+            return 0;
+        }
+
+        const uchar *data = m_pos;
+        m_pos += size;
+        return data;
+    }
+
+private:
+    const uchar *m_pos;
+    const uchar *m_end;
+    bool m_ok;
+};
+
+class Decoder
+{
+public:
+    Decoder()
+        : m_ok(true) {}
+
+    bool ok() const { return m_ok; }
+
+    void addString(const uchar *data, int size)
+    {
+        m_strings.append(qMakePair(reinterpret_cast<const char *>(data), size));
+    }
+
+    // Strings are only decoded when a detail asks for them
+    QString string(quint64 index)
+    {
+        if(index >= quint64(m_strings.size())) {
+            m_ok = false;
+            return QString();
+        }
+        return QString::fromUtf8(m_strings.at(index).first,
+                m_strings.at(index).second);
+    }
+
+    QVariant value(Reader &reader, Kind kind)
+    {
+        switch(kind) {
+        case String:
+            return string(reader.varint());
+        case Int:
+            return int(unzigzag(reader.varint()));
+        case Bool:
+            return bool(reader.byte());
+        case DateTime:
+        {
+            const qint64 msecs = unzigzag(reader.varint());
+            const int spec = reader.byte();
+            if(spec == Qt::OffsetFromUTC)
+                return QDateTime::fromMSecsSinceEpoch(msecs, Qt::OffsetFromUTC,
+                        int(unzigzag(reader.varint())));
+            return QDateTime::fromMSecsSinceEpoch(msecs,
+                    spec == Qt::UTC ? Qt::UTC : Qt::LocalTime);
+        }
+        case Url:
+            return QUrl(string(reader.varint()));
+        case StringList:
+        {
+            QStringList list;
+            const quint64 count = reader.varint();
+            for(quint64 i = 0; i < count && reader.ok() && m_ok; ++i)
+                list << string(reader.varint());
+            return list;
+        }
+        case IntList:
+        {
+            QList<int> list;
+            const quint64 header = reader.varint();
+            if(header & 1) {
+                const quint64 mask = header >> 1;
+                for(int bit = 0; bit < 32; ++bit) {
+                    if(mask & (Q_UINT64_C(1) << bit))
+                        list << bit;
+                }
+            } else {
+                const quint64 count = header >> 1;
+                for(quint64 i = 0; i < count && reader.ok(); ++i)
+                    list << int(unzigzag(reader.varint()));
+            }
+            // Share the few distinct lists, like ContactBuilder does
+            return QVariant::fromValue(InternPool::intList(list));
+        }
+        }
+
+        m_ok = false;
+        return QVariant();
+    }
+
+private:
+    QVarLengthArray<QPair<const char *, int>, 64> m_strings;
+    bool m_ok;
+};
+
+bool decodeGroup(Reader &reader, int group, Decoder &decoder,
+        QContact *contact)
+{
+    const quint64 count = reader.varint();
+    for(quint64 i = 0; i < count && reader.ok(); ++i) {
+        if(group == ContactRecord::OtherGroup) {
+            const quint64 size = reader.varint();
+            const uchar *data = reader.take(size);
+            if(!reader.ok())
+                return false;
+
+            QDataStream in(QByteArray::fromRawData(
+                        reinterpret_cast<const char *>(data), size));
+            in.setVersion(StreamVersion);
+            QContactDetail detail;
+            in >> detail;
+            if(in.status() != QDataStream::Ok)
+                return false;
+
+            contact->saveDetail(&detail);
+            continue;
+        }
+
+        const Spec &spec = specs[group];
+        QContactDetail detail(spec.type);
+        const quint64 mask = reader.varint();
+        for(int j = 0; j < CommonFieldCount + spec.fieldCount; ++j) {
+            if(mask & (Q_UINT64_C(1) << j))
+                detail.setValue(fieldAt(spec, j).field,
+                        decoder.value(reader, fieldAt(spec, j).kind));
+        }
+        contact->saveDetail(&detail);
+    }
+
+    return reader.ok() && decoder.ok();
+}
+
+}
+
+quint32 ContactRecord::groupMask(
+        const QList<QContactDetail::DetailType> &types)
+{
+    if(types.isEmpty())
+        return AllGroups;
+
+    quint32 groups = groupMask(OtherGroup);
+    foreach(QContactDetail::DetailType type, types)
+        groups |= 1u << groupOf(type);
+    return groups;
+}
+
+QContact ContactRecord::select(
+        const QContact &contact,
+        quint32 groups)
+{
+    if(groups == AllGroups)
+        return contact;
+
+    QContact selected;
+    selected.setId(contact.id());
+    selected.setCollectionId(contact.collectionId());
+    foreach(QContactDetail detail, contact.details()) {
+        if(groups & (1u << groupOf(detail.type())))
+            selected.saveDetail(&detail);
+    }
+    return selected;
+}
+
+QByteArray ContactRecord::encode(const QContact &contact)
+{
+    StringTable strings;
+    const int idIndex = contact.id().isNull() ? 0
+        : strings.index(contact.id().toString()) + 1;
+    const int collectionIndex = contact.collectionId().isNull() ? 0
+        : strings.index(contact.collectionId().toString()) + 1;
+
+    QByteArray groups[GroupCount];
+    int counts[GroupCount] = {};
+    foreach(const QContactDetail &detail, contact.details()) {
+        const int group = groupOf(detail.type());
+        if(group != OtherGroup &&
+                putDetail(groups[group], strings, detail, specs[group])) {
+            counts[group]++;
+            continue;
+        }
+
+        QByteArray encoded;
+        QDataStream out(&encoded, QIODevice::WriteOnly);
+        out.setVersion(StreamVersion);
+        out << detail;
+        putVarint(groups[OtherGroup], encoded.size());
+        groups[OtherGroup].append(encoded);
+        counts[OtherGroup]++;
+    }
+
+    QByteArray record;
+    record.append(char(Version));
+    putVarint(record, strings.strings().size());
+    foreach(const QString &string, strings.strings()) {
+        const Utf8 utf8(string);
+        putVarint(record, utf8.size());
+        record.append(utf8.data(), utf8.size());
+    }
+    putVarint(record, idIndex);
+    putVarint(record, collectionIndex);
+
+    QByteArray table;
+    QByteArray payloads;
+    int groupCount = 0;
+    for(int group = 0; group < GroupCount; ++group) {
+        if(!counts[group])
+            continue;
+
+        const int start = payloads.size();
+        putVarint(payloads, counts[group]);
+        payloads.append(groups[group]);
+
+        table.append(char(group));
+        putVarint(table, payloads.size() - start);
+        groupCount++;
+    }
+
+    record.append(char(groupCount));
+    record.append(table);
+    record.append(payloads);
+
+    return record;
+}
+
+bool ContactRecord::decode(
+        const char *data,
+        int size,
+        QContact *contact,
+        quint32 groups)
+{
+    Reader reader(reinterpret_cast<const uchar *>(data), size);
+    if(reader.byte() != Version)
+        return false;
+
+    Decoder decoder;
+    const quint64 stringCount = reader.varint();
+    for(quint64 i = 0; i < stringCount; ++i) {
+        const quint64 length = reader.varint();
+        const uchar *bytes = reader.take(length);
+        if(!reader.ok())
+            return false;
+        decoder.addString(bytes, int(length));
+    }
+
+    const quint64 idIndex = reader.varint();
+    const quint64 collectionIndex = reader.varint();
+    if(idIndex)
+        contact->setId(QContactId::fromString(decoder.string(idIndex - 1)));
+    if(collectionIndex)
+        contact->setCollectionId(QContactCollectionId::fromString(
+                    decoder.string(collectionIndex - 1)));
+
+    struct Entry
+    {
+        int group;
+        quint64 size;
+    };
+    QVarLengthArray<Entry, GroupCount> table;
+    const int groupCount = reader.byte();
+    for(int i = 0; i < groupCount && reader.ok(); ++i) {
+        Entry entry;
+        entry.group = reader.byte();
+        entry.size = reader.varint();
+        table.append(entry);
+    }
+
+    for(int i = 0; i < table.size() && reader.ok(); ++i) {
+        const Entry &entry = table.at(i);
+        const uchar *payload = reader.take(entry.size);
+        if(!reader.ok() || entry.group >= GroupCount)
+            return false;
+        if(!(groups & groupMask(Group(entry.group))))
+            continue;
+
+        Reader groupReader(payload, entry.size);
+        if(!decodeGroup(groupReader, entry.group, decoder, contact))
+            return false;
+    }
+
+    return reader.ok() && decoder.ok();
+}
+
+} // namespace Folks
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CONTACT_RECORD_H
+#define CONTACT_RECORD_H
+
+#include <QByteArray>
+#include <QContact>
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+// A compact binary encoding for the contacts ContactBuilder produces, used
+// by SharedSnapshot and ContactService.
+//
+// Integers are little-endian base 128 varints, signed ones zigzag encoded.
+// A record is
+//   u8 Version
+//   the string table: the number of strings, then each one as its UTF-8
+//   length and bytes
+//   the contact id and collection id, as 1 + their string index, 0 if null
+//   u8 number of groups, then each group's u8 Group and payload size
+//   the group payloads, in the same order
+// A group holds all details of one type: their count, then per detail a
+// bitmask of the fields it has, followed by their values. Strings are
+// indices into the string table, so a value repeated in a contact is only
+// stored once. Contexts and sub-types sorted without duplicates, as
+// ContactBuilder makes them, are bitmasks. Details of other types, or with
+// fields or values of other types than expected, go to OtherGroup, encoded
+// with QDataStream, so nothing is ever lost.
+//
+// The sizes in the group table let decode() skip the groups it isn't
+// asked for.
+class ContactRecord
+{
+public:
+    enum { Version = 1 };
+
+    enum Group {
+        TypeGroup,
+        DisplayLabelGroup,
+        NameGroup,
+        NicknameGroup,
+        PhoneNumberGroup,
+        EmailAddressGroup,
+        OnlineAccountGroup,
+        AddressGroup,
+        UrlGroup,
+        NoteGroup,
+        OrganizationGroup,
+        BirthdayGroup,
+        GenderGroup,
+        FavoriteGroup,
+        AvatarGroup,
+        GlobalPresenceGroup,
+        PresenceGroup,
+        OtherGroup,
+        GroupCount
+    };
+
+    static const quint32 AllGroups = 0xffffffff;
+    static quint32 groupMask(Group group) { return 1u << group; }
+    // The groups holding details of types, as for
+    // QContactFetchHint::detailTypesHint(): all of them if types is empty.
+    // OtherGroup is always included, details not fitting their group's spec
+    // are kept there.
+    static quint32 groupMask(const QList<QContactDetail::DetailType> &types);
+
+    // contact with only the details decode() would add for groups
+    static QContact select(const QContact &contact, quint32 groups);
+
+    static QByteArray encode(const QContact &contact);
+
+    // Sets the id of contact and adds the details of the groups in groups.
+    // Returns false if data isn't a record of this version.
+    static bool decode(const char *data, int size, QContact *contact,
+            quint32 groups = AllGroups);
+    static bool decode(const QByteArray &data, QContact *contact,
+            quint32 groups = AllGroups)
+    {
+        return decode(data.constData(), data.size(), contact, groups);
+    }
+};
+
+} // namespace Folks
+
+#endif // CONTACT_RECORD_H
@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QDataStream>
+#include <QDBusConnectionInterface>
+#include <QDBusReply>
+#include <QSet>
+#include <unistd.h>
+#include "contactbuilder.h"
+#include "contactnotifier.h"
+#include "contactrecord.h"
+#include "contactservice.h"
+
+namespace Folks
+{
+
+namespace
+{
+
+const QDataStream::Version StreamVersion = QDataStream::Qt_5_6;
+
+}
+
+QString ContactService::serviceName()
+{
+    return QStringLiteral("org.nemomobile.contacts.folks");
+}
+
+QString ContactService::interfaceName()
+{
+    return QStringLiteral("org.nemomobile.contacts.sqlite.Contacts");
+}
+
+ContactService::ContactService(const ContactStore *store, QObject *parent)
+    : QObject(parent)
+    , m_store(store)
+{
+}
+
+ContactService::~ContactService()
+{
+    foreach(const Segment &segment, m_segments)
+        close(segment.fd);
+}
+
+void ContactService::addSnapshotSegment(
+        int fd,
+        quint64 baseGeneration,
+        quint64 generation)
+{
+    // Clients which mapped the old ones keep their mappings
+    if(!baseGeneration) {
+        foreach(const Segment &segment, m_segments)
+            close(segment.fd);
+        m_segments.clear();
+    }
+
+    Segment segment;
+    segment.fd = fd;
+    segment.baseGeneration = baseGeneration;
+    segment.generation = generation;
+    m_segments.append(segment);
+}
+
+quint64 ContactService::snapshotGeneration() const
+{
+    return m_segments.isEmpty() ? 0 : m_segments.last().generation;
+}
+
+QByteArray ContactService::encode(
+        const ContactSnapshot &snapshot,
+        const QList<const ContactEntry *> &entries)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+
+    out << quint32(Version)
+        << ContactNotifier::contactIdHash(snapshot.selfContactId())
+        << snapshot.selfContactId().localId()
+        << quint32(entries.size());
+    foreach(const ContactEntry *entry, entries) {
+        const QContact contact = entry->contact();
+        out << ContactNotifier::contactIdHash(contact.id())
+            << ContactRecord::encode(contact)
+            << quint32(entry->collections.size());
+
+        foreach(const QContactCollectionId &id, entry->collections) {
+            const QContactCollection collection = snapshot.collection(id);
+            out << id.localId()
+                << collection.metaData(QContactCollection::KeyName).toString()
+                << collection.extendedMetaData();
+        }
+    }
+
+    return data;
+}
+
+bool ContactService::decode(
+        const QByteArray &data,
+        const QString &managerUri,
+        ServedContacts *contacts)
+{
+    QDataStream in(data);
+    in.setVersion(StreamVersion);
+
+    quint32 version = 0;
+    QByteArray selfLocalId;
+    quint32 count = 0;
+    in >> version;
+    if(in.status() != QDataStream::Ok || version != Version)
+        return false;
+
+    in >> contacts->selfContactKey >> selfLocalId >> count;
+    if(!selfLocalId.isEmpty())
+        contacts->selfContactId = QContactId(managerUri, selfLocalId);
+
+    // The primary's ids carry its manager URI, which needn't be ours
+    const QContactCollectionId aggregateId =
+        ContactBuilder::aggregateCollectionId(managerUri);
+
+    for(quint32 i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        ServedContact served;
+        QByteArray record;
+        quint32 collectionCount = 0;
+        in >> served.key >> record >> collectionCount;
+        if(in.status() != QDataStream::Ok ||
+                !ContactRecord::decode(record, &served.contact))
+            return false;
+
+        served.contact.setId(QContactId(managerUri,
+                    served.contact.id().localId()));
+        served.contact.setCollectionId(aggregateId);
+
+        for(quint32 j = 0; j < collectionCount; ++j) {
+            QByteArray localId;
+            QString name;
+            QVariantMap extendedMetaData;
+            in >> localId >> name >> extendedMetaData;
+
+            QContactCollection collection;
+            collection.setId(QContactCollectionId(managerUri, localId));
+            collection.setMetaData(QContactCollection::KeyName, name);
+            for(QVariantMap::const_iterator it = extendedMetaData.constBegin();
+                    it != extendedMetaData.constEnd(); ++it)
+                collection.setExtendedMetaData(it.key(), it.value());
+            served.collections << collection;
+        }
+
+        contacts->contacts << served;
+    }
+
+    return in.status() == QDataStream::Ok;
+}
+
+bool ContactService::isCallerAllowed() const
+{
+    if(!calledFromDBus())
+        return true;
+
+    const QDBusReply<uint> uid =
+        connection().interface()->serviceUid(message().service());
+    if(uid.isValid() && uid.value() == getuid())
+        return true;
+
+    sendErrorReply(QDBusError::AccessDenied,
+            QStringLiteral("Contacts are only served to their owner"));
+    return false;
+}
+
+QList<QDBusUnixFileDescriptor> ContactService::SnapshotFiles(
+        quint64 since) const
+{
+    QList<QDBusUnixFileDescriptor> files;
+    if(!isCallerAllowed() || m_segments.isEmpty())
+        return files;
+
+    // Deltas only apply on top of the segment before them
+    int first = 0;
+    while(first < m_segments.size() &&
+            m_segments.at(first).baseGeneration != since)
+        ++first;
+    if(first == m_segments.size())
+        first = since == snapshotGeneration() ? m_segments.size() : 0;
+
+    // Copies the descriptors, ours stay open for the next client
+    for(int i = first; i < m_segments.size(); ++i)
+        files << QDBusUnixFileDescriptor(m_segments.at(i).fd);
+
+    return files;
+}
+
+QByteArray ContactService::Snapshot(uint page) const
+{
+    if(!isCallerAllowed())
+        return QByteArray();
+
+    const ContactSnapshotPtr snapshot = m_store->snapshot();
+
+    QList<const ContactEntry *> entries;
+    if(page < PageCount) {
+        snapshot->forEachInShard(page, [&entries](const ContactEntry &entry) {
+            entries << &entry;
+        });
+    }
+
+    return encode(*snapshot, entries);
+}
+
+QByteArray ContactService::Fetch(const QVector<quint32> &keys) const
+{
+    if(!isCallerAllowed())
+        return QByteArray();
+
+    const ContactSnapshotPtr snapshot = m_store->snapshot();
+
+    QSet<quint32> seen;
+    QList<const ContactEntry *> entries;
+    foreach(quint32 key, keys) {
+        if(seen.contains(key))
+            continue;
+        seen.insert(key);
+
+        foreach(const QContactId &id, snapshot->idsForKey(key)) {
+            const ContactEntry *entry = snapshot->find(id);
+            if(entry)
+                entries << entry;
+        }
+    }
+
+    return encode(*snapshot, entries);
+}
+
+} // namespace Folks
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CONTACT_SERVICE_H
+#define CONTACT_SERVICE_H
+
+#include <QByteArray>
+#include <QContact>
+#include <QContactCollection>
+#include <QContactId>
+#include <QDBusContext>
+#include <QDBusUnixFileDescriptor>
+#include <QList>
+#include <QObject>
+#include <QVector>
+#include "contactstore.h"
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+struct ServedContact
+{
+    // The id hash the primary's change signals use for this contact, see
+    // ContactNotifier::contactIdHash()
+    quint32 key;
+    QContact contact;
+    QList<QContactCollection> collections;
+};
+
+struct ServedContacts
+{
+    ServedContacts()
+        : selfContactKey(0) {}
+
+    // The key of the self contact, which may not be among the contacts
+    quint32 selfContactKey;
+    // Keys can collide, the id can't
+    QContactId selfContactId;
+    QList<ServedContact> contacts;
+};
+
+// Serves the contacts of the primary engine to engines running in client
+// mode in other processes, so that only one process aggregates with Folks.
+//
+// Clients map the segments of the shared snapshot from SnapshotFiles() and
+// map the ones written after whenever the primary announces a new
+// generation. Where file
+// descriptors can't be passed, they read the store page by page with
+// Snapshot() instead and follow the primary's change signals, calling
+// Fetch() for the contacts added or changed. Both return the contacts
+// encoded with encode(); ids in there belong to the primary and are moved
+// to the client's manager URI by decode().
+//
+// Only processes of the user running the primary are served; anyone else
+// on the bus could otherwise read the whole address book.
+class ContactService : public QObject, protected QDBusContext
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.nemomobile.contacts.sqlite.Contacts")
+
+public:
+    enum {
+        Version = 5,
+        // Snapshot() splits the store into this many pages
+        PageCount = ContactSnapshot::ShardCount
+    };
+
+    // The well-known bus name of the primary engine
+    static QString serviceName();
+    static QString interfaceName();
+
+    ContactService(const ContactStore *store, QObject *parent = 0);
+    ~ContactService();
+
+    // Takes over fd, a segment of generation written by
+    // SharedSnapshot::write() on top of baseGeneration. A base segment
+    // replaces all the others.
+    void addSnapshotSegment(int fd, quint64 baseGeneration, quint64 generation);
+    // 0 before the first segment
+    quint64 snapshotGeneration() const;
+    int snapshotSegments() const { return m_segments.size(); }
+
+    static QByteArray encode(const ContactSnapshot &snapshot,
+            const QList<const ContactEntry *> &entries);
+    // Returns false if data isn't something encode() wrote
+    static bool decode(const QByteArray &data, const QString &managerUri,
+            ServedContacts *contacts);
+
+public slots:
+    // The segments of the shared snapshot written after generation since,
+    // see SharedSnapshot. All of them, starting with the base, if since is
+    // older than the base. Empty if there are none; clients fall back to
+    // Snapshot() then.
+    QList<QDBusUnixFileDescriptor> SnapshotFiles(quint64 since) const;
+    // The contacts of one page, so that no reply holds the whole store.
+    // Pages are read from whatever snapshot is current at the time.
+    QByteArray Snapshot(uint page) const;
+    // Every contact with one of keys, so all of them if keys collide.
+    // Contacts which are gone by now are left out.
+    QByteArray Fetch(const QVector<quint32> &keys) const;
+
+private:
+    // Replies with an error to callers from D-Bus running as another user
+    bool isCallerAllowed() const;
+
+    struct Segment
+    {
+        int fd;
+        quint64 baseGeneration;
+        quint64 generation;
+    };
+
+    const ContactStore *m_store;
+    // The base first
+    QList<Segment> m_segments;
+};
+
+} // namespace Folks
+
+#endif // CONTACT_SERVICE_H
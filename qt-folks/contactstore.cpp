@@ -0,0 +1,372 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "contactnotifier.h"
+#include "contactstore.h"
+#include "sharedsnapshot.h"
+
+namespace Folks
+{
+
+IndexKeys IndexKeys::of(const QContact &contact)
+{
+    IndexKeys keys;
+    keys.phone = PhoneIndex::keys(contact);
+    keys.name = NameIndex::keys(contact);
+    keys.email = EmailIndex::keys(contact);
+    keys.im = ImIndex::keys(contact);
+
+    return keys;
+}
+
+QContact ContactEntry::contact(
+        quint32 groups) const
+{
+    return shared ? shared->contact(record, groups)
+        : ContactRecord::select(stored, groups);
+}
+
+IndexKeys ContactEntry::indexKeys() const
+{
+    return shared ? shared->indexKeys(record) : IndexKeys::of(stored);
+}
+
+ContactSnapshot::ContactSnapshot()
+    : m_shards(ShardCount)
+    , m_keys(ShardCount)
+    , m_count(0)
+    , m_generation(0)
+{
+}
+
+int ContactSnapshot::shardFor(const QContactId &id)
+{
+    return qHash(id) % ShardCount;
+}
+
+bool ContactSnapshot::contains(const QContactId &id) const
+{
+    return m_shards.at(shardFor(id)).contains(id);
+}
+
+QContact ContactSnapshot::contact(
+        const QContactId &id,
+        quint32 groups) const
+{
+    const ContactEntry *entry = find(id);
+    return entry ? entry->contact(groups) : QContact();
+}
+
+const ContactEntry *ContactSnapshot::find(const QContactId &id) const
+{
+    const Shard &shard = m_shards.at(shardFor(id));
+    Shard::const_iterator it = shard.constFind(id);
+    return it != shard.constEnd() ? &it.value() : 0;
+}
+
+QList<QContactId> ContactSnapshot::idsForKey(quint32 key) const
+{
+    return m_keys.at(key % ShardCount).values(key);
+}
+
+QList<QContactId> ContactSnapshot::contactIds() const
+{
+    QList<QContactId> ids;
+    ids.reserve(m_count);
+    foreach(const Shard &shard, m_shards)
+        ids += shard.keys();
+
+    return ids;
+}
+
+QList<QContactCollection> ContactSnapshot::collections() const
+{
+    return m_collections.values();
+}
+
+QContactCollection ContactSnapshot::collection(
+        const QContactCollectionId &id) const
+{
+    return m_collections.value(id);
+}
+
+const QSet<QContactId> *ContactSnapshot::members(
+        const QContactCollectionId &id) const
+{
+    QHash<QContactCollectionId, QSet<QContactId> >::const_iterator it =
+        m_members.constFind(id);
+    return it != m_members.constEnd() ? &it.value() : 0;
+}
+
+// Moves id from its old keys in index to the new ones
+template<typename Index>
+static void reindexKeys(Index &index, const QContactId &id,
+        const QStringList &oldKeys, const QStringList &newKeys)
+{
+    if(oldKeys == newKeys)
+        return;
+
+    index.remove(id, oldKeys);
+    index.insert(id, newKeys);
+}
+
+ContactStore::ContactStore()
+    : m_dirty(false)
+    , m_collectChanges(false)
+    , m_published(std::make_shared<const ContactSnapshot>())
+{
+}
+
+void ContactStore::insert(const QContact &contact, const QString &sortKey)
+{
+    // Non-const access detaches the shard (and the shard vector) from the
+    // last published snapshot, if it is still shared with it.
+    ContactSnapshot::Shard &shard =
+        m_working.m_shards[ContactSnapshot::shardFor(contact.id())];
+
+    ContactSnapshot::Shard::iterator it = shard.find(contact.id());
+    const bool isNew = it == shard.end();
+    if(isNew) {
+        it = shard.insert(contact.id(), ContactEntry());
+        addEntry(contact.id());
+    }
+
+    reindex(contact.id(), isNew ? IndexKeys() : it->indexKeys(),
+            IndexKeys::of(contact));
+
+    it->stored = contact;
+    it->shared.reset();
+    it->record = -1;
+    it->sortKey = sortKey;
+    touch(it.key(), &*it);
+}
+
+void ContactStore::insertShared(const SharedSnapshotPtr &shared, int record)
+{
+    const QContactId id = shared->contactId(record);
+    ContactSnapshot::Shard &shard =
+        m_working.m_shards[ContactSnapshot::shardFor(id)];
+
+    ContactSnapshot::Shard::iterator it = shard.find(id);
+    const bool isNew = it == shard.end();
+    if(isNew) {
+        it = shard.insert(id, ContactEntry());
+        addEntry(id);
+    }
+
+    reindex(id, isNew ? IndexKeys() : it->indexKeys(),
+            shared->indexKeys(record));
+
+    it->stored = QContact();
+    it->shared = shared;
+    it->record = record;
+    it->sortKey = shared->sortKey(record);
+    touch(it.key(), &*it);
+
+    setCollections(id, shared->collections(record));
+}
+
+void ContactStore::rebind(
+        const QContactId &id,
+        const SharedSnapshotPtr &shared,
+        int record)
+{
+    ContactSnapshot::Shard &shard =
+        m_working.m_shards[ContactSnapshot::shardFor(id)];
+    ContactSnapshot::Shard::iterator it = shard.find(id);
+    if(it == shard.end())
+        return;
+
+    it->shared = shared;
+    it->record = record;
+    m_dirty = true;
+}
+
+void ContactStore::updatePresence(const QContact &contact)
+{
+    ContactSnapshot::Shard &shard =
+        m_working.m_shards[ContactSnapshot::shardFor(contact.id())];
+    ContactSnapshot::Shard::iterator it = shard.find(contact.id());
+    if(it == shard.end())
+        return;
+
+    it->stored = contact;
+    touch(it.key(), &*it);
+}
+
+void ContactStore::remove(const QContactId &id)
+{
+    const int index = ContactSnapshot::shardFor(id);
+    if(!m_working.m_shards.at(index).contains(id))
+        return;
+
+    ContactSnapshot::Shard &shard = m_working.m_shards[index];
+    foreach(const QContactCollectionId &collectionId,
+            shard.value(id).collections)
+        leave(id, collectionId);
+
+    reindex(id, shard.find(id)->indexKeys(), IndexKeys());
+    shard.remove(id);
+    m_working.m_count--;
+
+    const quint32 key = ContactNotifier::contactIdHash(id);
+    m_working.m_keys[key % ContactSnapshot::ShardCount].remove(key, id);
+    if(m_working.m_selfContactId == id)
+        m_working.m_selfContactId = QContactId();
+    if(m_collectChanges)
+        m_changed.insert(id);
+    m_dirty = true;
+}
+
+void ContactStore::setCollections(
+        const QContactId &id,
+        const QList<QContactCollection> &collections)
+{
+    ContactSnapshot::Shard &shard =
+        m_working.m_shards[ContactSnapshot::shardFor(id)];
+    ContactSnapshot::Shard::iterator it = shard.find(id);
+    if(it == shard.end())
+        return;
+
+    QSet<QContactCollectionId> ids;
+    foreach(const QContactCollection &collection, collections)
+        ids.insert(collection.id());
+    if(ids == it->collections)
+        return;
+
+    foreach(const QContactCollectionId &collectionId, it->collections) {
+        if(!ids.contains(collectionId))
+            leave(id, collectionId);
+    }
+    foreach(const QContactCollection &collection, collections) {
+        if(!it->collections.contains(collection.id()))
+            join(id, collection);
+    }
+
+    it->collections = ids;
+    touch(it.key(), &*it);
+}
+
+void ContactStore::setSelfContactId(const QContactId &id)
+{
+    if(m_working.m_selfContactId == id)
+        return;
+
+    m_working.m_selfContactId = id;
+    m_dirty = true;
+}
+
+void ContactStore::addEntry(const QContactId &id)
+{
+    m_working.m_count++;
+
+    const quint32 key = ContactNotifier::contactIdHash(id);
+    m_working.m_keys[key % ContactSnapshot::ShardCount].insert(key, id);
+}
+
+void ContactStore::touch(const QContactId &id, ContactEntry *entry)
+{
+    entry->changed = m_working.m_generation + 1;
+    if(m_collectChanges)
+        m_changed.insert(id);
+    m_dirty = true;
+}
+
+void ContactStore::reindex(
+        const QContactId &id,
+        const IndexKeys &oldKeys,
+        const IndexKeys &newKeys)
+{
+    reindexKeys(m_working.m_phoneIndex, id, oldKeys.phone, newKeys.phone);
+    reindexKeys(m_working.m_nameIndex, id, oldKeys.name, newKeys.name);
+    reindexKeys(m_working.m_emailIndex, id, oldKeys.email, newKeys.email);
+    reindexKeys(m_working.m_imIndex, id, oldKeys.im, newKeys.im);
+}
+
+void ContactStore::join(
+        const QContactId &id,
+        const QContactCollection &collection)
+{
+    const QContactCollectionId &collectionId = collection.id();
+    if(!m_working.m_collections.contains(collectionId)) {
+        m_working.m_collections.insert(collectionId, collection);
+        if(!m_removedCollections.remove(collectionId))
+            m_addedCollections.insert(collectionId);
+    }
+
+    m_working.m_members[collectionId].insert(id);
+}
+
+void ContactStore::leave(
+        const QContactId &id,
+        const QContactCollectionId &collectionId)
+{
+    QSet<QContactId> &members = m_working.m_members[collectionId];
+    members.remove(id);
+    if(!members.isEmpty())
+        return;
+
+    m_working.m_members.remove(collectionId);
+    m_working.m_collections.remove(collectionId);
+    if(!m_addedCollections.remove(collectionId))
+        m_removedCollections.insert(collectionId);
+}
+
+void ContactStore::takeCollectionChanges(
+        QList<QContactCollectionId> *added,
+        QList<QContactCollectionId> *removed)
+{
+    *added = m_addedCollections.toList();
+    *removed = m_removedCollections.toList();
+    m_addedCollections.clear();
+    m_removedCollections.clear();
+}
+
+void ContactStore::publish()
+{
+    if(!m_dirty)
+        return;
+
+    m_working.m_generation++;
+    std::atomic_store(&m_published,
+            ContactSnapshotPtr(std::make_shared<const ContactSnapshot>(m_working)));
+    m_publishedChanges.unite(m_changed);
+    m_changed.clear();
+    m_dirty = false;
+}
+
+void ContactStore::setCollectChanges(bool collect)
+{
+    m_collectChanges = collect;
+    m_changed.clear();
+    m_publishedChanges.clear();
+}
+
+QSet<QContactId> ContactStore::takePublishedChanges()
+{
+    QSet<QContactId> changes;
+    changes.swap(m_publishedChanges);
+    return changes;
+}
+
+ContactSnapshotPtr ContactStore::snapshot() const
+{
+    return std::atomic_load(&m_published);
+}
+
+} // namespace Folks
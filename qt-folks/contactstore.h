@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef CONTACT_STORE_H
+#define CONTACT_STORE_H
+
+#include <QContact>
+#include <QContactCollection>
+#include <QContactId>
+#include <QHash>
+#include <QStringList>
+#include "contactindex.h"
+#include "contactrecord.h"
+#include <QVector>
+
+#include <memory>
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+class SharedSnapshot;
+typedef std::shared_ptr<const SharedSnapshot> SharedSnapshotPtr;
+
+// The keys a contact is found by in the indexes of a snapshot
+struct IndexKeys
+{
+    static IndexKeys of(const QContact &contact);
+
+    QStringList phone;
+    QStringList name;
+    QStringList email;
+    QStringList im;
+};
+
+struct ContactEntry
+{
+    ContactEntry()
+        : changed(0), record(-1) {}
+
+    // Entries inserted from a SharedSnapshot only refer to their record in
+    // there, and their contact is decoded again on every call, so callers
+    // needing it more than once keep the result
+    // Only the details of groups are added, see ContactRecord::decode()
+    QContact contact(quint32 groups = ContactRecord::AllGroups) const;
+    IndexKeys indexKeys() const;
+
+    // Case-folded display label, see ContactBuilder::sortKey()
+    QString sortKey;
+    // The persona store collections the contact has personas in. The
+    // contact itself always stays in the aggregate collection.
+    QSet<QContactCollectionId> collections;
+    // The generation of the snapshot the entry last changed in
+    quint64 changed;
+
+    // The contact, unless it is in shared
+    QContact stored;
+    SharedSnapshotPtr shared;
+    int record;
+};
+
+// An immutable view of every contact known to the engine.
+//
+// Snapshots are only ever created by ContactStore::publish() and never
+// modified afterwards, so any number of threads can read the same snapshot
+// without locking. Contacts are spread over a fixed number of implicitly
+// shared shards: publishing a new version only copies the shards that were
+// touched since the previous one. The lookup indexes are kept in the
+// snapshot too, so they always agree with the contacts next to them.
+class ContactSnapshot
+{
+public:
+    enum { ShardCount = 64 };
+
+    ContactSnapshot();
+
+    int count() const { return m_count; }
+    // The contact of the user individual, if Folks has one
+    QContactId selfContactId() const { return m_selfContactId; }
+    quint64 generation() const { return m_generation; }
+
+    bool contains(const QContactId &id) const;
+    QContact contact(const QContactId &id,
+            quint32 groups = ContactRecord::AllGroups) const;
+    QList<QContactId> contactIds() const;
+
+    // Returns 0 if there is no such contact. The entry stays valid for as
+    // long as the snapshot itself.
+    const ContactEntry *find(const QContactId &id) const;
+    // The contacts whose id hashes to key, see
+    // ContactNotifier::contactIdHash(). Hashes collide, so there can be
+    // more than one.
+    QList<QContactId> idsForKey(quint32 key) const;
+
+    const PhoneIndex &phoneIndex() const { return m_phoneIndex; }
+    const NameIndex &nameIndex() const { return m_nameIndex; }
+    const EmailIndex &emailIndex() const { return m_emailIndex; }
+    const ImIndex &imIndex() const { return m_imIndex; }
+
+    // The persona store collections with at least one contact in them
+    QList<QContactCollection> collections() const;
+    // Returns an invalid collection if there is no such store collection
+    QContactCollection collection(const QContactCollectionId &id) const;
+    // Returns 0 if id isn't a store collection
+    const QSet<QContactId> *members(const QContactCollectionId &id) const;
+
+    // The entries passed to function stay valid for as long as the
+    // snapshot itself
+    template<typename Function>
+    void forEach(Function function) const
+    {
+        for(int shard = 0; shard < ShardCount; ++shard)
+            forEachInShard(shard, function);
+    }
+
+    // forEach() for the entries of one of the ShardCount shards
+    template<typename Function>
+    void forEachInShard(int shard, Function function) const
+    {
+        const Shard &entries = m_shards.at(shard);
+        for(Shard::const_iterator it = entries.constBegin();
+                it != entries.constEnd(); ++it)
+            function(it.value());
+    }
+
+private:
+    friend class ContactStore;
+
+    typedef QHash<QContactId, ContactEntry> Shard;
+    typedef QMultiHash<quint32, QContactId> KeyShard;
+
+    static int shardFor(const QContactId &id);
+
+    QVector<Shard> m_shards;
+    // Sharded like the contacts, so publishing stays cheap
+    QVector<KeyShard> m_keys;
+    PhoneIndex m_phoneIndex;
+    NameIndex m_nameIndex;
+    EmailIndex m_emailIndex;
+    ImIndex m_imIndex;
+    QHash<QContactCollectionId, QContactCollection> m_collections;
+    QHash<QContactCollectionId, QSet<QContactId> > m_members;
+    QContactId m_selfContactId;
+    int m_count;
+    quint64 m_generation;
+};
+
+typedef std::shared_ptr<const ContactSnapshot> ContactSnapshotPtr;
+
+// The writable side of the contact store.
+//
+// All mutating methods and publish() must be called from the thread which
+// owns the engine (the one running the GLib main loop). snapshot() can be
+// called from any thread; it never blocks on the writer and the writer never
+// waits for readers still holding older snapshots.
+class ContactStore
+{
+public:
+    ContactStore();
+
+    void insert(const QContact &contact, const QString &sortKey);
+    void remove(const QContactId &id);
+    // insert() for a contact whose presence is the only thing that changed.
+    // Presence isn't indexed, so this skips updating the indexes.
+    void updatePresence(const QContact &contact);
+
+    // Moves the contact, which must have been inserted, into exactly these
+    // store collections. Collections are created when their first contact
+    // joins and dropped when their last one leaves.
+    void setCollections(const QContactId &id,
+            const QList<QContactCollection> &collections);
+
+    void setSelfContactId(const QContactId &id);
+
+    // insert() and setCollections() for a record of a shared snapshot,
+    // without decoding its contact
+    void insertShared(const SharedSnapshotPtr &shared, int record);
+    // Points a contact inserted with insertShared() at its unchanged record
+    // in a newer shared snapshot
+    void rebind(const QContactId &id, const SharedSnapshotPtr &shared,
+            int record);
+
+    // The collections created and dropped since the last call
+    void takeCollectionChanges(QList<QContactCollectionId> *added,
+            QList<QContactCollectionId> *removed);
+
+    // Make every change since the last call visible to snapshot()
+    void publish();
+
+    // Makes publish() collect the ids of the contacts it publishes
+    // changes of, inserted and removed ones included. Off by default.
+    void setCollectChanges(bool collect);
+    // The ids collected since the last call
+    QSet<QContactId> takePublishedChanges();
+
+    ContactSnapshotPtr snapshot() const;
+
+private:
+    // Counts a new entry and makes it findable by its key
+    void addEntry(const QContactId &id);
+    // Stamps entry with the generation publish() will give the changes
+    void touch(const QContactId &id, ContactEntry *entry);
+    void reindex(const QContactId &id, const IndexKeys &oldKeys,
+            const IndexKeys &newKeys);
+    void join(const QContactId &id, const QContactCollection &collection);
+    void leave(const QContactId &id, const QContactCollectionId &collectionId);
+
+    ContactSnapshot m_working;
+    bool m_dirty;
+    bool m_collectChanges;
+    // The ids changed in m_working, and in the snapshots published since
+    // the last takePublishedChanges()
+    QSet<QContactId> m_changed;
+    QSet<QContactId> m_publishedChanges;
+    QSet<QContactCollectionId> m_addedCollections;
+    QSet<QContactCollectionId> m_removedCollections;
+
+    // Only accessed through std::atomic_load()/std::atomic_store()
+    ContactSnapshotPtr m_published;
+};
+
+} // namespace Folks
+
+#endif // CONTACT_STORE_H
@@ -1,6 +1,5 @@
 /*
- * Copyright (C) 2011 Collabora Ltd.
- *   @author Travis Reitter <travis.reitter@collabora.co.uk>
+ * Copyright (C) 2026 qtfolks contributors
  *
  * This program is free software; you can redistribute it and/or
  * modify it under the terms of the GNU Lesser General Public
@@ -17,10 +16,15 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
-#ifndef UTILS_H
-#define UTILS_H
+#include "debug.h"
 
-#define ASSERT_NOT_REACHED() \
-  Q_ASSERT_X(false, __FUNCTION__, "should not be reached");
+namespace Folks
+{
 
-#endif // UTILS_H
+Q_LOGGING_CATEGORY(lcEngine, "qtfolks.engine", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcQuery, "qtfolks.query", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcNotify, "qtfolks.notify", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcWrite, "qtfolks.write", QtWarningMsg)
+Q_LOGGING_CATEGORY(lcAvatar, "qtfolks.avatar", QtWarningMsg)
+
+} // namespace Folks
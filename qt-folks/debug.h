@@ -19,6 +19,7 @@
 
 #include <QObject>
 #include <QDebug>
+#include <QLoggingCategory>
 
 #ifndef DEBUG_H
 #define DEBUG_H
@@ -26,17 +27,25 @@
 namespace Folks
 {
 
-// FIXME: Make Debug do something only if debugging is enabled.
-inline QDebug debug()
-{
-    return qDebug();
-}
-
-inline bool debugEnabled()
-{
-    return true;
-}
+// By default every category only logs warnings. Debug messages are turned
+// on with logging rules, e.g. QT_LOGGING_RULES="qtfolks.query.debug=true".
+// A message to a disabled category costs one check, its arguments are
+// never evaluated.
+Q_DECLARE_LOGGING_CATEGORY(lcEngine)
+Q_DECLARE_LOGGING_CATEGORY(lcQuery)
+Q_DECLARE_LOGGING_CATEGORY(lcNotify)
+Q_DECLARE_LOGGING_CATEGORY(lcWrite)
+Q_DECLARE_LOGGING_CATEGORY(lcAvatar)
 
 } // namespace Folks
 
+// Messages logged per contact or per call, far too many to leave in a
+// release build. Unless the ENABLE_TRACE CMake option is set they are
+// compiled out completely.
+#ifdef QTFOLKS_TRACE
+#define FOLKS_TRACE(category) qCDebug(category)
+#else
+#define FOLKS_TRACE(category) while(false) QMessageLogger().noDebug()
+#endif
+
 #endif // DEBUG_H
@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QFile>
+#include <QUrl>
+#include "individualreader.h"
+
+namespace Folks
+{
+
+IndividualData IndividualReader::read(FolksIndividual *individual)
+{
+    IndividualData data;
+
+    data.id = folks_individual_get_id(individual);
+    data.names = names(individual);
+    data.presence = presence(individual);
+    data.avatar = avatar(individual);
+    data.birthday = birthday(individual);
+    data.emailAddresses = emailAddresses(individual);
+    data.imAddresses = imAddresses(individual);
+    data.isFavourite = isFavourite(individual);
+    data.gender = gender(individual);
+    data.notes = notes(individual);
+    data.roles = roles(individual);
+    data.phoneNumbers = phoneNumbers(individual);
+    data.postalAddresses = postalAddresses(individual);
+    data.urls = urls(individual);
+    data.stores = stores(individual);
+
+    return data;
+}
+
+QList<QByteArray> IndividualReader::types(FolksAbstractFieldDetails *details)
+{
+    QList<QByteArray> types;
+
+    // FIXME: check what to do with other parameters
+    GeeCollection *values =
+        folks_abstract_field_details_get_parameter_values(details, "type");
+    if(values == NULL)
+        return types;
+
+    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(values));
+    while(gee_iterator_next(iter)) {
+        char *type = (char*) gee_iterator_get(iter);
+        QByteArray value(type);
+        if(!types.contains(value))
+            types << value;
+        g_free(type);
+    }
+    g_object_unref(iter);
+    g_object_unref(values);
+
+    return types;
+}
+
+QList<FieldData> IndividualReader::stringFields(GeeSet *fields)
+{
+    QList<FieldData> data;
+
+    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(fields));
+    while(gee_iterator_next(iter)) {
+        FolksAbstractFieldDetails *fd =
+            FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iter));
+
+        FieldData field;
+        field.value = (const char*) folks_abstract_field_details_get_value(fd);
+        field.types = types(fd);
+        data << field;
+
+        g_object_unref(fd);
+    }
+    g_object_unref(iter);
+
+    return data;
+}
+
+NameData IndividualReader::names(FolksIndividual *individual)
+{
+    NameData names;
+    names.fullName = folks_name_details_get_full_name(
+            FOLKS_NAME_DETAILS(individual));
+    names.nickname = folks_name_details_get_nickname(
+            FOLKS_NAME_DETAILS(individual));
+    names.alias = folks_alias_details_get_alias(
+            FOLKS_ALIAS_DETAILS(individual));
+
+    return names;
+}
+
+QContactPresence::PresenceState IndividualReader::presenceState(
+        FolksPresenceType type)
+{
+    switch(type) {
+    case FOLKS_PRESENCE_TYPE_OFFLINE:
+        return QContactPresence::PresenceOffline;
+    case FOLKS_PRESENCE_TYPE_AVAILABLE:
+        return QContactPresence::PresenceAvailable;
+    case FOLKS_PRESENCE_TYPE_AWAY:
+        return QContactPresence::PresenceAway;
+    case FOLKS_PRESENCE_TYPE_EXTENDED_AWAY:
+        return QContactPresence::PresenceExtendedAway;
+    case FOLKS_PRESENCE_TYPE_HIDDEN:
+        return QContactPresence::PresenceHidden;
+    case FOLKS_PRESENCE_TYPE_BUSY:
+        return QContactPresence::PresenceBusy;
+    case FOLKS_PRESENCE_TYPE_UNSET:
+        // This should not happen as we don't set any presence in this
+        // case
+    case FOLKS_PRESENCE_TYPE_UNKNOWN:
+    case FOLKS_PRESENCE_TYPE_ERROR:
+    default:
+        return QContactPresence::PresenceUnknown;
+    }
+}
+
+PresenceData IndividualReader::presence(gpointer folk)
+{
+    Q_ASSERT(FOLKS_IS_PRESENCE_DETAILS(folk));
+
+    PresenceData presence;
+
+    FolksPresenceType type = folks_presence_details_get_presence_type(
+            FOLKS_PRESENCE_DETAILS(folk));
+    if(type == FOLKS_PRESENCE_TYPE_UNSET)
+        return presence;
+
+    presence.isSet = true;
+    presence.state = presenceState(type);
+    presence.message = folks_presence_details_get_presence_message(
+            FOLKS_PRESENCE_DETAILS(folk));
+    if(FOLKS_IS_ALIAS_DETAILS(folk))
+        presence.alias =
+            folks_alias_details_get_alias(FOLKS_ALIAS_DETAILS(folk));
+
+    return presence;
+}
+
+AvatarData IndividualReader::avatar(FolksIndividual *individual)
+{
+    AvatarData avatar;
+
+    GLoadableIcon *avatarIcon = folks_avatar_details_get_avatar(
+            FOLKS_AVATAR_DETAILS(individual));
+    if(!avatarIcon)
+        return avatar;
+
+    gchar *uri;
+    if(G_IS_FILE_ICON(avatarIcon)) {
+        GFile *avatarFile = g_file_icon_get_file(G_FILE_ICON(avatarIcon));
+        uri = g_file_get_uri(avatarFile);
+        avatar.uri = uri;
+    } else {
+        FolksAvatarCache *cache = folks_avatar_cache_dup();
+        uri = folks_avatar_cache_build_uri_for_avatar(cache,
+                folks_individual_get_id(individual));
+        avatar.uri = uri;
+        avatar.needsCaching = !QFile::exists(
+                QUrl(QString::fromUtf8(uri)).toLocalFile());
+        g_object_unref(cache);
+    }
+    g_free(uri);
+
+    return avatar;
+}
+
+QDateTime IndividualReader::birthday(FolksIndividual *individual)
+{
+    QDateTime dt;
+
+    GDateTime *folksBirthday = folks_birthday_details_get_birthday(
+            FOLKS_BIRTHDAY_DETAILS(individual));
+    if(folksBirthday != NULL)
+        dt.setTime_t(g_date_time_to_unix(folksBirthday));
+
+    return dt;
+}
+
+QList<FieldData> IndividualReader::emailAddresses(FolksIndividual *individual)
+{
+    return stringFields(folks_email_details_get_email_addresses(
+                FOLKS_EMAIL_DETAILS(individual)));
+}
+
+QList<ImAddressData> IndividualReader::imAddresses(gpointer folk)
+{
+    QList<ImAddressData> data;
+
+    GeeMultiMap *addresses = folks_im_details_get_im_addresses(
+            FOLKS_IM_DETAILS(folk));
+    if(addresses == NULL)
+        return data;
+
+    GeeSet *keys = gee_multi_map_get_keys(addresses);
+    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(keys));
+
+    while(gee_iterator_next(iter)) {
+        gchar *key = (gchar*) gee_iterator_get(iter);
+
+        GeeCollection *values = gee_multi_map_get(addresses, key);
+        GeeIterator *iterValues = gee_iterable_iterator(GEE_ITERABLE(values));
+        while(gee_iterator_next(iterValues)) {
+            FolksAbstractFieldDetails *fd =
+                FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iterValues));
+
+            ImAddressData address;
+            address.protocol = key;
+            address.uri = (const char*) folks_abstract_field_details_get_value(fd);
+            address.types = types(fd);
+            data << address;
+
+            g_object_unref(fd);
+        }
+        g_object_unref(iterValues);
+        g_object_unref(values);
+        g_free(key);
+    }
+    g_object_unref(iter);
+    g_object_unref(keys);
+
+    return data;
+}
+
+bool IndividualReader::isFavourite(FolksIndividual *individual)
+{
+    return folks_favourite_details_get_is_favourite(
+            FOLKS_FAVOURITE_DETAILS(individual));
+}
+
+QContactGender::GenderField IndividualReader::gender(
+        FolksIndividual *individual)
+{
+    switch(folks_gender_details_get_gender(FOLKS_GENDER_DETAILS(individual))) {
+    case FOLKS_GENDER_FEMALE:
+        return QContactGender::GenderFemale;
+    case FOLKS_GENDER_MALE:
+        return QContactGender::GenderMale;
+    default:
+        return QContactGender::GenderUnspecified;
+    }
+}
+
+QList<FieldData> IndividualReader::notes(FolksIndividual *individual)
+{
+    return stringFields(folks_note_details_get_notes(
+                FOLKS_NOTE_DETAILS(individual)));
+}
+
+QList<RoleData> IndividualReader::roles(FolksIndividual *individual)
+{
+    QList<RoleData> data;
+
+    GeeSet *roles = folks_role_details_get_roles(FOLKS_ROLE_DETAILS(individual));
+    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(roles));
+
+    while(gee_iterator_next(iter)) {
+        FolksAbstractFieldDetails *fd =
+            FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iter));
+        FolksRole *role =
+            FOLKS_ROLE(folks_abstract_field_details_get_value(fd));
+
+        RoleData roleData;
+        roleData.organisation = folks_role_get_organisation_name(role);
+        roleData.title = folks_role_get_title(role);
+        roleData.types = types(fd);
+        data << roleData;
+
+        g_object_unref(fd);
+    }
+    g_object_unref(iter);
+
+    return data;
+}
+
+QList<FieldData> IndividualReader::phoneNumbers(FolksIndividual *individual)
+{
+    return stringFields(folks_phone_details_get_phone_numbers(
+                FOLKS_PHONE_DETAILS(individual)));
+}
+
+QList<PostalAddressData> IndividualReader::postalAddresses(
+        FolksIndividual *individual)
+{
+    QList<PostalAddressData> data;
+
+    GeeSet *addresses = folks_postal_address_details_get_postal_addresses(
+            FOLKS_POSTAL_ADDRESS_DETAILS(individual));
+    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(addresses));
+
+    while(gee_iterator_next(iter)) {
+        FolksAbstractFieldDetails *fd =
+            FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iter));
+        FolksPostalAddress *addr = FOLKS_POSTAL_ADDRESS(
+                folks_abstract_field_details_get_value(fd));
+
+        PostalAddressData address;
+        address.poBox = folks_postal_address_get_po_box(addr);
+        address.street = folks_postal_address_get_street(addr);
+        address.locality = folks_postal_address_get_locality(addr);
+        address.region = folks_postal_address_get_region(addr);
+        address.postcode = folks_postal_address_get_postal_code(addr);
+        address.country = folks_postal_address_get_country(addr);
+        address.types = types(fd);
+        data << address;
+
+        g_object_unref(fd);
+    }
+    g_object_unref(iter);
+
+    return data;
+}
+
+QList<FieldData> IndividualReader::urls(FolksIndividual *individual)
+{
+    return stringFields(folks_url_details_get_urls(
+                FOLKS_URL_DETAILS(individual)));
+}
+
+QList<PersonaStoreData> IndividualReader::stores(FolksIndividual *individual)
+{
+    QList<PersonaStoreData> stores;
+
+    GeeSet *personas = folks_individual_get_personas(individual);
+    if(personas == NULL)
+        return stores;
+
+    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(personas));
+    while(gee_iterator_next(iter)) {
+        FolksPersona *persona = FOLKS_PERSONA(gee_iterator_get(iter));
+        FolksPersonaStore *personaStore = folks_persona_get_store(persona);
+        if(personaStore) {
+            PersonaStoreData store;
+            store.typeId = folks_persona_store_get_type_id(personaStore);
+            store.id = folks_persona_store_get_id(personaStore);
+            store.displayName =
+                folks_persona_store_get_display_name(personaStore);
+
+            bool known = false;
+            foreach(const PersonaStoreData &other, stores) {
+                if(other.typeId == store.typeId && other.id == store.id) {
+                    known = true;
+                    break;
+                }
+            }
+            if(!known)
+                stores << store;
+        }
+        g_object_unref(persona);
+    }
+    g_object_unref(iter);
+
+    return stores;
+}
+
+bool IndividualReader::hasPresence(FolksPersona *persona)
+{
+    return FOLKS_IS_PRESENCE_DETAILS(persona);
+}
+
+PersonaData IndividualReader::persona(FolksPersona *persona)
+{
+    Q_ASSERT(hasPresence(persona));
+
+    PersonaData data;
+    data.uid = folks_persona_get_uid(persona);
+    data.displayId = folks_persona_get_display_id(persona);
+    data.presence = presence(persona);
+
+    // The protocol of the IM address the persona stands for, falling back
+    // to the backend name (e.g. "telepathy" or "dummy")
+    if(FOLKS_IS_IM_DETAILS(persona)) {
+        foreach(const ImAddressData &address, imAddresses(persona)) {
+            if(data.protocol.isEmpty() || address.uri == data.displayId)
+                data.protocol = address.protocol;
+        }
+    }
+    if(data.protocol.isEmpty() && folks_persona_get_store(persona))
+        data.protocol = folks_persona_store_get_type_id(
+                folks_persona_get_store(persona));
+
+    return data;
+}
+
+} // namespace Folks
@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "glib-utils.h"
+#include "contactbuilder.h"
+
+#define protected _protected
+#include <folks/folks.h>
+#undef protected
+
+#ifndef INDIVIDUAL_READER_H
+#define INDIVIDUAL_READER_H
+
+namespace Folks
+{
+
+// Copies the properties of Folks objects into the plain structures from
+// contactbuilder.h.
+//
+// These read GObject properties, so they must only be called from the thread
+// running the GLib main loop.
+class IndividualReader
+{
+public:
+    static IndividualData read(FolksIndividual *individual);
+
+    static NameData names(FolksIndividual *individual);
+    // folk can be a FolksIndividual or a FolksPersona
+    static PresenceData presence(gpointer folk);
+    static AvatarData avatar(FolksIndividual *individual);
+    static QDateTime birthday(FolksIndividual *individual);
+    static QList<FieldData> emailAddresses(FolksIndividual *individual);
+    // folk can be a FolksIndividual or a FolksPersona
+    static QList<ImAddressData> imAddresses(gpointer folk);
+    static bool isFavourite(FolksIndividual *individual);
+    static QContactGender::GenderField gender(FolksIndividual *individual);
+    static QList<FieldData> notes(FolksIndividual *individual);
+    static QList<RoleData> roles(FolksIndividual *individual);
+    static QList<FieldData> phoneNumbers(FolksIndividual *individual);
+    static QList<PostalAddressData> postalAddresses(
+            FolksIndividual *individual);
+    static QList<FieldData> urls(FolksIndividual *individual);
+    static QList<PersonaStoreData> stores(FolksIndividual *individual);
+
+    // Whether persona has a presence of its own, see PersonaData
+    static bool hasPresence(FolksPersona *persona);
+    static PersonaData persona(FolksPersona *persona);
+
+    static QContactPresence::PresenceState presenceState(
+            FolksPresenceType type);
+
+private:
+    static QList<QByteArray> types(FolksAbstractFieldDetails *details);
+    static QList<FieldData> stringFields(GeeSet *fields);
+};
+
+} // namespace Folks
+
+#endif // INDIVIDUAL_READER_H
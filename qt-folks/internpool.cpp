@@ -0,0 +1,42 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "internpool.h"
+
+namespace Folks
+{
+
+QString InternPool::string(const QString &value)
+{
+    static Pool<QString> pool(StringLimit);
+    return pool.intern(value, qHash(value));
+}
+
+QList<int> InternPool::intList(const QList<int> &value)
+{
+    static Pool<QList<int> > pool;
+    return pool.intern(value, qHashRange(value.constBegin(), value.constEnd()));
+}
+
+QContactCollectionId InternPool::collectionId(const QContactCollectionId &value)
+{
+    static Pool<QContactCollectionId> pool;
+    return pool.intern(value, qHash(value));
+}
+
+} // namespace Folks
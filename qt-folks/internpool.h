@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef INTERN_POOL_H
+#define INTERN_POOL_H
+
+#include <QContactCollectionId>
+#include <QHash>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include "metrics.h"
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+// Deduplicates the values that tens of thousands of contacts have in
+// common: context and sub-type lists, type strings, presence messages, the
+// aggregate collection id. Every contact then shares one implicitly shared
+// copy of each, instead of holding its own.
+//
+// Lists and collection ids come from small vocabularies and are kept
+// forever. Strings are presence messages, which users make up freely, so
+// only the StringLimit most recently used ones are kept: that is enough to
+// share "Away" or "In a meeting" and a long-running process doesn't
+// collect every message it ever saw.
+// All functions can be called from any thread, conversion workers included.
+class InternPool
+{
+public:
+    enum { StringLimit = 1024 };
+
+    static QString string(const QString &value);
+    static QList<int> intList(const QList<int> &value);
+    static QContactCollectionId collectionId(const QContactCollectionId &value);
+
+private:
+    // With a limit the values live in two generations: once the current
+    // one is full it replaces the previous one, and values found in the
+    // previous one move back into the current one. Values nobody asked for
+    // during a whole generation are dropped.
+    template<typename T>
+    class Pool
+    {
+    public:
+        explicit Pool(int limit = 0)
+            : m_limit(limit) {}
+
+        T intern(const T &value, uint hash)
+        {
+            {
+                QReadLocker locker(&m_lock);
+                const T *found = find(m_values, value, hash);
+                if(found) {
+                    Metrics::increment(Metrics::CacheHits);
+                    return *found;
+                }
+            }
+
+            QWriteLocker locker(&m_lock);
+            // Someone else may have added it in the meantime
+            const T *found = find(m_values, value, hash);
+            if(found)
+                return *found;
+
+            T interned = value;
+            found = find(m_previous, value, hash);
+            if(found) {
+                Metrics::increment(Metrics::CacheHits);
+                interned = *found;
+            } else {
+                Metrics::increment(Metrics::CacheMisses);
+            }
+
+            if(m_limit && m_values.size() >= m_limit) {
+                m_previous.swap(m_values);
+                m_values.clear();
+            }
+            m_values.insert(hash, interned);
+            return interned;
+        }
+
+    private:
+        typedef QMultiHash<uint, T> Values;
+
+        static const T *find(const Values &values, const T &value, uint hash)
+        {
+            typename Values::const_iterator it = values.constFind(hash);
+            for(; it != values.constEnd() && it.key() == hash; ++it) {
+                if(it.value() == value)
+                    return &it.value();
+            }
+            return 0;
+        }
+
+        const int m_limit;
+        QReadWriteLock m_lock;
+        Values m_values;
+        Values m_previous;
+    };
+};
+
+} // namespace Folks
+
+#endif // INTERN_POOL_H
@@ -19,7 +19,17 @@
  */
 
 #include <folks/folks.h>
-#include <QFile>
+#include <QCoreApplication>
+#include <QDBusConnectionInterface>
+#include <QDBusPendingCallWatcher>
+#include <QDBusPendingReply>
+#include <QDBusReply>
+#include <QDBusUnixFileDescriptor>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QRunnable>
+#include <QtConcurrentMap>
+#include <unistd.h>
 #include <QContactAddress>
 #include <QContactAvatar>
 #include <QContactBirthday>
@@ -38,71 +48,143 @@
 #include <QContactIntersectionFilter>
 #include <QContactDetailFilter>
 #include <QContactCollectionFilter>
+#include <QContactFetchRequest>
+#include <QContactFetchByIdRequest>
+#include <QContactIdFetchRequest>
 #include "managerengine.h"
+#include "contactbuilder.h"
+#include "contactquery.h"
 #include "debug.h"
+#include "individualreader.h"
 #include "utils.h"
+#include "utf8.h"
+
+#include <algorithm>
 
 QTCONTACTS_USE_NAMESPACE
 
 namespace
 {
 
-static void setFieldDetailsFromContexts(FolksAbstractFieldDetails *details,
-                                        const QString &parameter,
-                                        const QStringList &contexts)
+// Carries the result of a read request run on the engine's thread pool back
+// to the engine's thread.
+class RequestFinishedEvent : public QEvent
 {
-    Q_FOREACH (const QString &value, contexts) {
-        folks_abstract_field_details_add_parameter (details,
-                                                    parameter.toUtf8().data(),
-                                                    value.toUtf8().data());
+public:
+    RequestFinishedEvent(const std::function<void()> &finish)
+        : QEvent(eventType())
+        , m_finish(finish) {}
+
+    static QEvent::Type eventType()
+    {
+        static const QEvent::Type type =
+            static_cast<QEvent::Type>(QEvent::registerEventType());
+        return type;
     }
-}
 
-static void setFieldDetailsFromContexts(FolksAbstractFieldDetails *details,
-                                        const QContactDetail &contactDetail)
-{
-    setFieldDetailsFromContexts(details, "type", Utils::contextsFromEnums(contactDetail.contexts()));
-}
+    void finish() const { m_finish(); }
 
-static QStringList contextsFromFieldDetails(QContactDetail &contactDetail,
-                                        FolksAbstractFieldDetails *details)
+private:
+    std::function<void()> m_finish;
+};
+
+class ReadRequestRunnable : public QRunnable
 {
-    GeeMultiMap *map = folks_abstract_field_details_get_parameters (details);
-    GeeSet *keys = gee_multi_map_get_keys (map);
-    GeeIterator *siter = gee_iterable_iterator (GEE_ITERABLE (keys));
+public:
+    ReadRequestRunnable(QObject *receiver,
+            const std::function<std::function<void()>()> &work)
+        : m_receiver(receiver)
+        , m_work(work) {}
 
-    QStringList contexts;
+    void run() override
+    {
+        QCoreApplication::postEvent(m_receiver,
+                new RequestFinishedEvent(m_work()));
+    }
 
-    while (gee_iterator_next (siter)) {
-        char *parameter = (char*) gee_iterator_get (siter);
-        if (QString(parameter) != "type") {
-            // FIXME: check what to do with other parameters
-            continue;
-        }
+private:
+    QObject *m_receiver;
+    std::function<std::function<void()>()> m_work;
+};
+
+using Folks::ContactEntry;
 
-        GeeCollection *args = folks_abstract_field_details_get_parameter_values(
-                details, parameter);
+// Sorting case-insensitively by display label only needs the sort keys
+// computed when the contacts were converted
+static bool canUseSortKeys(const QList<QContactSortOrder> &sortOrders)
+{
+    if (sortOrders.size() != 1)
+        return false;
+
+    const QContactSortOrder &order = sortOrders.first();
+    return order.detailType() == QContactDisplayLabel::Type
+        && order.detailField() == QContactDisplayLabel::FieldLabel
+        && order.caseSensitivity() == Qt::CaseInsensitive;
+}
 
-        GeeIterator *iter = gee_iterable_iterator (GEE_ITERABLE (args));
+// A contact which matched a filter, decoded once, with its entry
+typedef QPair<QContact, const ContactEntry *> Match;
 
-        while (gee_iterator_next (iter)) {
-            char *type = (char*) gee_iterator_get (iter);
-            QString context(type);
-            if (!contexts.contains(context)) {
-                contexts << type;
+static void sortMatches(QVector<Match> *matches,
+                        const QList<QContactSortOrder> &sortOrders)
+{
+    if (sortOrders.isEmpty())
+        return;
+
+    // Same ordering as QContactManagerEngine::addSorted(), without its
+    // quadratic insertion. compareContact() compares case-insensitive
+    // strings case-folded and locale-aware, so the keys are compared the
+    // same way; a plain compare would order accented letters differently.
+    if (canUseSortKeys(sortOrders)) {
+        const QContactSortOrder &order = sortOrders.first();
+        const bool blanksFirst =
+            order.blankPolicy() == QContactSortOrder::BlanksFirst;
+        const bool descending = order.direction() == Qt::DescendingOrder;
+
+        std::stable_sort(matches->begin(), matches->end(),
+                         [=](const Match &a, const Match &b) {
+            const QString &aKey = a.second->sortKey;
+            const QString &bKey = b.second->sortKey;
+            if (aKey.isEmpty() || bKey.isEmpty()) {
+                if (aKey.isEmpty() == bKey.isEmpty())
+                    return false;
+                return aKey.isEmpty() == blanksFirst;
             }
-            g_free (type);
-        }
+            const int result = aKey.localeAwareCompare(bKey);
+            return descending ? result > 0 : result < 0;
+        });
+        return;
     }
-    return contexts;
 
+    std::stable_sort(matches->begin(), matches->end(),
+                     [&sortOrders](const Match &a, const Match &b) {
+        return QContactManagerEngine::compareContact(a.first, b.first,
+                                                     sortOrders) < 0;
+    });
 }
 
-static void setContextsFromFieldDetails(QContactDetail &contactDetail,
-                                        FolksAbstractFieldDetails *details)
+static QList<const char *> contextNames(const QList<int> &contexts)
 {
-    QStringList contexts = contextsFromFieldDetails(contactDetail, details);
-    contactDetail.setContexts(Utils::contextsFromStrings(contexts));
+    QList<const char *> names;
+    Utils::contextsFromEnums(contexts, &names);
+    return names;
+}
+
+static void setFieldDetailsFromContexts(FolksAbstractFieldDetails *details,
+                                        const char *parameter,
+                                        const QList<const char *> &contexts)
+{
+    Q_FOREACH (const char *value, contexts) {
+        folks_abstract_field_details_add_parameter (details,
+                                                    parameter,
+                                                    value);
+    }
+}
+
+static void setFieldDetailsFromContexts(FolksAbstractFieldDetails *details,
+                                        const QContactDetail &contactDetail)
+{
+    setFieldDetailsFromContexts(details, "type", contextNames(contactDetail.contexts()));
 }
 
 } //namespace
@@ -204,7 +286,7 @@ void addressDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userd
         folks_postal_address_details_change_postal_addresses_finish(postalDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
     FolksPersona *persona = FOLKS_PERSONA(detail);
@@ -223,7 +305,7 @@ void addressDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userd
             QString formattedUri = avatarUri.toString(QUrl::RemoveUserInfo);
             if(!formattedUri.isEmpty()) {
                 GFile *avatarFile =
-                    g_file_new_for_uri(formattedUri.toUtf8().data());
+                    g_file_new_for_uri(Utf8(formattedUri).data());
                 avatarFileIcon = G_FILE_ICON(g_file_icon_new(avatarFile));
 
                 gObjectClear((GObject**) &avatarFile);
@@ -247,7 +329,7 @@ void avatarDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userda
         folks_avatar_details_change_avatar_finish(avatarDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -284,7 +366,7 @@ void birthdayDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer user
         folks_birthday_details_change_birthday_finish(birthdayDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -304,7 +386,7 @@ void birthdayDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer user
             GDateTime *dateTime = g_date_time_new_from_unix_utc(
                     birthday.dateTime().toMSecsSinceEpoch() / 1000);
             folks_birthday_details_change_calendar_event_id(birthdayDetails,
-                    birthday.calendarId().toUtf8().data(), calendarEventIdDetailChangeCb, data);
+                    Utf8(birthday.calendarId()).data(), calendarEventIdDetailChangeCb, data);
             g_date_time_unref(dateTime);
         }
     }
@@ -322,7 +404,7 @@ void calendarEventIdDetailChangeCb(GObject *detail, GAsyncResult *result, gpoint
         folks_birthday_details_change_birthday_finish(birthdayDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -353,7 +435,7 @@ void favoriteDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer user
         folks_favourite_details_change_is_favourite_finish(favoriteDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -370,7 +452,7 @@ void favoriteDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer user
         QContactDisplayLabel displayLabel = data->contact.detail<QContactDisplayLabel>();
         if (!displayLabel.label().isEmpty()) {
             updated = true;
-            folks_name_details_change_full_name(nameDetails, displayLabel.label().toUtf8().data(), fullNameDetailChangeCb, data);
+            folks_name_details_change_full_name(nameDetails, Utf8(displayLabel.label()).data(), fullNameDetailChangeCb, data);
         }
     }
 
@@ -387,7 +469,7 @@ void fullNameDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer user
         folks_name_details_change_full_name_finish(nameDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -407,7 +489,7 @@ void fullNameDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer user
              * contact-set and alias as user-set (but QtContacts doesn't treat them
              * differently) */
             folks_alias_details_change_alias(alias_details,
-                    displayLabel.label().toUtf8().data(), aliasDetailChangeCb, data);
+                    Utf8(displayLabel.label()).data(), aliasDetailChangeCb, data);
         }
     }
 
@@ -424,7 +506,7 @@ void aliasDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdat
         folks_alias_details_change_alias_finish(aliasDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -441,11 +523,11 @@ void aliasDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdat
         QContactName name = data->contact.detail<QContactName>();
         if(!name.isEmpty()) {
             sn = folks_structured_name_new(
-                    name.lastName().toUtf8().data(),
-                    name.firstName().toUtf8().data(),
-                    name.middleName().toUtf8().data(),
-                    name.prefix().toUtf8().data(),
-                    name.suffix().toUtf8().data());
+                    Utf8(name.lastName()).data(),
+                    Utf8(name.firstName()).data(),
+                    Utf8(name.middleName()).data(),
+                    Utf8(name.prefix()).data(),
+                    Utf8(name.suffix()).data());
         }
 
         folks_name_details_change_structured_name(nameDetails, sn, structuredNameDetailChangeCb, data);
@@ -463,7 +545,7 @@ void structuredNameDetailChangeCb(GObject *detail, GAsyncResult *result, gpointe
         folks_name_details_change_structured_name_finish(nameDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -483,7 +565,7 @@ void structuredNameDetailChangeCb(GObject *detail, GAsyncResult *result, gpointe
             if(!note.isEmpty()) {
                 FolksAbstractFieldDetails *fieldDetails =
                     FOLKS_ABSTRACT_FIELD_DETAILS (folks_note_field_details_new(
-                        note.note().toUtf8().data(), NULL, NULL));
+                        Utf8(note.note()).data(), NULL, NULL));
                 setFieldDetailsFromContexts (fieldDetails, note);
                 gee_collection_add(GEE_COLLECTION(noteSet), fieldDetails);
                 g_object_unref(fieldDetails);
@@ -506,7 +588,7 @@ void noteDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata
         folks_note_details_change_notes_finish(noteDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -527,10 +609,11 @@ void noteDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata
             if(!number.isEmpty()) {
                 FolksAbstractFieldDetails *fieldDetails =
                     FOLKS_ABSTRACT_FIELD_DETAILS (folks_phone_field_details_new(
-                        number.number().toUtf8().data(), NULL));
+                        Utf8(number.number()).data(), NULL));
 
-                QStringList contexts = Utils::contextsFromEnums(number.contexts());
-                contexts << Utils::phoneSubTypesFromEnums(number.subTypes());
+                QList<const char *> contexts;
+                Utils::contextsFromEnums(number.contexts(), &contexts);
+                Utils::phoneSubTypesFromEnums(number.subTypes(), &contexts);
                 setFieldDetailsFromContexts(fieldDetails, "type", contexts);
 
                 gee_collection_add(GEE_COLLECTION(numberSet), fieldDetails);
@@ -564,7 +647,7 @@ void phoneNumberDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer u
         folks_phone_details_change_phone_numbers_finish(phoneDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -615,14 +698,15 @@ GeeMultiMap *imAddressHash =
                     if(!accountUri.isEmpty()) {
                         FolksImFieldDetails *imfd =
                             folks_im_field_details_new (
-                                    accountUri.toUtf8().data(), NULL);
+                                    Utf8(accountUri).data(), NULL);
 
-                        QStringList contexts = Utils::contextsFromEnums(account.contexts());
-                        contexts << Utils::onlineAccountSubTypesFromEnums(account.subTypes());
+                        QList<const char *> contexts;
+                        Utils::contextsFromEnums(account.contexts(), &contexts);
+                        Utils::onlineAccountSubTypesFromEnums(account.subTypes(), &contexts);
                         setFieldDetailsFromContexts(FOLKS_ABSTRACT_FIELD_DETAILS (imfd), "type", contexts);
 
                         gee_multi_map_set(imAddressHash,
-                                Utils::onlineAccountProtocolFromEnum(account.protocol()).toUtf8().data(),
+                                Utils::onlineAccountProtocolFromEnum(account.protocol()),
                                 imfd);
 
                         g_object_unref(imfd);
@@ -647,7 +731,7 @@ void imDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata)
         folks_im_details_change_im_addresses_finish(imDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -668,14 +752,13 @@ void imDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata)
             if(!org.isEmpty()) {
 
 
-                // The role values can not be NULL
-                const gchar* title = org.title().toUtf8().data();
-                const gchar* name = org.name().toUtf8().data();
-                const gchar* roleName = org.role().toUtf8().data();
+                // The role values can not be NULL, Utf8 never is
+                const Utf8 title(org.title());
+                const Utf8 name(org.name());
+                const Utf8 roleName(org.role());
 
-                FolksRole *role = folks_role_new(title ? title : "",
-                        name ? name : "", "");
-                folks_role_set_role (role, roleName ? roleName : "");
+                FolksRole *role = folks_role_new(title.data(), name.data(), "");
+                folks_role_set_role (role, roleName.data());
 
                 FolksRoleFieldDetails *fieldDetails = folks_role_field_details_new(
                         role, NULL);
@@ -704,7 +787,7 @@ void roleDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata
         folks_role_details_change_roles_finish(roleDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -723,7 +806,7 @@ void roleDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata
             if(!url.isEmpty()) {
                 FolksAbstractFieldDetails *fieldDetails =
                     FOLKS_ABSTRACT_FIELD_DETAILS (folks_url_field_details_new(
-                        url.url().toUtf8().data(), NULL));
+                        Utf8(url.url()).data(), NULL));
                 gee_collection_add(GEE_COLLECTION(urlSet), fieldDetails);
                 setFieldDetailsFromContexts (fieldDetails, url);
                 g_object_unref(fieldDetails);
@@ -746,7 +829,7 @@ void urlDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata)
         folks_url_details_change_urls_finish(urlDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -766,7 +849,7 @@ void urlDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata)
             if(!address.isEmpty()) {
                 FolksAbstractFieldDetails *fieldDetails =
                     FOLKS_ABSTRACT_FIELD_DETAILS (folks_email_field_details_new(
-                        address.emailAddress().toUtf8().data(), NULL));
+                        Utf8(address.emailAddress()).data(), NULL));
                 setFieldDetailsFromContexts (fieldDetails, address);
                 gee_collection_add(GEE_COLLECTION(addressSet), fieldDetails);
             }
@@ -788,7 +871,7 @@ void emailDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdat
         folks_email_details_change_email_addresses_finish(emailDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -823,7 +906,7 @@ void genderDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userda
         folks_gender_details_change_gender_finish(genderDetails, result, &error);
 
         if (error) {
-            qDebug() << "ERROR:" << error->message;
+            qCWarning(lcWrite) << "ERROR:" << error->message;
         }
     }
 
@@ -833,7 +916,7 @@ void genderDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userda
     // Flush the store.
     FolksPersonaStore *primaryStore = data->store;
     if(primaryStore == NULL) {
-        qWarning() << "Cannot save Contact changes: Failed determine primary "
+        qCWarning(lcWrite) << "Cannot save Contact changes: Failed determine primary "
             "data store";
     } else {
         folks_persona_store_flush(
@@ -841,6 +924,8 @@ void genderDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userda
                 0, 0);
     }
 
+    Metrics::record(Metrics::SaveLatency, data->timer.nsecsElapsed() / 1000);
+
     gObjectClear((GObject**) &persona);
     delete data;
 }
@@ -848,8 +933,30 @@ void genderDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userda
 ManagerEngine::ManagerEngine(
         const QMap<QString, QString>& parameters,
         QContactManager::Error* error)
-{
-        qWarning() << "contacts new engine creating";
+    : m_aggregator(0)
+    , m_service(0)
+    , m_sharedSnapshotSource(0)
+    , m_sharedDeltaRecords(0)
+    , m_clientMode(false)
+    , m_remoteSelfKey(0)
+    , m_sharedGeneration(0)
+    , m_initialIndividualsAdded(false)
+    , m_flushSource(0)
+{
+    qCDebug(lcEngine) << "Creating engine";
+
+    m_notifier = new ContactNotifier(false,
+            parameters.value(QStringLiteral("batchSignal")) == QLatin1String("true"));
+
+    if(parameters.value(QStringLiteral("client")) == QLatin1String("true")) {
+        if(startClient()) {
+            qCDebug(lcEngine) << "Engine ready with" << m_remoteIds.size()
+                << "contacts from" << ContactService::serviceName();
+            return;
+        }
+
+        qCWarning(lcEngine) << "No primary engine running, aggregating contacts in this process";
+    }
 
     m_aggregator = folks_individual_aggregator_dup();
     C_CONNECT(m_aggregator, "individuals-changed", individualsChangedCb);
@@ -858,188 +965,607 @@ ManagerEngine::ManagerEngine(
             (GAsyncReadyCallback) STATIC_C_HANDLER_NAME(aggregatorPrepareCb),
             this);
 
-  m_notifier = new ContactNotifier(false);
-          /*      notifier->connect("collectionsAdded", "au", this, SLOT(_q_collectionsAdded(QVector<quint32>)));
-                notifier->connect("collectionsChanged", "au", this, SLOT(_q_collectionsChanged(QVector<quint32>)));
-                notifier->connect("collectionsRemoved", "au", this, SLOT(_q_collectionsRemoved(QVector<quint32>)));
-                notifier->connect("collectionContactsChanged", "au", this, SLOT(_q_collectionContactsChanged(QVector<quint32>)));
-
-                notifier->connect("contactsAdded", "au", this, SLOT(_q_contactsAdded(QVector<quint32>)));
-                notifier->connect("contactsChanged", "au", this, SLOT(_q_contactsChanged(QVector<quint32>)));
-                notifier->connect("contactsPresenceChanged", "au", this, SLOT(_q_contactsPresenceChanged(QVector<quint32>)));
-                notifier->connect("contactsRemoved", "au", this, SLOT(_q_contactsRemoved(QVector<quint32>)));
-                notifier->connect("selfContactIdChanged", "uu", this, SLOT(_q_selfContactIdChanged(quint32,quint32)));
-                notifier->connect("relationshipsAdded", "au", this, SLOT(_q_relationshipsAdded(QVector<quint32>)));
-                notifier->connect("relationshipsRemoved", "au", this, SLOT(_q_relationshipsRemoved(QVector<quint32>)));
-                notifier->connect("displayLabelGroupsChanged", "", this, SLOT(_q_displayLabelGroupsChanged()));
-*/
-
   while (!m_initialIndividualsAdded)
     g_main_context_iteration (g_main_context_default(), TRUE);
 
-        qWarning() << "contacts new engine creation finished";
+    // Only serve the contacts once they are all there
+    m_service = new ContactService(&m_store, this);
+    m_store.setCollectChanges(true);
+    writeSharedSnapshot();
+    m_notifier->exportObject("contacts", m_service);
+    // Clients have nothing of their own to measure
+    m_notifier->exportObject("metrics", new MetricsService(this));
+    m_notifier->claimName(ContactService::serviceName());
+
+    qCDebug(lcEngine) << "Engine ready with" << m_allContacts.size() << "contacts";
 }
 
 ManagerEngine::~ManagerEngine()
 {
+    // Read requests still in flight hold a pointer to us
+    m_readPool.waitForDone();
+
+    if(m_flushSource)
+        g_source_remove(m_flushSource);
+    if(m_sharedSnapshotSource)
+        g_source_remove(m_sharedSnapshotSource);
+
+    delete m_notifier;
+
     gObjectClear((GObject**) &m_aggregator);
 }
 
+void ManagerEngine::commitContact(const ContactPair& pair)
+{
+    m_store.insert(pair.contact, ContactBuilder::sortKey(pair.contact));
+
+    // Folks notifies one property at a time, so the snapshot is only
+    // swapped once for all of them
+    const QContactId id = pair.contact.id();
+    if(m_pendingChangedIds.contains(id))
+        Metrics::increment(Metrics::NotificationsSuppressed);
+    m_pendingChangedIds.insert(id);
+    scheduleFlush();
+}
+
 void ManagerEngine::aggregatorPrepareCb()
 {
-qWarning("contacts aggregator has prepared");
+    qCDebug(lcEngine) << "Aggregator prepared";
 
 //  if (error)
   //  g_warning ("Failed to load Folks contacts: %s", error->message);
 }
 
-void ManagerEngine::updateDisplayLabelFromIndividual(
-        QContact &contact,
-        FolksIndividual *individual)
+bool ManagerEngine::startClient()
 {
-    const char *displayLabel = folks_name_details_get_nickname(
-            FOLKS_NAME_DETAILS(individual));
-    if(!displayLabel || displayLabel[0] == '\0') {
-        displayLabel = folks_alias_details_get_alias(
-                FOLKS_ALIAS_DETAILS(individual));
+    QDBusConnection connection = m_notifier->connection();
+    if(!connection.isConnected())
+        return false;
+
+    // Any process can take the well-known name, so only a primary of our
+    // own user is trusted, and only the process checked is talked to
+    const QDBusReply<QString> owner =
+        connection.interface()->serviceOwner(ContactService::serviceName());
+    if(!owner.isValid())
+        return false;
+
+    const QDBusReply<uint> uid = connection.interface()->serviceUid(owner.value());
+    if(!uid.isValid() || uid.value() != getuid()) {
+        qCWarning(lcEngine) << "Ignoring" << ContactService::serviceName()
+            << "of another user";
+        return false;
+    }
+
+    const QString service = owner.value();
+    m_remoteService = service;
+
+    if(mapRemoteSnapshot())
+        return true;
+
+    // Subscribe before reading the snapshot: changes the primary makes in
+    // the meantime are delivered after the reply
+    m_notifier->connect("contactsAdded", "au", this, SLOT(_q_contactsAdded(QVector<quint32>)), service);
+    m_notifier->connect("contactsChanged", "au", this, SLOT(_q_contactsChanged(QVector<quint32>)), service);
+    m_notifier->connect("contactsPresenceChanged", "au", this, SLOT(_q_contactsPresenceChanged(QVector<quint32>)), service);
+    m_notifier->connect("contactsRemoved", "au", this, SLOT(_q_contactsRemoved(QVector<quint32>)), service);
+    m_notifier->connect("contactsBatchChanged", "auauauau", this,
+            SLOT(_q_contactsBatchChanged(QVector<quint32>,QVector<quint32>,QVector<quint32>,QVector<quint32>)), service);
+    m_notifier->connect("selfContactIdChanged", "uu", this, SLOT(_q_selfContactIdChanged(quint32,quint32)), service);
+/*
+    m_notifier->connect("collectionsAdded", "au", this, SLOT(_q_collectionsAdded(QVector<quint32>)), service);
+    m_notifier->connect("collectionsChanged", "au", this, SLOT(_q_collectionsChanged(QVector<quint32>)), service);
+    m_notifier->connect("collectionsRemoved", "au", this, SLOT(_q_collectionsRemoved(QVector<quint32>)), service);
+    m_notifier->connect("collectionContactsChanged", "au", this, SLOT(_q_collectionContactsChanged(QVector<quint32>)), service);
+    m_notifier->connect("relationshipsAdded", "au", this, SLOT(_q_relationshipsAdded(QVector<quint32>)), service);
+    m_notifier->connect("relationshipsRemoved", "au", this, SLOT(_q_relationshipsRemoved(QVector<quint32>)), service);
+    m_notifier->connect("displayLabelGroupsChanged", "", this, SLOT(_q_displayLabelGroupsChanged()), service);
+*/
+
+    // All pages are requested at once and read as they come in, so that
+    // no single reply has to hold the whole store
+    QList<QDBusPendingCall> pages;
+    for(int page = 0; page < ContactService::PageCount; ++page) {
+        QDBusMessage call = QDBusMessage::createMethodCall(service,
+                ContactNotifier::objectPath("contacts"),
+                ContactService::interfaceName(), QStringLiteral("Snapshot"));
+        call << uint(page);
+        pages << connection.asyncCall(call);
+    }
+
+    ServedContacts served;
+    foreach(const QDBusPendingCall &page, pages) {
+        QDBusPendingReply<QByteArray> reply = page;
+        reply.waitForFinished();
+        if(reply.isError() ||
+                !ContactService::decode(reply.value(), managerUri(), &served)) {
+            qCWarning(lcEngine) << "Failed to read the contacts of" << service
+                << reply.error().message();
+            return false;
+        }
+    }
+
+    m_clientMode = true;
+    m_remoteSelfKey = served.selfContactKey;
+    applyRemoteContacts(served, QList<QContactDetail::DetailType>());
 
-        if(!displayLabel || displayLabel[0] == '\0') {
+    return true;
+}
+
+bool ManagerEngine::mapRemoteSnapshot()
+{
+    QDBusConnection connection = m_notifier->connection();
+    if(!(connection.connectionCapabilities() &
+                QDBusConnection::UnixFileDescriptorPassing))
+        return false;
+
+    const QString service = m_remoteService;
+    m_notifier->connect("snapshotChanged", "t", this, SLOT(_q_snapshotChanged(quint64)), service);
+
+    QDBusMessage call = QDBusMessage::createMethodCall(service,
+            ContactNotifier::objectPath("contacts"),
+            ContactService::interfaceName(), QStringLiteral("SnapshotFiles"));
+    call << quint64(0);
+    const QDBusReply<QList<QDBusUnixFileDescriptor> > reply = connection.call(call);
+    if(!reply.isValid() || reply.value().isEmpty())
+        return false;
+
+    QList<SharedSnapshotPtr> segments;
+    foreach(const QDBusUnixFileDescriptor &file, reply.value()) {
+        const SharedSnapshotPtr segment =
+            SharedSnapshot::map(file.fileDescriptor(), managerUri());
+        if(!segment)
+            return false;
+        segments << segment;
+    }
+
+    m_clientMode = true;
+    return applySharedSegments(segments);
+}
+
+void ManagerEngine::_q_snapshotChanged(quint64 generation)
+{
+    if(!m_sharedGeneration || generation <= m_sharedGeneration)
+        return;
+
+    requestSharedSegments(m_sharedGeneration);
+}
+
+void ManagerEngine::requestSharedSegments(quint64 since)
+{
+    QDBusMessage call = QDBusMessage::createMethodCall(
+            m_remoteService, ContactNotifier::objectPath("contacts"),
+            ContactService::interfaceName(), QStringLiteral("SnapshotFiles"));
+    call << since;
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+            m_notifier->connection().asyncCall(call), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this](QDBusPendingCallWatcher *finished) {
+        const QDBusPendingReply<QList<QDBusUnixFileDescriptor> > reply = *finished;
+        finished->deleteLater();
+        if(reply.isError()) {
+            qCWarning(lcEngine) << "Failed to get the shared snapshot:"
+                << reply.error().message();
             return;
         }
+
+        QList<SharedSnapshotPtr> segments;
+        foreach(const QDBusUnixFileDescriptor &file, reply.value()) {
+            const SharedSnapshotPtr segment =
+                SharedSnapshot::map(file.fileDescriptor(), managerUri());
+            if(!segment)
+                return;
+            segments << segment;
+        }
+
+        // The primary dropped the segments we would need to catch up
+        if(!applySharedSegments(segments))
+            requestSharedSegments(0);
+    });
+}
+
+bool ManagerEngine::applySharedSegments(const QList<SharedSnapshotPtr> &segments)
+{
+    // Announcements can overtake each other's replies
+    if(segments.isEmpty() || segments.last()->generation() <= m_sharedGeneration)
+        return true;
+
+    QSet<QContactId> addedIds;
+    QSet<QContactId> changedIds;
+    QSet<QContactId> removedIds;
+    // Only the final state of a contact counts, whichever segments it
+    // changed in
+    auto inserted = [&](const QContactId &id, bool existed) {
+        if(removedIds.remove(id) || (existed && !addedIds.contains(id)))
+            changedIds.insert(id);
+        else if(!existed)
+            addedIds.insert(id);
+    };
+    auto removed = [&](const QContactId &id) {
+        changedIds.remove(id);
+        if(!addedIds.remove(id))
+            removedIds.insert(id);
+    };
+
+    foreach(const SharedSnapshotPtr &segment, segments) {
+        if(segment->baseGeneration()) {
+            if(segment->generation() <= m_sharedGeneration)
+                continue;
+            if(segment->baseGeneration() != m_sharedGeneration)
+                return false;
+            applySharedDelta(segment, inserted, removed);
+        } else {
+            applySharedBase(segment, inserted, removed);
+        }
+        m_sharedGeneration = segment->generation();
     }
 
-    QContactDisplayLabel displayLabelDetail;
-    if (!contact.details<QContactDisplayLabel>().isEmpty()) {
-        displayLabelDetail = contact.detail<QContactDisplayLabel>();
+    const SharedSnapshotPtr last = segments.last();
+    m_remoteSelfKey = last->selfContactKey();
+    m_remoteSelfId = last->selfContactId();
+
+    publish();
+    notifyCollectionChanges();
+
+    Metrics::increment(Metrics::IndividualsRemoved, removedIds.size());
+    Metrics::increment(Metrics::IndividualsAdded, addedIds.size());
+    Metrics::increment(Metrics::IndividualsChanged, changedIds.size());
+
+    if(!removedIds.isEmpty())
+        emit contactsRemoved(removedIds.toList());
+    if(!addedIds.isEmpty())
+        emit contactsAdded(addedIds.toList());
+    if(!changedIds.isEmpty())
+        emit contactsChanged(changedIds.toList(), QList<QContactDetail::DetailType>());
+
+    updateRemoteSelfContact();
+
+    return true;
+}
+
+void ManagerEngine::applySharedBase(
+        const SharedSnapshotPtr &base,
+        const std::function<void(const QContactId &, bool)> &inserted,
+        const std::function<void(const QContactId &)> &removed)
+{
+    // Records which didn't change are only pointed at the new segment, so
+    // that the old ones can go away, without decoding anything. Only the
+    // first segment applied can be a base, so the published snapshot still
+    // holds the records to compare with.
+    const ContactSnapshotPtr snapshot = m_store.snapshot();
+    QMultiHash<quint32, QContactId> remoteIds;
+    remoteIds.reserve(base->count());
+    for(int i = 0; i < base->count(); ++i) {
+        const QContactId id(managerUri(), base->localId(i));
+        remoteIds.insert(base->key(i), id);
+
+        const ContactEntry *old = snapshot->find(id);
+        if(old && old->shared && old->shared->hash(old->record) == base->hash(i)) {
+            m_store.rebind(id, base, i);
+            continue;
+        }
+
+        m_store.insertShared(base, i);
+        inserted(id, old != 0);
     }
 
-    displayLabelDetail.setLabel(QString::fromUtf8(displayLabel));
-    contact.saveDetail(&displayLabelDetail);
+    for(QHash<quint32, QContactId>::const_iterator it = m_remoteIds.constBegin();
+            it != m_remoteIds.constEnd(); ++it) {
+        if(remoteIds.contains(it.key(), it.value()))
+            continue;
+
+        m_store.remove(it.value());
+        removed(it.value());
+    }
+
+    m_remoteIds = remoteIds;
 }
 
-void ManagerEngine::updateAliasFromIndividual(
-        QContact &contact,
-        FolksIndividual *individual)
+void ManagerEngine::applySharedDelta(
+        const SharedSnapshotPtr &delta,
+        const std::function<void(const QContactId &, bool)> &inserted,
+        const std::function<void(const QContactId &)> &removed)
 {
-    updateDisplayLabelFromIndividual(contact, individual);
+    // Every other contact stays bound to the segment it was in
+    foreach(const SharedSnapshot::RecordKey &key, delta->removed()) {
+        const QContactId id(managerUri(), key.second);
+        if(!m_remoteIds.contains(key.first, id))
+            continue;
+
+        m_store.remove(id);
+        m_remoteIds.remove(key.first, id);
+        removed(id);
+    }
+
+    for(int i = 0; i < delta->count(); ++i) {
+        const quint32 key = delta->key(i);
+        const QContactId id(managerUri(), delta->localId(i));
+        const bool existed = m_remoteIds.contains(key, id);
+        if(!existed)
+            m_remoteIds.insert(key, id);
+
+        m_store.insertShared(delta, i);
+        inserted(id, existed);
+    }
 }
 
-void ManagerEngine::updateNameFromIndividual(
-        QContact &contact,
-        FolksIndividual *individual)
+void ManagerEngine::publish()
 {
-    FolksStructuredName *sn = folks_name_details_get_structured_name(
-            FOLKS_NAME_DETAILS(individual));
-    const char *fullName = folks_name_details_get_full_name(
-            FOLKS_NAME_DETAILS(individual));
+    m_store.publish();
 
-    removeOldDetails<QContactName>(contact);
+    if(m_service && !m_sharedSnapshotSource)
+        m_sharedSnapshotSource = g_timeout_add(SharedSnapshot::WriteInterval,
+                writeSharedSnapshotCb, this);
+}
 
-    if(sn || fullName) {
-        QContactName name;
+gboolean ManagerEngine::writeSharedSnapshotCb(gpointer userData)
+{
+    ManagerEngine *this_ = static_cast<ManagerEngine *>(userData);
+    this_->m_sharedSnapshotSource = 0;
+    this_->writeSharedSnapshot();
 
-        if(fullName) {
-            QContactDisplayLabel displayLabelDetail;
-            if (!contact.details<QContactDisplayLabel>().isEmpty()) {
-                displayLabelDetail = contact.detail<QContactDisplayLabel>();
-            }
-            displayLabelDetail.setLabel(QString::fromUtf8(fullName));
-            contact.saveDetail(&displayLabelDetail);
-        }
-
-        // yay, gnome-contacts only sets the structured name once on contact creation,
-        // then never updates it (instead only updating the full name)
-        // until that's fixed, let's always go with the full name as QContactName
-        if(fullName) {
-            QStringList names = QString::fromUtf8(fullName).split(' ');
-            if (names.length() == 2) {
-                name.setFirstName(names.at(0));
-                name.setLastName(names.at(1));
-            } else {
-                name.setFirstName(QString::fromUtf8(fullName));
-            }
-            contact.saveDetail(&name);
+    return G_SOURCE_REMOVE;
+}
+
+void ManagerEngine::writeSharedSnapshot()
+{
+    const ContactSnapshotPtr snapshot = m_store.snapshot();
+    m_sharedChanges.unite(m_store.takePublishedChanges());
+    if(snapshot->generation() == m_service->snapshotGeneration())
+        return;
+
+    // Deltas only carry what changed since the segment before. Once they
+    // add up to as many records as the store holds, a base is written
+    // again, so that clients can drop the segments they no longer need.
+    quint64 baseGeneration = m_service->snapshotGeneration();
+    if(m_service->snapshotSegments() >= SharedSnapshot::MaxSegments ||
+            m_sharedDeltaRecords + m_sharedChanges.size() > snapshot->count())
+        baseGeneration = 0;
+
+    const int fd = SharedSnapshot::write(*snapshot, baseGeneration, m_sharedChanges);
+    if(fd < 0)
+        return;
+
+    m_sharedDeltaRecords = baseGeneration ? m_sharedDeltaRecords + m_sharedChanges.size() : 0;
+    m_sharedChanges.clear();
+    m_service->addSnapshotSegment(fd, baseGeneration, snapshot->generation());
+    // Sends the contact changes it contains first
+    m_notifier->snapshotChanged(snapshot->generation());
+}
+
+void ManagerEngine::fetchRemoteContacts(
+        const QVector<quint32> &keys,
+        const QList<QContactDetail::DetailType> &typesChanged,
+        bool keysRemoved)
+{
+    if(!m_clientMode || keys.isEmpty())
+        return;
+
+    QDBusMessage call = QDBusMessage::createMethodCall(
+            m_remoteService, ContactNotifier::objectPath("contacts"),
+            ContactService::interfaceName(), QStringLiteral("Fetch"));
+    call.setArguments(QVariantList() << QVariant::fromValue(keys));
+
+    // Replies and signals come in over the same connection, so a contact
+    // removed after this call is only removed after the reply is applied
+    QDBusPendingCallWatcher *watcher = new QDBusPendingCallWatcher(
+            m_notifier->connection().asyncCall(call), this);
+    connect(watcher, &QDBusPendingCallWatcher::finished, this,
+            [this, keys, typesChanged, keysRemoved](QDBusPendingCallWatcher *finished) {
+        const QDBusPendingReply<QByteArray> reply = *finished;
+        finished->deleteLater();
+
+        ServedContacts served;
+        if(reply.isError() ||
+                !ContactService::decode(reply.value(), managerUri(), &served)) {
+            qCWarning(lcEngine) << "Failed to fetch contacts from"
+                << ContactService::serviceName() << reply.error().message();
+            return;
         }
-        /*
-        if(sn) {
-            name.setFirstName(QString::fromUtf8(folks_structured_name_get_given_name(sn)));
-            name.setLastName(QString::fromUtf8(folks_structured_name_get_family_name(sn)));
-            name.setMiddleName(QString::fromUtf8(folks_structured_name_get_additional_names(sn)));
-            name.setPrefix(QString::fromUtf8(folks_structured_name_get_prefixes(sn)));
-            name.setSuffix(QString::fromUtf8(folks_structured_name_get_suffixes(sn)));
-            contact.saveDetail(&name);
+
+        applyRemoteContacts(served, typesChanged,
+                keysRemoved ? keys : QVector<quint32>());
+    });
+}
+
+void ManagerEngine::applyRemoteContacts(
+        const ServedContacts &served,
+        const QList<QContactDetail::DetailType> &typesChanged,
+        const QVector<quint32> &removedKeys)
+{
+    QList<QContactId> addedIds;
+    QList<QContactId> changedIds;
+    QList<QContactId> removedIds;
+
+    QSet<QContactId> servedIds;
+    foreach(const ServedContact &remote, served.contacts) {
+        const QContactId id = remote.contact.id();
+        servedIds.insert(id);
+        if(m_remoteIds.contains(remote.key, id)) {
+            changedIds << id;
+        } else {
+            addedIds << id;
+            m_remoteIds.insert(remote.key, id);
         }
-        */
+
+        m_store.insert(remote.contact, ContactBuilder::sortKey(remote.contact));
+        m_store.setCollections(id, remote.collections);
     }
+
+    // The primary serves every contact of a key it still has
+    foreach(quint32 key, removedKeys) {
+        foreach(const QContactId &id, m_remoteIds.values(key)) {
+            if(servedIds.contains(id))
+                continue;
+
+            m_remoteIds.remove(key, id);
+            m_store.remove(id);
+            removedIds << id;
+        }
+    }
+
+    m_remoteSelfId = served.selfContactId;
+
+    publish();
+    notifyCollectionChanges();
+
+    Metrics::increment(Metrics::IndividualsRemoved, removedIds.size());
+    Metrics::increment(Metrics::IndividualsAdded, addedIds.size());
+    Metrics::increment(Metrics::IndividualsChanged, changedIds.size());
+
+    if(!removedIds.isEmpty())
+        emit contactsRemoved(removedIds);
+    if(!addedIds.isEmpty())
+        emit contactsAdded(addedIds);
+    if(!changedIds.isEmpty())
+        emit contactsChanged(changedIds, typesChanged);
+
+    // The self contact may have been waiting for its contact to arrive
+    updateRemoteSelfContact();
 }
 
-void ManagerEngine::updateStructuredNameFromIndividual(
+void ManagerEngine::updateRemoteSelfContact()
+{
+    const QContactId oldSelfContactId = m_selfContactId;
+    const QList<QContactId> ids = m_remoteIds.values(m_remoteSelfKey);
+    if(ids.contains(m_remoteSelfId))
+        m_selfContactId = m_remoteSelfId;
+    else if(ids.size() == 1)
+        m_selfContactId = ids.first();
+    else
+        m_selfContactId = QContactId();
+    if(m_selfContactId == oldSelfContactId)
+        return;
+
+    m_store.setSelfContactId(m_selfContactId);
+    publish();
+    notifySelfContactChange(oldSelfContactId);
+}
+
+void ManagerEngine::_q_contactsAdded(const QVector<quint32> &contactIds)
+{
+    fetchRemoteContacts(contactIds, QList<QContactDetail::DetailType>());
+}
+
+void ManagerEngine::_q_contactsChanged(const QVector<quint32> &contactIds)
+{
+    fetchRemoteContacts(contactIds, QList<QContactDetail::DetailType>());
+}
+
+void ManagerEngine::_q_contactsPresenceChanged(
+        const QVector<quint32> &contactIds)
+{
+    fetchRemoteContacts(contactIds, QList<QContactDetail::DetailType>()
+            << QContactGlobalPresence::Type);
+}
+
+void ManagerEngine::_q_contactsRemoved(const QVector<quint32> &contactIds)
+{
+    if(!m_clientMode)
+        return;
+
+    QList<QContactId> removedIds;
+    QVector<quint32> collidingKeys;
+    foreach(quint32 key, contactIds) {
+        const QList<QContactId> ids = m_remoteIds.values(key);
+        if(ids.size() > 1) {
+            // Only the primary knows which of them is gone
+            collidingKeys << key;
+            continue;
+        }
+        if(ids.isEmpty())
+            continue;
+
+        m_remoteIds.remove(key);
+        m_store.remove(ids.first());
+        removedIds << ids.first();
+    }
+
+    fetchRemoteContacts(collidingKeys, QList<QContactDetail::DetailType>(), true);
+
+    if(removedIds.isEmpty())
+        return;
+
+    publish();
+    notifyCollectionChanges();
+
+    Metrics::increment(Metrics::IndividualsRemoved, removedIds.size());
+    emit contactsRemoved(removedIds);
+}
+
+void ManagerEngine::_q_contactsBatchChanged(
+        const QVector<quint32> &addedIds,
+        const QVector<quint32> &changedIds,
+        const QVector<quint32> &presenceChangedIds,
+        const QVector<quint32> &removedIds)
+{
+    // Same order as the separate signals
+    _q_contactsRemoved(removedIds);
+    _q_contactsAdded(addedIds);
+    _q_contactsChanged(changedIds);
+    _q_contactsPresenceChanged(presenceChangedIds);
+}
+
+void ManagerEngine::_q_selfContactIdChanged(quint32 oldId, quint32 newId)
+{
+    Q_UNUSED(oldId);
+
+    if(!m_clientMode)
+        return;
+
+    m_remoteSelfKey = newId;
+    updateRemoteSelfContact();
+
+    // The served contacts say which of several contacts with the key it is
+    if(m_remoteIds.count(newId) > 1)
+        fetchRemoteContacts(QVector<quint32>() << newId,
+                QList<QContactDetail::DetailType>());
+}
+
+void ManagerEngine::updateDisplayLabelFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    updateNameFromIndividual(contact, individual);
+    ContactBuilder::setDisplayLabel(contact,
+            IndividualReader::names(individual));
 }
 
-void ManagerEngine::updateFullNameFromIndividual(
+void ManagerEngine::updateAliasFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    updateNameFromIndividual(contact, individual);
+    updateDisplayLabelFromIndividual(contact, individual);
 }
 
-void ManagerEngine::updateNicknameFromIndividual(
+void ManagerEngine::updateNameFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactNickname>(contact);
-
-    const char *nickname = folks_name_details_get_nickname(
-            FOLKS_NAME_DETAILS(individual));
-    if(nickname && nickname[0] != '\0') {
-        QContactNickname detail;
-        detail.setNickname(QString::fromUtf8(nickname));
-        contact.saveDetail(&detail);
-    }
+    NameData names = IndividualReader::names(individual);
+    ContactBuilder::setDisplayLabel(contact, names);
+    ContactBuilder::setName(contact, names);
 }
 
-void ManagerEngine::updatePresenceFromIndividual(
+void ManagerEngine::updateStructuredNameFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactGlobalPresence>(contact);
-
-    QContactGlobalPresence presence;
-    if(setPresenceDetail(presence, individual))
-        contact.saveDetail(&presence);
+    updateNameFromIndividual(contact, individual);
 }
 
-QContactPresence ManagerEngine::getPresenceForPersona(
-        QContact& contact,
-        FolksPersona *persona)
+void ManagerEngine::updateFullNameFromIndividual(
+        QContact &contact,
+        FolksIndividual *individual)
 {
-/*
-    if(TPF_IS_PERSONA(persona)) {
-        QString presenceUri = getPersonaPresenceUri(persona);
-        foreach(const QContactPresence& presence,
-                contact.details<QContactPresence>()) {
-            if(presence.detailUri() == presenceUri)
-                return presence;
-        }
-    }
-*/
-    return QContactPresence();
+    updateNameFromIndividual(contact, individual);
 }
 
-void ManagerEngine::updatePresenceFromPersona(
-        QContact& contact,
-        FolksIndividual *individual,
-        FolksPersona *persona)
+void ManagerEngine::updateNicknameFromIndividual(
+        QContact &contact,
+        FolksIndividual *individual)
 {
-    QContactPresence presence = getPresenceForPersona(contact, persona);
-    if(!presence.isEmpty()) {
-        if(setPresenceDetail(presence, persona))
-            contact.saveDetail(&presence);
-    }
+    NameData names = IndividualReader::names(individual);
+    ContactBuilder::setDisplayLabel(contact, names);
+    ContactBuilder::setNickname(contact, names);
 }
 
 void ManagerEngine::avatarReadyCB(GObject *source, GAsyncResult *res, gpointer user_data)
@@ -1051,319 +1577,119 @@ void ManagerEngine::avatarReadyCB(GObject *source, GAsyncResult *res, gpointer u
         QContactAvatar avatar;
         avatar.setImageUrl(data->url);
         pair.contact.saveDetail(&avatar);
-        debug() << "AvatarImage (UPDATE):" << data->url;
-    // TODO: also emit the detail types..
-        emit data->this_->contactsChanged(QList<QContactId>() << data->contactId, QList<QContactDetail::DetailType>());
+        data->this_->commitContact(pair);
+        FOLKS_TRACE(lcAvatar) << "Cached avatar" << data->url;
     }
 
-    g_free(data);
+    delete data;
+}
+
+void ManagerEngine::cacheAvatar(
+        FolksIndividual *individual,
+        const QContactId &contactId,
+        const QByteArray &uri)
+{
+    GLoadableIcon *avatarIcon = folks_avatar_details_get_avatar(
+            FOLKS_AVATAR_DETAILS(individual));
+    if(!avatarIcon)
+        return;
+
+    AvatarLoadData *data = new AvatarLoadData;
+    data->url = QUrl(QString::fromUtf8(uri));
+    data->contactId = contactId;
+    data->this_ = this;
+
+    FolksAvatarCache *cache = folks_avatar_cache_dup();
+    folks_avatar_cache_store_avatar(cache, folks_individual_get_id(individual),
+            avatarIcon, ManagerEngine::avatarReadyCB, data);
+    g_object_unref(cache);
 }
 
 void ManagerEngine::updateAvatarFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactAvatar>(contact);
-    GLoadableIcon *avatarIcon = folks_avatar_details_get_avatar(
-            FOLKS_AVATAR_DETAILS(individual));
-    if(avatarIcon) {
-        gchar *uri;
-        if(G_IS_FILE_ICON(avatarIcon)) {
-            GFile *avatarFile = g_file_icon_get_file(G_FILE_ICON(avatarIcon));
-            uri = g_file_get_uri(avatarFile);
-
-            QContactAvatar avatar;
-            avatar.setImageUrl(QUrl(QLatin1String(uri)));
-            contact.saveDetail(&avatar);
-            g_free(uri);
-        } else {
-            FolksAvatarCache *cache = folks_avatar_cache_dup();
-            const char *contactId = folks_individual_get_id(individual);
-            uri = folks_avatar_cache_build_uri_for_avatar(cache, contactId);
-            QUrl url = QUrl(QLatin1String(uri));
-            if (QFile::exists(url.toLocalFile())) {
-                QContactAvatar avatar;
-                avatar.setImageUrl(url);
-                contact.saveDetail(&avatar);
-            } else {
-                AvatarLoadData *data = new AvatarLoadData;
-                data->url = url;
-                data->contactId = contact.id();
-                data->this_ = this;
-                folks_avatar_cache_store_avatar(cache, contactId, avatarIcon, ManagerEngine::avatarReadyCB, data);
-            }
-            g_free(uri);
-        }
-    }
+    AvatarData avatar = IndividualReader::avatar(individual);
+    ContactBuilder::setAvatar(contact, avatar);
+    if(avatar.needsCaching)
+        cacheAvatar(individual, contact.id(), avatar.uri);
 }
 
 void ManagerEngine::updateBirthdayFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactBirthday>(contact);
-
-    FolksBirthdayDetails *birthday_details = FOLKS_BIRTHDAY_DETAILS(individual);
-    GDateTime *folks_birthday = folks_birthday_details_get_birthday(
-            birthday_details);
-    if(folks_birthday != NULL) {
-        QContactBirthday birthday;
-        QDateTime dt;
-        dt.setTime_t(g_date_time_to_unix(folks_birthday));
-        birthday.setDateTime(dt);
-        contact.saveDetail(&birthday);
-    }
+    ContactBuilder::setBirthday(contact,
+            IndividualReader::birthday(individual));
 }
 
 void ManagerEngine::updateEmailAddressesFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactEmailAddress>(contact);
-
-    GeeSet *addresses =
-        folks_email_details_get_email_addresses(
-                FOLKS_EMAIL_DETAILS(individual));
-    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(addresses));
-
-    while(gee_iterator_next(iter)) {
-        FolksEmailFieldDetails *email_fd =
-            FOLKS_EMAIL_FIELD_DETAILS(gee_iterator_get(iter));
-        QContactEmailAddress addr;
-        addr.setEmailAddress(
-                QString::fromUtf8(
-                    (const char*) folks_abstract_field_details_get_value(
-                        FOLKS_ABSTRACT_FIELD_DETAILS(email_fd))));
-        setContextsFromFieldDetails(addr,
-                FOLKS_ABSTRACT_FIELD_DETAILS(email_fd));
-        contact.saveDetail(&addr);
-        g_object_unref(email_fd);
-    }
-    g_object_unref (iter);
+    ContactBuilder::setEmailAddresses(contact,
+            IndividualReader::emailAddresses(individual));
 }
 
 void ManagerEngine::updateImAddressesFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactOnlineAccount>(contact);
-
-    GeeMultiMap *address =
-        folks_im_details_get_im_addresses (
-                FOLKS_IM_DETAILS(individual));
-    GeeSet *keys = gee_multi_map_get_keys (address);
-    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(keys));
-
-    while(gee_iterator_next(iter)) {
-        const gchar *key = (const gchar*) gee_iterator_get(iter);
-
-        GeeCollection *values = gee_multi_map_get(address, key);
-        GeeIterator *iterValues = gee_iterable_iterator(GEE_ITERABLE(values));
-        while(gee_iterator_next(iterValues)) {
-            QContactOnlineAccount addr;
-            FolksAbstractFieldDetails *fd =
-                FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iterValues));
-
-            addr.setAccountUri(QString::fromUtf8(
-                    (const char*) folks_abstract_field_details_get_value(fd)));
-            addr.setProtocol(Utils::onlineAccountProtocolFromString(QString::fromUtf8(key)));
-
-            // Set Im type and contexts
-            QStringList contexts = contextsFromFieldDetails(addr, FOLKS_ABSTRACT_FIELD_DETAILS(fd));
-            addr.setContexts(Utils::contextsFromStrings(contexts));
-            addr.setSubTypes(Utils::onlineAccountSubTypesFromStrings(contexts));
-
-            g_object_unref(fd);
-
-            contact.saveDetail(&addr);
-        }
-        g_object_unref (iterValues);
-    }
-    g_object_unref (iter);
-
+    ContactBuilder::setImAddresses(contact,
+            IndividualReader::imAddresses(individual));
 }
 
 void ManagerEngine::updateFavoriteFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactFavorite>(contact);
-
-    QContactFavorite favorite;
-    favorite.setFavorite(folks_favourite_details_get_is_favourite(
-                FOLKS_FAVOURITE_DETAILS(individual)));
-
-    contact.saveDetail(&favorite);
+    ContactBuilder::setFavorite(contact,
+            IndividualReader::isFavourite(individual));
 }
 
 void ManagerEngine::updateGenderFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactGender>(contact);
-
-    QContactGender gender;
-    switch(folks_gender_details_get_gender(FOLKS_GENDER_DETAILS(individual))) {
-    case FOLKS_GENDER_FEMALE:
-        gender.setGender(QContactGender::GenderFemale);
-        break;
-    case FOLKS_GENDER_MALE:
-        gender.setGender(QContactGender::GenderMale);
-        break;
-    default:
-        // What's the difference between not having this field or having it
-        // set to GenderUnspecified? Let's just not save the detail at all.
-        return;
-    }
-
-    setContextsFromFieldDetails(gender,
-            FOLKS_ABSTRACT_FIELD_DETAILS(individual));
-    contact.saveDetail(&gender);
+    ContactBuilder::setGender(contact, IndividualReader::gender(individual));
 }
 
 void ManagerEngine::updateNotesFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactNote>(contact);
-
-    FolksNoteDetails *note_details = FOLKS_NOTE_DETAILS(individual);
-    GeeSet *notes = folks_note_details_get_notes(note_details);
-    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(notes));
-
-    while(gee_iterator_next(iter)) {
-        FolksAbstractFieldDetails *fd =
-            FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iter));
-        QContactNote note;
-        note.setNote(
-                QString::fromUtf8(
-                    (const char*) folks_abstract_field_details_get_value(fd)));
-        setContextsFromFieldDetails(note, fd);
-        contact.saveDetail(&note);
-
-        g_object_unref(fd);
-    }
+    ContactBuilder::setNotes(contact, IndividualReader::notes(individual));
 }
 
 void ManagerEngine::updateOrganizationFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactOrganization>(contact);
-
-    FolksRoleDetails *role_details = FOLKS_ROLE_DETAILS(individual);
-    GeeSet *roles = folks_role_details_get_roles(role_details);
-    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(roles));
-
-    while(gee_iterator_next(iter)) {
-        FolksAbstractFieldDetails *fd =
-            FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iter));
-        FolksRole *role =
-            FOLKS_ROLE(folks_abstract_field_details_get_value(fd));
-
-        QContactOrganization org;
-        org.setName(QString::fromUtf8(folks_role_get_organisation_name(role)));
-        org.setTitle(QString::fromUtf8(folks_role_get_title(role)));
-
-        setContextsFromFieldDetails(org,
-                FOLKS_ABSTRACT_FIELD_DETAILS(fd));
-        contact.saveDetail(&org);
-    }
+    ContactBuilder::setOrganizations(contact,
+            IndividualReader::roles(individual));
 }
 
 void ManagerEngine::updatePhoneNumbersFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactPhoneNumber>(contact);
-
-    GeeSet *numbers =
-        folks_phone_details_get_phone_numbers(FOLKS_PHONE_DETAILS(individual));
-    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(numbers));
-
-    while(gee_iterator_next(iter)) {
-        FolksAbstractFieldDetails *fd =
-            FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iter));
-        QContactPhoneNumber number;
-        number.setNumber(
-                QString::fromUtf8(
-                    (const char*) folks_abstract_field_details_get_value(fd)));
-
-        // Set phone type
-        QStringList contexts = contextsFromFieldDetails(number, fd);
-        number.setContexts(Utils::contextsFromStrings(contexts));
-        number.setSubTypes(Utils::phoneSubTypesFromStrings(contexts));
-
-        contact.saveDetail(&number);
-        g_object_unref(fd);
-    }
-    g_object_unref (iter);
+    ContactBuilder::setPhoneNumbers(contact,
+            IndividualReader::phoneNumbers(individual));
 }
 
 void ManagerEngine::updateAddressesFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactAddress>(contact);
-
-    GeeSet *addresses = folks_postal_address_details_get_postal_addresses(
-            FOLKS_POSTAL_ADDRESS_DETAILS(individual));
-    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(addresses));
-
-    while(gee_iterator_next(iter)) {
-        FolksPostalAddressFieldDetails *addrFd =
-            FOLKS_POSTAL_ADDRESS_FIELD_DETAILS(gee_iterator_get(iter));
-        FolksPostalAddress *addr = FOLKS_POSTAL_ADDRESS(
-                folks_abstract_field_details_get_value (
-                        FOLKS_ABSTRACT_FIELD_DETAILS(addrFd)));
-        QContactAddress address;
-        address.setCountry(
-                QString::fromUtf8(folks_postal_address_get_country(addr)));
-        address.setLocality(
-                QString::fromUtf8(folks_postal_address_get_locality(addr)));
-        address.setPostOfficeBox(
-                QString::fromUtf8(folks_postal_address_get_po_box(addr)));
-        address.setPostcode(
-                QString::fromUtf8(folks_postal_address_get_postal_code(addr)));
-        address.setRegion(
-                QString::fromUtf8(folks_postal_address_get_region(addr)));
-        address.setStreet(
-                QString::fromUtf8(folks_postal_address_get_street(addr)));
-
-        QStringList contexts = contextsFromFieldDetails(address,
-                FOLKS_ABSTRACT_FIELD_DETAILS(addrFd));
-        address.setContexts(Utils::contextsFromStrings(contexts));
-        address.setSubTypes(Utils::addressSubTypesFromStrings(contexts));
-
-        contact.saveDetail(&address);
-
-        g_object_unref(addrFd);
-    }
-    g_object_unref (iter);
+    ContactBuilder::setPostalAddresses(contact,
+            IndividualReader::postalAddresses(individual));
 }
 
 void ManagerEngine::updateUrlsFromIndividual(
         QContact &contact,
         FolksIndividual *individual)
 {
-    removeOldDetails<QContactUrl>(contact);
-
-    GeeSet *urls = folks_url_details_get_urls(FOLKS_URL_DETAILS(individual));
-    GeeIterator *iter = gee_iterable_iterator(GEE_ITERABLE(urls));
-
-    while(gee_iterator_next(iter)) {
-        FolksAbstractFieldDetails *fd =
-            FOLKS_ABSTRACT_FIELD_DETAILS(gee_iterator_get(iter));
-        QContactUrl url;
-        url.setUrl(
-                QString::fromUtf8(
-                    (const char*) folks_abstract_field_details_get_value(fd)));
-        setContextsFromFieldDetails(url, fd);
-        contact.saveDetail(&url);
-
-        g_object_unref(fd);
-    }
-    g_object_unref (iter);
+    ContactBuilder::setUrls(contact, IndividualReader::urls(individual));
 }
 
 void ManagerEngine::updatePersonas(
@@ -1372,154 +1698,120 @@ void ManagerEngine::updatePersonas(
         GeeSet *added,
         GeeSet *removed)
 {
-#define CONNECT_PERSONA_NOTIFY(propertyName) \
-    signalHandlerId = C_NOTIFY_CONNECT(persona, propertyName, \
-            personaPresenceChangedCb); \
-    m_personasSignalHandlerIds.insert( \
-            QPair<FolksIndividual *, FolksPersona *>(individual, persona), \
-            signalHandlerId);
-
     /* this will be used throughout this function */
     GeeIterator *iter;
 
-    iter = gee_iterable_iterator(GEE_ITERABLE(added));
+    iter = gee_iterable_iterator(GEE_ITERABLE(removed));
     while(gee_iterator_next(iter)) {
         FolksPersona *persona = FOLKS_PERSONA(gee_iterator_get(iter));
-#if 0
-        if(TPF_IS_PERSONA(persona)) {
-            m_personasToIndividuals.insertMulti(persona, individual);
-
-            gulong signalHandlerId = 0;
+        const QByteArray uid = folks_persona_get_uid(persona);
 
-            if(FOLKS_IS_PRESENCE_DETAILS(persona)) {
-                CONNECT_PERSONA_NOTIFY("presence-type");
-                CONNECT_PERSONA_NOTIFY("presence-message");
-            }
-
-            if(FOLKS_IS_ALIAS_DETAILS(persona))
-                /* The alias for a single account detail is set in the
-                 * presence too */
-                CONNECT_PERSONA_NOTIFY("alias");
-
-            //addAccountDetails(contact, TPF_PERSONA(persona));
+        if(m_personaSignals.value(individual).contains(QString::fromUtf8(uid))) {
+            disconnectPersona(individual, QString::fromUtf8(uid));
+            ContactBuilder::removePersonaAccount(contact, uid);
         }
-#endif
+
         g_object_unref(persona);
     }
     g_object_unref (iter);
 
-#undef CONNECT_PERSONA_NOTIFY
-
-    iter = gee_iterable_iterator(GEE_ITERABLE(removed));
+    iter = gee_iterable_iterator(GEE_ITERABLE(added));
     while(gee_iterator_next(iter)) {
         FolksPersona *persona = FOLKS_PERSONA(gee_iterator_get(iter));
-#if 0
-        if(TPF_IS_PERSONA(persona)) {
-            // TODO: no need to do this anymore, use the folks id
-            if(m_individualsToIds.contains(individual)) {
-                QContactId contactId = m_individualsToIds[individual];
-                ContactPair& contactPair = m_allContacts[contactId];
-                //removeAccountDetails(contactPair.contact, TPF_PERSONA(persona));
-
-                QPair<FolksIndividual *, FolksPersona *> pair(individual,
-                        persona);
-                gulong signalHandlerId = m_personasSignalHandlerIds[pair];
-                if(signalHandlerId)
-                    g_signal_handler_disconnect(persona, signalHandlerId);
-                m_personasSignalHandlerIds.remove(pair);
-
-                m_personasToIndividuals.remove(persona, individual);
-            }
+
+        // Chat accounts and the like, each one gets an online account with
+        // a presence of its own next to the global presence
+        if(IndividualReader::hasPresence(persona)) {
+            connectPersona(individual, persona);
+            ContactBuilder::setPersonaAccount(contact,
+                    IndividualReader::persona(persona));
         }
-#endif
 
         g_object_unref(persona);
     }
     g_object_unref (iter);
 }
-#if 0
-void ManagerEngine::addAccountDetails(
-        QContact& contact,
-        TpfPersona *persona)
+
+void ManagerEngine::connectPersona(
+        FolksIndividual *individual,
+        FolksPersona *persona)
 {
-    TpfPersonaStore *store = TPF_PERSONA_STORE(
-            folks_persona_get_store(FOLKS_PERSONA(persona)));
-    TpAccount *tpAccount = tpf_persona_store_get_account(store);
-    if(!tpAccount)
+    const QString uid = QString::fromUtf8(folks_persona_get_uid(persona));
+    QHash<QString, PersonaSignals> &personas = m_personaSignals[individual];
+    if(personas.contains(uid))
         return;
 
-    QContactOnlineAccount account;
-    account.setAccountUri(
-            QString::fromUtf8(folks_persona_get_display_id(FOLKS_PERSONA(persona))));
-    // FIXME: detail fields are no longer represented by strings, so this needs to be done
-    // in a different way.
-    /*account.setValue("TelepathyAccountPath",
-            QString::fromUtf8(tp_proxy_get_object_path(TP_PROXY(tpAccount))));*/
+    PersonaSignals personaSignals;
+    personaSignals.persona = FOLKS_PERSONA(g_object_ref(persona));
+    personaSignals.handlerIds
+        << C_NOTIFY_CONNECT(persona, "presence-type", personaPresenceChangedCb)
+        << C_NOTIFY_CONNECT(persona, "presence-message", personaPresenceChangedCb);
+    if(FOLKS_IS_ALIAS_DETAILS(persona))
+        /* The alias for a single account detail is set in the
+         * presence too */
+        personaSignals.handlerIds
+            << C_NOTIFY_CONNECT(persona, "alias", personaPresenceChangedCb);
 
-    QRegExp lettersRegexp(QLatin1String("^[a-z]+$"));
+    personas.insert(uid, personaSignals);
+    m_personasToIndividuals.insert(uid, individual);
+}
 
-    QString protocol = QString::fromUtf8(tp_account_get_protocol(tpAccount));
-    account.setProtocol(Utils::onlineAccountProtocolFromString(protocol));
+void ManagerEngine::disconnectPersona(
+        FolksIndividual *individual,
+        const QString &uid)
+{
+    QHash<QString, PersonaSignals> &personas = m_personaSignals[individual];
+    const PersonaSignals personaSignals = personas.take(uid);
+    if(personas.isEmpty())
+        m_personaSignals.remove(individual);
+    if(!personaSignals.persona)
+        return;
 
-    QList<int> subTypes;
-    if(protocol == QLatin1String("sip"))
-        subTypes << QContactOnlineAccount::SubTypeSip
-                 << QContactOnlineAccount::SubTypeSipVoip;
-    else if(protocol == QLatin1String("jabber"))
-        subTypes << QContactOnlineAccount::SubTypeImpp;
-    account.setSubTypes(subTypes);
+    foreach(gulong handlerId, personaSignals.handlerIds)
+        g_signal_handler_disconnect(personaSignals.persona, handlerId);
+    g_object_unref(personaSignals.persona);
 
-    account.setDetailUri(getPersonaAccountUri(FOLKS_PERSONA(persona)));
+    m_personasToIndividuals.remove(uid, individual);
+}
 
-    // FIXME: We should set the capabilities here, but from what I understood
-    // the current capabilities functions could be deprecated and replaced by
-    // QContactAction and related classes (that don't exist yet in the most
-    // recently released QtContacts).
+// Batches smaller than this are converted on the main thread, handing them to
+// the thread pool would cost more than it saves.
+static const int ParallelConversionThreshold = 64;
 
-    QContactPresence presence;
-    if(setPresenceDetail(presence, persona)) {
-        QString presenceUri = getPersonaPresenceUri(FOLKS_PERSONA(persona));
-        presence.setDetailUri(presenceUri);
-        contact.saveDetail(&presence);
-        account.setLinkedDetailUris(presenceUri);
-    }
+struct ConvertIndividual
+{
+    typedef ConvertedContact result_type;
 
-    contact.saveDetail(&account);
-}
+    ConvertIndividual(const QString &managerUri)
+        : managerUri(managerUri) {}
 
-void ManagerEngine::removeAccountDetails(
-        QContact& contact,
-        TpfPersona *persona)
-{
-    QList<QContactOnlineAccount> accounts =
-        contact.details<QContactOnlineAccount>();
-    QString accountUri = getPersonaAccountUri(FOLKS_PERSONA(persona));
-    foreach(QContactOnlineAccount account, accounts) {
-        if(account.detailUri() == accountUri) {
-            contact.removeDetail(&account);
-            break;
-        }
+    ConvertedContact operator()(const IndividualData &data) const
+    {
+        return ContactBuilder::convert(data, managerUri);
     }
 
-    QContactPresence presence = getPresenceForPersona(contact,
-            FOLKS_PERSONA(persona));
-    if(!presence.isEmpty())
-        contact.removeDetail(&presence);
-}
-#endif
+    QString managerUri;
+};
 
-QString ManagerEngine::getPersonaPresenceUri(
-        FolksPersona *persona)
+// Set QTFOLKS_SERIAL_CONVERSION to convert every batch on the main thread,
+// e.g. to compare start-up times.
+static QVector<ConvertedContact> convertIndividuals(
+        const QVector<IndividualData> &records,
+        const QString &managerUri)
 {
-    return QLatin1String("presence:") +
-        QString::fromUtf8(folks_persona_get_uid(persona));
-}
+    ConvertIndividual convert(managerUri);
 
-QString ManagerEngine::getPersonaAccountUri(
-        FolksPersona *persona)
-{
-    return QLatin1String("account:") +
-        QString::fromUtf8(folks_persona_get_uid(persona));
+    if(records.size() < ParallelConversionThreshold ||
+            qEnvironmentVariableIsSet("QTFOLKS_SERIAL_CONVERSION")) {
+        QVector<ConvertedContact> converted;
+        converted.reserve(records.size());
+        foreach(const IndividualData &data, records)
+            converted << convert(data);
+        return converted;
+    }
+
+    return QtConcurrent::blockingMapped<QVector<ConvertedContact> >(
+            records, convert);
 }
 
 void ManagerEngine::individualsChangedCb(
@@ -1530,9 +1822,9 @@ void ManagerEngine::individualsChangedCb(
         FolksPersona *actor,
         FolksGroupDetailsChangeReason reason)
 {
-qWarning("contacts manager got individualsChangedCb");
     QList<QContactId> removedIds;
     QList<QContactId> addedIds;
+    const QContactId oldSelfContactId = m_selfContactId;
 
     /* this will be used throughout this function */
     GeeIterator *iter;
@@ -1541,35 +1833,74 @@ qWarning("contacts manager got individualsChangedCb");
     while(gee_iterator_next(iter)) {
         FolksIndividual *individual = FOLKS_INDIVIDUAL(gee_iterator_get(iter));
         QContactId id = removeIndividual(individual);
-qWarning("contact got removed id : %s", qPrintable(id.toString()));
         if(!id.isNull())
             removedIds << id;
+        if(id == m_selfContactId)
+            m_selfContactId = QContactId();
 
         g_object_unref(individual);
     }
     g_object_unref (iter);
 
+    // Adding happens in three steps: the Folks properties are copied out on
+    // this thread, the QContacts are built from those copies on the thread
+    // pool and the results are committed here again, all in one go.
+    QElapsedTimer timer;
+    timer.start();
+
+    QVector<FolksIndividual *> individuals;
+    QVector<IndividualData> records;
+
     iter = gee_iterable_iterator(GEE_ITERABLE(added));
     while(gee_iterator_next(iter)) {
         FolksIndividual *individual = FOLKS_INDIVIDUAL(gee_iterator_get(iter));
-        QContactId id = addIndividual(individual);
-qWarning("contact got added id : %s", qPrintable(id.toString()));
-
-        if(!id.isNull())
-            addedIds << id;
 
-        g_object_unref(individual);
+        // Keep the reference until the contact has been committed
+        individuals << individual;
+        records << IndividualReader::read(individual);
     }
     g_object_unref (iter);
 
+    const qint64 readTime = timer.restart();
+    QVector<ConvertedContact> converted =
+        convertIndividuals(records, managerUri());
+    const qint64 convertTime = timer.restart();
+
+    for(int i = 0; i < individuals.size(); ++i) {
+        QContactId id = addIndividual(individuals.at(i), converted.at(i));
+
+        if(records.at(i).avatar.needsCaching)
+            cacheAvatar(individuals.at(i), id, records.at(i).avatar.uri);
+
+        addedIds << id;
+
+        // When Folks re-links the user, the new individual is added in the
+        // same change as the old one is removed
+        if(folks_individual_get_is_user(individuals.at(i)))
+            m_selfContactId = id;
+
+        g_object_unref(individuals.at(i));
+    }
+
+    m_store.setSelfContactId(m_selfContactId);
+    publish();
+    notifyCollectionChanges();
+    notifySelfContactChange(oldSelfContactId);
+
+    Metrics::increment(Metrics::IndividualsRemoved, removedIds.size());
+    Metrics::increment(Metrics::IndividualsAdded, addedIds.size());
+
+    if(!individuals.isEmpty())
+        qCDebug(lcEngine) << "Added" << individuals.size() << "individuals: read"
+            << readTime << "ms, converted" << convertTime << "ms, committed"
+            << timer.elapsed() << "ms";
+
     if(!removedIds.isEmpty()) {
-qWarning("contacts manager emitting contacts removed");
         m_notifier->contactsRemoved(removedIds);
         emit contactsRemoved(removedIds);
 }
 
     if(!addedIds.isEmpty()) {
-qWarning("contacts manager emitting contacts added");
         m_notifier->contactsAdded(addedIds);
         emit contactsAdded(addedIds);
 //        emit dataChanged(); // big hammer
@@ -1578,131 +1909,50 @@ qWarning("contacts manager emitting contacts added");
   m_initialIndividualsAdded = true;
 }
 
-QContactPresence::PresenceState ManagerEngine::folksToQtPresence(
-        FolksPresenceType fp)
-{
-    switch(fp) {
-    case FOLKS_PRESENCE_TYPE_OFFLINE:
-        return QContactPresence::PresenceOffline;
-    case FOLKS_PRESENCE_TYPE_AVAILABLE:
-        return QContactPresence::PresenceAvailable;
-    case FOLKS_PRESENCE_TYPE_AWAY:
-        return QContactPresence::PresenceAway;
-    case FOLKS_PRESENCE_TYPE_EXTENDED_AWAY:
-        return QContactPresence::PresenceExtendedAway;
-    case FOLKS_PRESENCE_TYPE_HIDDEN:
-        return QContactPresence::PresenceHidden;
-    case FOLKS_PRESENCE_TYPE_BUSY:
-        return QContactPresence::PresenceBusy;
-    case FOLKS_PRESENCE_TYPE_UNSET:
-        // This should not happen as we don't set any presence in this
-        // case
-    case FOLKS_PRESENCE_TYPE_UNKNOWN:
-    case FOLKS_PRESENCE_TYPE_ERROR:
-    default:
-        return QContactPresence::PresenceUnknown;
-    }
-}
-QByteArray dbIdToByteArray(quint32 dbId, bool isCollection = false)
-{
-    return isCollection ? (QByteArrayLiteral("col-") + QByteArray::number(dbId))
-                        : (QByteArrayLiteral("sql-") + QByteArray::number(dbId));
-}
-
 QContactId ManagerEngine::addIndividual(
-        FolksIndividual *individual)
+        FolksIndividual *individual,
+        const ConvertedContact &converted)
 {
-    QContact contact;
-//    EngineId *engineId = new EngineId(QString::fromUtf8(folks_individual_get_id(individual)), managerUri());
-//    QContactId contactId(engineId);
-//    contact.setId(contactId);
-
-  /* alien tooling needs contacts to be in this collection and of this type because
-   * 1) it applies a filter for these two things when it calls contacts() and
-   * 2) it won't pick up any changes to contacts signalled via dbus otherwise
-   */
-QContactCollectionId colId = QContactCollectionId(managerUri(), dbIdToByteArray(1, true));
+    Metrics::Timer timer(Metrics::AddIndividualLatency);
+    const QContact &contact = converted.contact;
 
-    contact.setId(QContactId(managerUri(), dbIdToByteArray(qHash(QString::fromUtf8(folks_individual_get_id(individual))))));
-
-        QContactType type;
-        type.setType(QContactType::TypeContact);
-        contact.saveDetail(&type);
-
-
-        contact.setCollectionId(colId);
-
-    if(folks_individual_get_is_user(individual)) {
-        debug() << "Skipping self contact:"
-            << folks_name_details_get_full_name(FOLKS_NAME_DETAILS(individual))
-            << individual;
-        return QContactId();
-    }
-
-    debug() << "Added:"
+    FOLKS_TRACE(lcEngine) << "Added:"
         << folks_name_details_get_full_name(FOLKS_NAME_DETAILS(individual))
         << individual
         << qPrintable(QString::fromUtf8(folks_individual_get_id(individual)))
-        << qPrintable(colId.toString());
+        << qPrintable(contact.collectionId().toString());
 
     C_NOTIFY_CONNECT(individual, "alias", aliasChangedCb);
-    updateAliasFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "structured-name", structuredNameChangedCb);
-    updateStructuredNameFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "full-name", fullNameChangedCb);
-    updateFullNameFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "nickname", nicknameChangedCb);
-    updateNicknameFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "presence-type", presenceChangedCb);
     C_NOTIFY_CONNECT(individual, "presence-message", presenceChangedCb);
-    updatePresenceFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "birthday", birthdayChangedCb);
-    updateBirthdayFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "email-addresses", emailAddressesChangedCb);
-    updateEmailAddressesFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "im-addresses", imAddressesChangedCb);
-    updateImAddressesFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "favourite", favouriteChangedCb);
-    updateFavoriteFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "gender", genderChangedCb);
-    updateGenderFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "notes", notesChangedCb);
-    updateNotesFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "roles", rolesChangedCb);
-    updateOrganizationFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "phone-numbers", phoneNumbersChangedCb);
-    updatePhoneNumbersFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "postal-addresses", postalAddressesChangedCb);
-    updateAddressesFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "urls", urlsChangedCb);
-    updateUrlsFromIndividual(contact, individual);
-
     C_NOTIFY_CONNECT(individual, "avatar", avatarChangedCb);
-    updateAvatarFromIndividual(contact, individual);
+    C_NOTIFY_CONNECT(individual, "is-user", isUserChangedCb);
+
+    // Store the contact
+    ContactPair pair(converted.contact, individual);
 
     GeeSet *empty_set = gee_set_empty(G_TYPE_NONE, NULL, NULL);
     C_CONNECT(individual, "personas-changed", personasChangedCb);
-    updatePersonas(contact, individual,
+    updatePersonas(pair.contact, individual,
             folks_individual_get_personas(individual), empty_set);
     g_object_unref(empty_set);
 
-    // Store the contact
-    ContactPair pair(contact, individual);
     m_allContacts.insert(contact.id(), pair);
+    m_store.insert(pair.contact, converted.sortKey);
+    m_store.setCollections(contact.id(), converted.collections);
 
     m_individualsToIds.insert(individual, contact.id());
 
@@ -1712,7 +1962,7 @@ QContactCollectionId colId = QContactCollectionId(managerUri(), dbIdToByteArray(
 QContactId ManagerEngine::removeIndividual(
         FolksIndividual *individual)
 {
-    debug() << "Removed:"
+    FOLKS_TRACE(lcEngine) << "Removed:"
         << folks_alias_details_get_alias(FOLKS_ALIAS_DETAILS(individual))
         << individual;
 
@@ -1720,43 +1970,20 @@ QContactId ManagerEngine::removeIndividual(
     if (m_individualsToIds.contains(individual)) {
         id = m_individualsToIds[individual];
         m_individualsToIds.remove(individual);
+        foreach(const QString &uid, m_personaSignals.value(individual).keys())
+            disconnectPersona(individual, uid);
         m_allContacts.remove(id);
+        m_store.remove(id);
     }
 
     return id;
 }
 
-// DetailType can be a QContactGlobalPresence or a QContactPresence
-// FolkType can be a FolksIndividual or a FolksPersona
-template<typename DetailType, typename FolkType>
-bool ManagerEngine::setPresenceDetail(
-        DetailType& detail,
-        FolkType *folk)
-{
-    Q_ASSERT(FOLKS_IS_PRESENCE_DETAILS(folk) && FOLKS_IS_ALIAS_DETAILS(folk));
-
-    if(folks_presence_details_get_presence_type(FOLKS_PRESENCE_DETAILS(folk))
-            != FOLKS_PRESENCE_TYPE_UNSET) {
-        detail.setCustomMessage(QString::fromUtf8(
-            folks_presence_details_get_presence_message(
-                FOLKS_PRESENCE_DETAILS(folk))));
-        detail.setPresenceState(folksToQtPresence(
-            folks_presence_details_get_presence_type(
-                FOLKS_PRESENCE_DETAILS(folk))));
-        detail.setNickname(QString::fromUtf8(
-            folks_alias_details_get_alias(FOLKS_ALIAS_DETAILS(folk))));
-        return true;
-    }
-    else
-        return false;
-}
-
 QList<QContactId> ManagerEngine::contactIds(
         const QContactFilter& filter,
         const QList<QContactSortOrder>& sortOrders,
         QContactManager::Error *error) const
 {
-qWarning("contacts someone requested IDS");
     QList<QContactId> ids;
     QContactManager::Error tmpError = QContactManager::NoError;
     QList<QContact> cnts = contacts(filter, sortOrders,
@@ -1774,7 +2001,6 @@ qWarning("contacts someone requested IDS");
 QContact ManagerEngine::compatibleContact (const QContact & original,
         QContactManager::Error * error ) const
 {
-qWarning("contacts compatible contact req"); 
     // Let's keep all information about contact we will need that on EDS
     return original;
 }
@@ -1784,19 +2010,17 @@ QContact ManagerEngine::contact(
         const QContactFetchHint& fetchHint,
         QContactManager::Error* error) const
 {
-    Q_UNUSED(fetchHint);
-qWarning("contacts SOMEONE requestioned a contacts");
+    FOLKS_TRACE(lcQuery) << "contact()" << contactId;
 
-    QContact contact = QContact();
-    if(m_allContacts.contains(contactId)) {
-qWarning("contacts found it: id %s", qPrintable(contactId.toString()));
-
-        ContactPair pair = m_allContacts[contactId];
-        contact = pair.contact;
-        *error = QContactManager::NoError;
+    ContactSnapshotPtr snapshot = m_store.snapshot();
+    if(!snapshot->contains(contactId)) {
+        *error = QContactManager::DoesNotExistError;
+        return QContact();
     }
 
-    return contact;
+    *error = QContactManager::NoError;
+    return snapshot->contact(contactId,
+            ContactRecord::groupMask(fetchHint.detailTypesHint()));
 }
 
 QList<QContact> ManagerEngine::contacts(
@@ -1805,38 +2029,61 @@ QList<QContact> ManagerEngine::contacts(
         const QContactFetchHint& fetchHint,
         QContactManager::Error *error) const
 {
-qWarning("contacts SOMEONE requestioned contacts, filter type %d", filter.type());
-QList<QContactFilter> filters = ((QContactIntersectionFilter& )filter).filters();
-    foreach(QContactFilter f, filters) {
-qWarning("contacts internal filter: type %d", f.type());
-      if (f.type() == 1) {
-        const QVariant& v = ((QContactDetailFilter& )f).value();
-qWarning("contacts detail filter: detailType %d detailField %d, variant t %s", ((QContactDetailFilter& )f).detailType(), ((QContactDetailFilter& )f).detailField(), qPrintable(v.typeName()));
-        int url = v.toInt();
-qWarning("contacts url int: %d", url);
-  }
-
-      if (f.type() == 10) {
-        const QSet<QContactCollectionId> ids = ((QContactCollectionFilter& )f).collectionIds();
-    foreach(QContactCollectionId id, ids) {
-qWarning("contacts collection ID filter, id: %s", qPrintable(id.toString()));
-
+    Metrics::Timer timer(Metrics::ContactsLatency);
+    Metrics::countQuery(filter.type());
+    FOLKS_TRACE(lcQuery) << "contacts()" << filter;
+
+    // Only ever look at one published version of the store, even if the
+    // main thread publishes a new one while we are iterating
+    ContactSnapshotPtr snapshot = m_store.snapshot();
+    // Only the hinted details are returned. Other filters and sort orders
+    // look at any detail, so then the whole contact is decoded and trimmed
+    // to the hint once it matched; the default filter sorted by sort key
+    // only needs the hinted groups decoded.
+    const quint32 groups =
+        ContactRecord::groupMask(fetchHint.detailTypesHint());
+    const quint32 matchGroups =
+        filter.type() == QContactFilter::DefaultFilter
+        && (sortOrders.isEmpty() || canUseSortKeys(sortOrders))
+        ? groups : ContactRecord::AllGroups;
+    // Entries of a shared snapshot decode their contact on every access,
+    // so each one is decoded once for filtering, sorting and the result
+    QVector<Match> matches;
+    QSet<QContactId> candidates;
+    if(ContactQuery::candidates(filter, *snapshot, &candidates)) {
+        Metrics::increment(Metrics::IndexedQueries);
+        matches.reserve(candidates.size());
+        foreach(const QContactId& id, candidates) {
+            const ContactEntry *entry = snapshot->find(id);
+            if(!entry)
+                continue;
+
+            const QContact contact = entry->contact(matchGroups);
+            if(ContactQuery::matches(filter, *entry, contact))
+                matches.append(Match(contact, entry));
         }
-      }
+    } else {
+        Metrics::increment(Metrics::ScannedQueries);
+        matches.reserve(snapshot->count());
+        snapshot->forEach([&](const ContactEntry& entry) {
+            /* no clue what that filter set by sailfish is, all we know is that ours don't pass it */
+            const QContact contact = entry.contact(matchGroups);
+            if(ContactQuery::matches(filter, entry, contact))
+                matches.append(Match(contact, &entry));
+        });
     }
+    sortMatches(&matches, sortOrders);
 
     QList<QContact> cnts;
-
-    foreach(const ContactPair& pair, m_allContacts) {
-qWarning("contacts adding one to list");
-        /* no clue what that filter set by sailfish is, all we know is that ours don't pass it */
-        if(QContactManagerEngine::testFilter(filter, pair.contact)) {
-qWarning("contact passed the filter");
-            QContactManagerEngine::addSorted(&cnts, pair.contact, sortOrders);
-}
+    cnts.reserve(matches.size());
+    foreach(const Match &match, matches) {
+        cnts.append(matchGroups == groups ? match.first
+                : ContactRecord::select(match.first, groups));
     }
 
-qWarning("contacts done adding");
+    *error = QContactManager::NoError;
+
+    FOLKS_TRACE(lcQuery) << "contacts() found" << cnts.size() << "contacts";
 /*
     QContact contact;
 //    EngineId *engineId = new EngineId(QString::fromUtf8(folks_individual_get_id(individual)), managerUri());
@@ -1867,11 +2114,26 @@ qWarning("contact added default test contact with id id : %s", qPrintable(contac
                 QMap<int, QContactManager::Error> *errorMap,
                 QContactManager::Error *error) const
 {
-qWarning("contacts local ids not implemented");
     QList<QContact> cnts;
+    cnts.reserve(localIds.size());
+
+    *error = QContactManager::NoError;
+    // Records of a shared snapshot skip decoding the details not hinted at
+    const quint32 groups =
+        ContactRecord::groupMask(fetchHint.detailTypesHint());
+    ContactSnapshotPtr snapshot = m_store.snapshot();
+    for(int i = 0; i < localIds.size(); ++i) {
+        if(const ContactEntry *entry = snapshot->find(localIds.at(i))) {
+            cnts << entry->contact(groups);
+        } else {
+            if(errorMap)
+                errorMap->insert(i, QContactManager::DoesNotExistError);
+            *error = QContactManager::DoesNotExistError;
+            cnts << QContact();
+        }
+    }
 
     return cnts;
-
 }
 
 QList<QContact> ManagerEngine::contacts(
@@ -1882,7 +2144,6 @@ QList<QContact> ManagerEngine::contacts(
         QContactManager::Error *error) const
 {
     Q_UNUSED(errorMap);
-qWarning("contacts contacts fetch order not implemented");
 
     return contacts(filter, sortOrders, fetchHint, error);
 }
@@ -1892,7 +2153,7 @@ bool ManagerEngine::saveContacts(
             QMap<int, QContactManager::Error> *errorMap,
             QContactManager::Error *error)
 {
-qWarning("contacts safeContacts not implemented");
+    qCWarning(lcWrite) << "saveContacts() is not implemented, use a QContactSaveRequest";
 
     return false;
 }
@@ -1901,7 +2162,7 @@ qWarning("contacts safeContacts not implemented");
 bool ManagerEngine::removeContact(const QContactId &contactId, QContactManager::Error* error)
 {
     QMap<int, QContactManager::Error> errorMap;
-qWarning("contacts remove contacts implemented");
+    qCWarning(lcWrite) << "removeContact() is not implemented, use a QContactRemoveRequest";
 
 return false;
 }
@@ -1911,48 +2172,212 @@ bool ManagerEngine::removeContacts(
             QMap<int, QContactManager::Error> *errorMap,
             QContactManager::Error* error)
 {
-qWarning("contacts removed contacts 2 implemented");
+    qCWarning(lcWrite) << "removeContacts() is not implemented, use a QContactRemoveRequest";
 return false;
 }
 
 QContactId ManagerEngine::selfContactId(QContactManager::Error* error) const
 {
-qWarning("contacts self contact id implemented");
-QContactId contactId;
+    const QContactId contactId = m_store.snapshot()->selfContactId();
+    *error = contactId.isNull() ? QContactManager::DoesNotExistError
+        : QContactManager::NoError;
+
     return contactId;
 }
 
 bool ManagerEngine::setSelfContactId(
         const QContactId&, QContactManager::Error* error)
 {
-qWarning("contacts set self contact id implemented");
+    // Folks decides which individual is the user
+    *error = QContactManager::NotSupportedError;
 
     return false;
 }
 
-QContactCollectionId ManagerEngine::defaultCollectionId() const
+void ManagerEngine::presenceChangedCb(
+        FolksIndividual *individual)
+{
+    if (!m_individualsToIds.contains(individual))
+        return;
+
+    const QContactId id = m_individualsToIds[individual];
+    if(m_pendingPresenceIds.contains(id))
+        Metrics::increment(Metrics::NotificationsSuppressed);
+
+    m_pendingPresenceIds.insert(id);
+    scheduleFlush();
+}
+
+void ManagerEngine::scheduleFlush()
+{
+    if(!m_flushSource)
+        m_flushSource = g_idle_add(flushChangesCb, this);
+}
+
+gboolean ManagerEngine::flushChangesCb(gpointer userData)
+{
+    ManagerEngine *this_ = static_cast<ManagerEngine *>(userData);
+    this_->m_flushSource = 0;
+    this_->flushChanges();
+
+    return G_SOURCE_REMOVE;
+}
+
+void ManagerEngine::flushChanges()
+{
+    // Removed individuals were announced as removed already
+    QList<QContactId> changedIds;
+    foreach(const QContactId &contactId, m_pendingChangedIds) {
+        if(m_allContacts.contains(contactId))
+            changedIds << contactId;
+    }
+    m_pendingChangedIds.clear();
+
+    // A persona's presence only changes its own account and presence
+    // details. Neither is indexed nor part of the sort key, so they are
+    // stored like the global presence, without reindexing.
+    QSet<QContactId> accountIds;
+    foreach(const QString &uid, m_pendingPersonaUids) {
+        bool read = false;
+        PersonaData data;
+        foreach(FolksIndividual *individual, m_personasToIndividuals.values(uid)) {
+            FolksPersona *persona =
+                m_personaSignals.value(individual).value(uid).persona;
+            if(!persona || !m_individualsToIds.contains(individual))
+                continue;
+
+            if(!read) {
+                data = IndividualReader::persona(persona);
+                read = true;
+            }
+
+            const QContactId contactId = m_individualsToIds[individual];
+            ContactBuilder::setPersonaAccount(m_allContacts[contactId].contact, data);
+            accountIds.insert(contactId);
+            m_pendingPresenceIds.insert(contactId);
+        }
+    }
+    m_pendingPersonaUids.clear();
+
+    QList<QContactId> presenceIds;
+    foreach(const QContactId &contactId, m_pendingPresenceIds) {
+        // The individual may have gone away in the meantime
+        if(!m_allContacts.contains(contactId))
+            continue;
+
+        ContactPair& pair = m_allContacts[contactId];
+        if(!ContactBuilder::updatePresence(pair.contact,
+                    IndividualReader::presence(pair.individual)) &&
+                !accountIds.contains(contactId)) {
+            Metrics::increment(Metrics::NotificationsSuppressed);
+            continue;
+        }
+
+        m_store.updatePresence(pair.contact);
+        presenceIds << contactId;
+    }
+    m_pendingPresenceIds.clear();
+
+    publish();
+    notifyCollectionChanges();
+
+    Metrics::increment(Metrics::IndividualsChanged,
+            changedIds.size() + presenceIds.size());
+
+    if(!changedIds.isEmpty()) {
+        m_notifier->contactsChanged(changedIds);
+        emit contactsChanged(changedIds, QList<QContactDetail::DetailType>());
+    }
+    if(!presenceIds.isEmpty()) {
+        QList<QContactDetail::DetailType> types;
+        types << QContactGlobalPresence::Type;
+        if(!accountIds.isEmpty())
+            types << QContactPresence::Type;
+
+        m_notifier->contactsPresenceChanged(presenceIds);
+        emit contactsChanged(presenceIds, types);
+    }
+}
+
+void ManagerEngine::notifySelfContactChange(const QContactId &oldId)
+{
+    if(oldId == m_selfContactId)
+        return;
+
+    qCDebug(lcEngine) << "Self contact changed:" << oldId << "->" << m_selfContactId;
+    // Clients only pass on what the primary engine already announced
+    if(!m_clientMode)
+        m_notifier->selfContactIdChanged(oldId, m_selfContactId);
+    emit selfContactIdChanged(oldId, m_selfContactId);
+}
+
+void ManagerEngine::isUserChangedCb(
+        FolksIndividual *individual)
 {
-qWarning("contacts default col id implemented");
+    if (!m_individualsToIds.contains(individual))
+        return;
+
+    const QContactId contactId = m_individualsToIds[individual];
+    const QContactId oldSelfContactId = m_selfContactId;
+    if(folks_individual_get_is_user(individual))
+        m_selfContactId = contactId;
+    else if(m_selfContactId == contactId)
+        m_selfContactId = QContactId();
+
+    m_store.setSelfContactId(m_selfContactId);
+    publish();
+    notifySelfContactChange(oldSelfContactId);
+}
 
-    return QContactCollectionId();
+QContactCollectionId ManagerEngine::defaultCollectionId() const
+{
+    return ContactBuilder::aggregateCollectionId(managerUri());
 }
 
 QContactCollection ManagerEngine::collection(
         const QContactCollectionId &collectionId,
         QContactManager::Error *error) const
 {
-qWarning("contacts default col() id implemented");
+    *error = QContactManager::NoError;
+
+    if(collectionId == ContactBuilder::aggregateCollectionId(managerUri()))
+        return ContactBuilder::aggregateCollection(managerUri());
+
+    const QContactCollection collection =
+        m_store.snapshot()->collection(collectionId);
+    if(collection.id().isNull())
+        *error = QContactManager::DoesNotExistError;
 
-    return QContactCollection();
+    return collection;
 }
 
 QList<QContactCollection> ManagerEngine::collections(
         QContactManager::Error *error) const
 {
-    QList<QContactCollection> collections;
-qWarning("contacts default cols() id implemented");
+    *error = QContactManager::NoError;
 
-    return collections;
+    return QList<QContactCollection>()
+        << ContactBuilder::aggregateCollection(managerUri())
+        << m_store.snapshot()->collections();
+}
+
+void ManagerEngine::notifyCollectionChanges()
+{
+    QList<QContactCollectionId> addedIds;
+    QList<QContactCollectionId> removedIds;
+    m_store.takeCollectionChanges(&addedIds, &removedIds);
+
+    if(!removedIds.isEmpty()) {
+        if(!m_clientMode)
+            m_notifier->collectionsRemoved(removedIds);
+        emit collectionsRemoved(removedIds);
+    }
+
+    if(!addedIds.isEmpty()) {
+        if(!m_clientMode)
+            m_notifier->collectionsAdded(addedIds);
+        emit collectionsAdded(addedIds);
+    }
 }
 
 
@@ -1961,7 +2386,6 @@ void ManagerEngine::personasChangedCb(
         GeeSet *added,
         GeeSet *removed)
 {
-qWarning("contacts got personas changed for an individual");
     if(!added && !removed)
         return;
 
@@ -1972,9 +2396,9 @@ qWarning("contacts got personas changed for an individual");
 
     ContactPair& pair = m_allContacts[contactId];
     updatePersonas(pair.contact, individual, added, removed);
-
-        m_notifier->contactsChanged(QList<QContactId>() << contactId);
-    emit contactsChanged(QList<QContactId>() << contactId, QList<QContactDetail::DetailType>());
+    m_store.setCollections(contactId, ContactBuilder::storeCollections(
+                managerUri(), IndividualReader::stores(individual)));
+    commitContact(pair);
 }
 
 #define IMPLEMENT_INDIVIDUAL_NOTIFY_CALLBACK(cb, updateFunction) \
@@ -1988,9 +2412,7 @@ qWarning("contacts got personas changed for an individual");
         \
         ContactPair& pair = m_allContacts[contactId]; \
         updateFunction(pair.contact, individual); \
-        \
-        m_notifier->contactsChanged(QList<QContactId>() << contactId); \
-        emit contactsChanged(QList<QContactId>() << contactId, QList<QContactDetail::DetailType>()); \
+        commitContact(pair); \
     }
 
 IMPLEMENT_INDIVIDUAL_NOTIFY_CALLBACK(
@@ -2005,9 +2427,6 @@ IMPLEMENT_INDIVIDUAL_NOTIFY_CALLBACK(
 IMPLEMENT_INDIVIDUAL_NOTIFY_CALLBACK(
         nicknameChangedCb,
         updateNicknameFromIndividual)
-IMPLEMENT_INDIVIDUAL_NOTIFY_CALLBACK(
-        presenceChangedCb,
-        updatePresenceFromIndividual)
 IMPLEMENT_INDIVIDUAL_NOTIFY_CALLBACK(
         birthdayChangedCb,
         updateBirthdayFromIndividual)
@@ -2044,38 +2463,18 @@ IMPLEMENT_INDIVIDUAL_NOTIFY_CALLBACK(
 
 #undef IMPLEMENT_INDIVIDUAL_NOTIFY_CALLBACK
 
-#define IMPLEMENT_PERSONA_NOTIFY_CALLBACK(cb, updateFunction) \
-    void ManagerEngine::cb( \
-            FolksPersona *persona) \
-    { \
-        QList<FolksIndividual *> individuals = \
-            m_personasToIndividuals.values(persona); \
-        QList<QContactId> changedIds; \
-        foreach(FolksIndividual * individual, individuals) { \
-            if (!m_individualsToIds.contains(individual)) \
-                return; \
-            \
-            QContactId contactId = m_individualsToIds[individual]; \
-            \
-            ContactPair& pair = m_allContacts[contactId]; \
-            updateFunction(pair.contact, individual, persona); \
-            \
-            changedIds << contactId; \
-        } \
-        \
-        if(!changedIds.isEmpty()) { \
-            m_notifier->contactsChanged(changedIds); \
-            emit contactsChanged(changedIds, QList<QContactDetail::DetailType>()); \
-        } \
-    }
-
-IMPLEMENT_PERSONA_NOTIFY_CALLBACK(
-        personaPresenceChangedCb,
-        updatePresenceFromPersona)
+void ManagerEngine::personaPresenceChangedCb(
+        FolksPersona *persona)
+{
+    const QString uid = QString::fromUtf8(folks_persona_get_uid(persona));
+    if(m_pendingPersonaUids.contains(uid))
+        Metrics::increment(Metrics::NotificationsSuppressed);
 
-#undef IMPLEMENT_PERSONA_NOTIFY_CALLBACK
+    m_pendingPersonaUids.insert(uid);
+    scheduleFlush();
+}
 
-static GValue* asvSetStrNew(QMultiMap<QString, QString> providerUidMap)
+static GValue* asvSetStrNew(const QMultiMap<const char *, QString> &providerUidMap)
 {
 GeeMultiMap *hashSet =
     GEE_MULTI_MAP(gee_hash_multi_map_new(G_TYPE_STRING,\
@@ -2107,19 +2506,16 @@ GeeMultiMap *hashSet =
     GValue *retval = gValueSliceNew (G_TYPE_OBJECT);
     g_value_take_object (retval, hashSet);
 
-    QList<QString> keys = providerUidMap.keys();
-    foreach(const QString& key, keys) {
-        QList<QString> values = providerUidMap.values(key);
-        foreach(const QString& value, values) {
-            FolksImFieldDetails *imfd;
+    QMultiMap<const char *, QString>::const_iterator it;
+    for(it = providerUidMap.constBegin(); it != providerUidMap.constEnd(); ++it) {
+        FolksImFieldDetails *imfd;
 
-            imfd = folks_im_field_details_new (value.toUtf8().data(), NULL);
+        imfd = folks_im_field_details_new (Utf8(it.value()).data(), NULL);
 
-            gee_multi_map_set(hashSet,
-                              key.toUtf8().data(),
-                              imfd);
-            g_object_unref(imfd);
-        }
+        gee_multi_map_set(hashSet,
+                          it.key(),
+                          imfd);
+        g_object_unref(imfd);
     }
 
     return retval;
@@ -2128,7 +2524,7 @@ GeeMultiMap *hashSet =
 static void gValueGeeSetAddStringFieldDetails(GValue *value,
         GType g_type,
         const char* v_string,
-        QStringList contexts)
+        const QList<const char *> &contexts)
 {
     GeeCollection *collection = (GeeCollection*) g_value_get_object(value);
 
@@ -2161,7 +2557,7 @@ static void gValueGeeSetAddStringFieldDetails(GValue *value,
     }
 
     if (fieldDetails == NULL) {
-        qWarning() << "Invalid fieldDetails type" << g_type;
+        qCWarning(lcWrite) << "Invalid fieldDetails type" << g_type;
     } else {
         setFieldDetailsFromContexts (fieldDetails, "type", contexts);
         gee_collection_add(collection, fieldDetails);
@@ -2216,7 +2612,7 @@ ManagerEngine::aggregatorAddPersonaFromDetailsCb(GObject *source,
     persona = folks_individual_aggregator_add_persona_from_details_finish(
         aggregator, result, &error);
     if(error != NULL) {
-        qWarning() << "Failed to add individual from contact:"
+        qCWarning(lcWrite) << "Failed to add individual from contact:"
             << error->message;
 
         opError = managerErrorFromIndividualAggregatorError(
@@ -2232,7 +2628,7 @@ ManagerEngine::aggregatorAddPersonaFromDetailsCb(GObject *source,
 //            EngineId *engineId = new EngineId(QString::fromUtf8(folks_individual_get_id(individual)), managerUri());
 //            QContactId contactId(engineId);
 //            contact.setId(contactId);
-    contact.setId(QContactId(managerUri(), dbIdToByteArray(qHash(QString::fromUtf8(folks_individual_get_id(individual))))));
+    contact.setId(ContactBuilder::contactId(managerUri(), folks_individual_get_id(individual)));
         }
     }
 
@@ -2256,8 +2652,8 @@ ManagerEngine::aggregatorAddPersonaFromDetailsCb(GObject *source,
         foreach(const q_type& detail, contact.details<q_type>()) { \
             if(!detail.isEmpty()) { \
                 gValueGeeSetAddStringFieldDetails(value, (g_type), \
-                        detail.member().toUtf8().data(), \
-                        Utils::contextsFromEnums(detail.contexts())); \
+                        Utf8(detail.member()).data(), \
+                        contextNames(detail.contexts())); \
             } \
         } \
         PERSONA_DETAILS_INSERT((details), (key), (value)); \
@@ -2296,13 +2692,13 @@ static GHashTable* personaDetailsHashFromQContact(
         foreach(const QContactAddress& address, addresses) {
             if(!address.isEmpty()) {
                 FolksPostalAddress *postalAddress = folks_postal_address_new(
-                        address.postOfficeBox().toUtf8().data(),
+                        Utf8(address.postOfficeBox()).data(),
                         NULL,
-                        address.street().toUtf8().data(),
-                        address.locality().toUtf8().data(),
-                        address.region().toUtf8().data(),
-                        address.postcode().toUtf8().data(),
-                        address.country().toUtf8().data(),
+                        Utf8(address.street()).data(),
+                        Utf8(address.locality()).data(),
+                        Utf8(address.region()).data(),
+                        Utf8(address.postcode()).data(),
+                        Utf8(address.country()).data(),
                         NULL,
                         NULL);
 
@@ -2318,8 +2714,9 @@ static GHashTable* personaDetailsHashFromQContact(
                             NULL);
 
                 // Set contexts and subTypes
-                QStringList contexts = Utils::contextsFromEnums(address.contexts());
-                contexts << Utils::addressSubTypesFromEnums(address.subTypes());
+                QList<const char *> contexts;
+                Utils::contextsFromEnums(address.contexts(), &contexts);
+                Utils::addressSubTypesFromEnums(address.subTypes(), &contexts);
                 setFieldDetailsFromContexts ((FolksAbstractFieldDetails*)pafd, "type", contexts);
 
                 gee_collection_add(collection, pafd);
@@ -2344,7 +2741,7 @@ static GHashTable* personaDetailsHashFromQContact(
             QString formattedUri = avatarUri.toString(QUrl::RemoveUserInfo);
             if(!formattedUri.isEmpty()) {
                 GFile *avatarFile =
-                    g_file_new_for_uri(formattedUri.toUtf8().data());
+                    g_file_new_for_uri(Utf8(formattedUri).data());
                 GFileIcon *avatarFileIcon = G_FILE_ICON(
                         g_file_icon_new(avatarFile));
                 g_value_take_object(value, avatarFileIcon);
@@ -2416,11 +2813,11 @@ static GHashTable* personaDetailsHashFromQContact(
     if(!name.isEmpty()) {
         value = gValueSliceNew(FOLKS_TYPE_STRUCTURED_NAME);
         FolksStructuredName *sn = folks_structured_name_new(
-                name.lastName().toUtf8().data(),
-                name.firstName().toUtf8().data(),
-                name.middleName().toUtf8().data(),
-                name.prefix().toUtf8().data(),
-                name.suffix().toUtf8().data());
+                Utf8(name.lastName()).data(),
+                Utf8(name.firstName()).data(),
+                Utf8(name.middleName()).data(),
+                Utf8(name.prefix()).data(),
+                Utf8(name.suffix()).data());
         g_value_take_object(value, sn);
 
         PERSONA_DETAILS_INSERT(details, FOLKS_PERSONA_DETAIL_STRUCTURED_NAME,
@@ -2431,11 +2828,11 @@ static GHashTable* personaDetailsHashFromQContact(
     QContactDisplayLabel displayLabel = contact.detail<QContactDisplayLabel>();
     if(!displayLabel.label().isEmpty()) {
         value = gValueSliceNew(G_TYPE_STRING);
-        g_value_set_string(value, displayLabel.label().toUtf8().data());
+        g_value_set_string(value, Utf8(displayLabel.label()).data());
         PERSONA_DETAILS_INSERT(details, FOLKS_PERSONA_DETAIL_FULL_NAME, value);
         // FIXME: check if those values should all be set to the same thing
         value = gValueSliceNew(G_TYPE_STRING);
-        g_value_set_string(value, displayLabel.label().toUtf8().data());
+        g_value_set_string(value, Utf8(displayLabel.label()).data());
         PERSONA_DETAILS_INSERT(details, FOLKS_PERSONA_DETAIL_ALIAS, value);
     }
 
@@ -2452,7 +2849,7 @@ static GHashTable* personaDetailsHashFromQContact(
     QList<QContactOnlineAccount> accounts =
         contact.details<QContactOnlineAccount>();
     if(accounts.size() > 0) {
-        QMultiMap<QString, QString> providerUidMap;
+        QMultiMap<const char *, QString> providerUidMap;
 
         foreach(const QContactOnlineAccount& account, accounts) {
             if (!account.isEmpty()) {
@@ -2481,8 +2878,8 @@ static GHashTable* personaDetailsHashFromQContact(
         g_value_take_object(value, hashSet);
         foreach(const QContactOrganization& org, orgs) {
             if(!org.isEmpty()) {
-                FolksRole *role = folks_role_new(org.title().toUtf8().data(),
-                        org.name().toUtf8().data(), NULL);
+                FolksRole *role = folks_role_new(Utf8(org.title()).data(),
+                        Utf8(org.name()).data(), NULL);
 
                 gee_collection_add(GEE_COLLECTION(hashSet), role);
             }
@@ -2499,16 +2896,13 @@ static GHashTable* personaDetailsHashFromQContact(
         value = gValueSliceNew(G_TYPE_OBJECT);
         foreach(QContactPhoneNumber detail, phones) {
             if(!detail.isEmpty()) {
-                QStringList contexts = Utils::contextsFromEnums(detail.contexts());
-                QList<int> subTypes = detail.subTypes();
-
-                if (subTypes.size() > 0) {
-                    contexts << Utils::phoneSubTypesFromEnums(subTypes);
-                }
+                QList<const char *> contexts;
+                Utils::contextsFromEnums(detail.contexts(), &contexts);
+                Utils::phoneSubTypesFromEnums(detail.subTypes(), &contexts);
 
                 gValueGeeSetAddStringFieldDetails(value,
                                                   FOLKS_TYPE_PHONE_FIELD_DETAILS,
-                                                  detail.number().toUtf8().data(),
+                                                  Utf8(detail.number()).data(),
                                                   contexts);
             }
         }
@@ -2539,7 +2933,7 @@ ManagerEngine::aggregatorRemoveIndividualCb(GObject *source,
     folks_individual_aggregator_remove_individual_finish(aggregator, result,
             &error);
     if(error != NULL) {
-        qWarning() << "Failed to remove an individual from contact:"
+        qCWarning(lcWrite) << "Failed to remove an individual from contact:"
             << error->message;
 
         opError = managerErrorFromIndividualAggregatorError(
@@ -2586,13 +2980,14 @@ bool ManagerEngine::contactSaveChangesToFolks(const QContact& contact)
     FolksIndividual *ind = pair.individual;
 
     if(ind == NULL) {
-        qWarning() << "Failed to save changes to contact" << contact.id()
+        qCWarning(lcWrite) << "Failed to save changes to contact" << contact.id()
                    << ": no known corresponding FolksIndividual";
         return false;
     }
 
     FolksPersona *persona = getPrimaryPersona(ind);
     CallbackData *data = new CallbackData();
+    data->timer.start();
     data->contact = contact;
     data->storedContact = pair.contact;
     data->store = folks_individual_aggregator_get_primary_store(m_aggregator);
@@ -2609,21 +3004,22 @@ bool ManagerEngine::contactSaveChangesToFolks(const QContact& contact)
         foreach(const QContactAddress& address, addresses) {
             if(!address.isEmpty()) {
                 FolksPostalAddress *postalAddress = folks_postal_address_new(
-                        address.postOfficeBox().toUtf8().data(),
+                        Utf8(address.postOfficeBox()).data(),
                         NULL,
-                        address.street().toUtf8().data(),
-                        address.locality().toUtf8().data(),
-                        address.region().toUtf8().data(),
-                        address.postcode().toUtf8().data(),
-                        address.country().toUtf8().data(),
+                        Utf8(address.street()).data(),
+                        Utf8(address.locality()).data(),
+                        Utf8(address.region()).data(),
+                        Utf8(address.postcode()).data(),
+                        Utf8(address.country()).data(),
                         NULL,
                         NULL);
                 FolksPostalAddressFieldDetails *pafd =
                     folks_postal_address_field_details_new (postalAddress,
                             NULL);
 
-                QStringList contexts = Utils::contextsFromEnums(address.contexts());
-                contexts << Utils::addressSubTypesFromEnums(address.subTypes());
+                QList<const char *> contexts;
+                Utils::contextsFromEnums(address.contexts(), &contexts);
+                Utils::addressSubTypesFromEnums(address.subTypes(), &contexts);
                 setFieldDetailsFromContexts((FolksAbstractFieldDetails*)pafd, "type", contexts);
                 gee_collection_add(GEE_COLLECTION(addressSet), pafd);
 
@@ -2651,7 +3047,7 @@ bool ManagerEngine::startRequest(QContactAbstractRequest* request)
     if(request == NULL)
         return false;
 
-    qDebug() << "START REQUEST" << request->type();
+    FOLKS_TRACE(lcEngine) << "Starting request" << request->type();
     updateRequestState(request, QContactAbstractRequest::ActiveState);
     switch(request->type()) {
         case QContactAbstractRequest::ContactSaveRequest:
@@ -2660,23 +3056,33 @@ bool ManagerEngine::startRequest(QContactAbstractRequest* request)
                     qobject_cast<QContactSaveRequest*>(request);
 
             if((save_request == 0) || (save_request->contacts().size() < 1)) {
-                qWarning() << "Contact save request NULL or has zero contacts";
+                qCWarning(lcWrite) << "Contact save request NULL or has zero contacts";
+                break;
+            }
+
+            if(m_clientMode) {
+                // Only the primary engine writes to Folks
+                updateContactSaveRequest(save_request, save_request->contacts(),
+                        QContactManager::NotSupportedError,
+                        QMap<int, QContactManager::Error>(),
+                        QContactAbstractRequest::FinishedState);
                 break;
             }
 
             FolksPersonaStore *primaryStore =
                 folks_individual_aggregator_get_primary_store(m_aggregator);
             if(primaryStore == NULL) {
-                qWarning() << "Failed to add individual from contact: "
+                qCWarning(lcWrite) << "Failed to add individual from contact: "
                         "couldn't get the only persona store";
             } else {
-                qDebug () << "Save contact" << save_request->contacts();
+                FOLKS_TRACE(lcWrite) << "Save contact" << save_request->contacts();
                 /* guaranteed to have >= 1 contacts above */
                 foreach(const QContact& contact, save_request->contacts()) {
                     // TODO: check if it is really null or if it has no managerUri
                     if(contact.id().isNull()) {
                         AddPersonaFromDetailsClosure *closure =
                             new AddPersonaFromDetailsClosure;
+                        closure->timer.start();
                         closure->this_ = this;
                         closure->request = save_request;
                         closure->contact = contact;
@@ -2707,11 +3113,19 @@ bool ManagerEngine::startRequest(QContactAbstractRequest* request)
 
             if((remove_request == 0) ||
                     (remove_request->contactIds().size() < 1)) {
-                qWarning() << "Contact remove request NULL or has zero "
+                qCWarning(lcWrite) << "Contact remove request NULL or has zero "
                     "contacts";
                 break;
             }
 
+            if(m_clientMode) {
+                updateContactRemoveRequest(remove_request,
+                        QContactManager::NotSupportedError,
+                        QMap<int, QContactManager::Error>(),
+                        QContactAbstractRequest::FinishedState);
+                break;
+            }
+
             foreach(const QContactId& contactId,
                     remove_request->contactIds()) {
                 RemoveIndividualClosure *closure = new RemoveIndividualClosure;
@@ -2719,7 +3133,7 @@ bool ManagerEngine::startRequest(QContactAbstractRequest* request)
                 closure->request = remove_request;
 
                 if(!m_allContacts.contains(contactId)) {
-                    qWarning() << "Attempted to remove unknown Contact";
+                    qCWarning(lcWrite) << "Attempted to remove unknown Contact";
                     continue;
                 }
 
@@ -2737,18 +3151,60 @@ bool ManagerEngine::startRequest(QContactAbstractRequest* request)
         break;
         case QContactAbstractRequest::ContactFetchRequest:
         {
-            QContactFetchRequest* fetchRequest = qobject_cast<QContactFetchRequest*>(request);
+            QPointer<QContactFetchRequest> fetchRequest =
+                qobject_cast<QContactFetchRequest*>(request);
             QContactFilter fetchFilter = fetchRequest->filter();
             QList<QContactSortOrder> fetchSorting = fetchRequest->sorting();
             QContactFetchHint fetchHint = fetchRequest->fetchHint();
 
-            QContactManager::Error error = QContactManager::NoError;
-            QList<QContact> allContacts = contacts(fetchFilter, fetchSorting, fetchHint, &error);
+            startReadRequest([=]() -> std::function<void()> {
+                QContactManager::Error error = QContactManager::NoError;
+                QList<QContact> allContacts = contacts(fetchFilter, fetchSorting, fetchHint, &error);
+
+                return [=]() {
+                    if(fetchRequest)
+                        updateContactFetchRequest(fetchRequest, allContacts, error, QContactAbstractRequest::FinishedState);
+                };
+            });
+        }
+        break;
+
+        case QContactAbstractRequest::ContactIdFetchRequest:
+        {
+            QPointer<QContactIdFetchRequest> idRequest =
+                qobject_cast<QContactIdFetchRequest*>(request);
+            QContactFilter fetchFilter = idRequest->filter();
+            QList<QContactSortOrder> fetchSorting = idRequest->sorting();
+
+            startReadRequest([=]() -> std::function<void()> {
+                QContactManager::Error error = QContactManager::NoError;
+                QList<QContactId> ids = contactIds(fetchFilter, fetchSorting, &error);
+
+                return [=]() {
+                    if(idRequest)
+                        updateContactIdFetchRequest(idRequest, ids, error, QContactAbstractRequest::FinishedState);
+                };
+            });
+        }
+        break;
 
-            if (!allContacts.isEmpty() || error != QContactManager::NoError)
-                updateContactFetchRequest(fetchRequest, allContacts, error, QContactAbstractRequest::FinishedState);
-            else
-                updateRequestState(request, QContactAbstractRequest::FinishedState);
+        case QContactAbstractRequest::ContactFetchByIdRequest:
+        {
+            QPointer<QContactFetchByIdRequest> byIdRequest =
+                qobject_cast<QContactFetchByIdRequest*>(request);
+            QList<QContactId> ids = byIdRequest->contactIds();
+            QContactFetchHint fetchHint = byIdRequest->fetchHint();
+
+            startReadRequest([=]() -> std::function<void()> {
+                QContactManager::Error error = QContactManager::NoError;
+                QMap<int, QContactManager::Error> errorMap;
+                QList<QContact> found = contacts(ids, fetchHint, &errorMap, &error);
+
+                return [=]() {
+                    if(byIdRequest)
+                        updateContactFetchByIdRequest(byIdRequest, found, error, errorMap, QContactAbstractRequest::FinishedState);
+                };
+            });
         }
         break;
 
@@ -2763,16 +3219,50 @@ bool ManagerEngine::startRequest(QContactAbstractRequest* request)
     return true;
 }
 
+void ManagerEngine::startReadRequest(
+        std::function<std::function<void()>()> work)
+{
+    m_readPool.start(new ReadRequestRunnable(this, work));
+}
+
+void ManagerEngine::customEvent(QEvent *event)
+{
+    if(event->type() == RequestFinishedEvent::eventType()) {
+        static_cast<RequestFinishedEvent*>(event)->finish();
+        return;
+    }
+
+    QContactManagerEngine::customEvent(event);
+}
+
+bool ManagerEngine::waitForRequestFinished(
+        QContactAbstractRequest* request,
+        int msecs)
+{
+    if(request == NULL)
+        return false;
+
+    // Read requests post their result back to us, so wait for the workers
+    // and then deliver whatever they posted.
+    if(request->state() == QContactAbstractRequest::ActiveState) {
+        m_readPool.waitForDone(msecs > 0 ? msecs : -1);
+        QCoreApplication::sendPostedEvents(this,
+                RequestFinishedEvent::eventType());
+    }
+
+    return request->isFinished();
+}
+
 // Here is the factory used to allocate new manager engines.
 
 QContactManagerEngine* ManagerEngineFactory::engine(
         const QMap<QString, QString>& parameters,
         QContactManager::Error *error)
 {
-    if(debugEnabled()) {
-        debug() << "Creating a new folks engine";
-        foreach(const QString& key, parameters)
-            debug() << "    " << key << ": " << parameters[key];
+    if(lcEngine().isDebugEnabled()) {
+        qCDebug(lcEngine) << "Creating a new folks engine";
+        foreach(const QString& key, parameters.keys())
+            qCDebug(lcEngine) << "    " << key << ": " << parameters[key];
     }
 
     return new ManagerEngine(parameters, error);
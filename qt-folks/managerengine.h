@@ -20,11 +20,20 @@
 
 #include "glib-utils.h"
 #include <folks/folks.h>
+#include <QElapsedTimer>
 #include <QObject>
 #include <QContactManagerEngine>
 #include <QContactManagerEngineFactoryInterface>
 #include <QContactPresence>
+#include <QThreadPool>
+#include "contactbuilder.h"
 #include "contactnotifier.h"
+#include "contactservice.h"
+#include "contactstore.h"
+#include "metrics.h"
+#include "sharedsnapshot.h"
+
+#include <functional>
 
 #define protected _protected
 #include <folks/folks.h>
@@ -71,6 +80,8 @@ typedef struct {
     QContact contact;
     QContact storedContact;
     FolksPersonaStore *store;
+    // Started when the save is, for Metrics::SaveLatency
+    QElapsedTimer timer;
 } CallbackData;
 
 void addressDetailChangeCb(GObject *detail, GAsyncResult *result, gpointer userdata);
@@ -98,15 +109,14 @@ public:
             QContactManager::Error* error);
     ~ManagerEngine();
 
-    QString managerName() const { qWarning("contacts manager name req"); return QLatin1String("org.nemomobile.contacts.sqlite"); }
-    int managerVersion() const { qWarning("contacts manager ver req");  return 1; }
+    // Not FOLKS_MANAGER_NAME: Sailfish apps expect the sqlite engine's name
+    QString managerName() const { return QLatin1String("org.nemomobile.contacts.sqlite"); }
+    int managerVersion() const { return 1; }
 
     QList<QContactType::TypeValues> supportedContactTypes() const {
-qWarning("contacts manager supported req"); 
         return QList<QContactType::TypeValues>() << QContactType::TypeContact;
     }
     QList<QVariant::Type> supportedDataTypes() const {
-qWarning("contacts manager supported data req"); 
         return QList<QVariant::Type>() << QVariant::String;
     }
 
@@ -154,6 +164,11 @@ qWarning("contacts manager supported data req");
     virtual QContact compatibleContact (const QContact & original,
             QContactManager::Error * error ) const;
 
+    bool waitForRequestFinished(QContactAbstractRequest* req, int msecs) override;
+
+protected:
+    void customEvent(QEvent *event) override;
+
 private slots:
 /*
     void _q_collectionsAdded(const QVector<quint32> &collectionIds);
@@ -165,23 +180,67 @@ private slots:
     void _q_contactsPresenceChanged(const QVector<quint32> &contactIds);
     void _q_contactsAdded(const QVector<quint32> &contactIds);
     void _q_contactsRemoved(const QVector<quint32> &contactIds);
+    void _q_contactsBatchChanged(const QVector<quint32> &addedIds,
+            const QVector<quint32> &changedIds,
+            const QVector<quint32> &presenceChangedIds,
+            const QVector<quint32> &removedIds);
+    void _q_selfContactIdChanged(quint32 oldId, quint32 newId);
+    void _q_snapshotChanged(quint64 generation);
 /*
-    void _q_selfContactIdChanged(quint32,quint32);
     void _q_relationshipsAdded(const QVector<quint32> &contactIds);
     void _q_relationshipsRemoved(const QVector<quint32> &contactIds);
     void _q_displayLabelGroupsChanged();
 */
 private:
-    QContactPresence::PresenceState folksToQtPresence(FolksPresenceType fp);
-    QContactId addIndividual(FolksIndividual *individual);
+    // Client mode: follows the contacts of the primary engine of another
+    // process instead of running a Folks aggregator. Returns false if there
+    // is no primary engine to follow.
+    bool startClient();
+    // With keysRemoved, the primary removed a contact of each of keys and
+    // the ones it doesn't serve any more are removed here as well
+    void fetchRemoteContacts(const QVector<quint32> &keys,
+            const QList<QContactDetail::DetailType> &typesChanged,
+            bool keysRemoved = false);
+    void applyRemoteContacts(const ServedContacts &served,
+            const QList<QContactDetail::DetailType> &typesChanged,
+            const QVector<quint32> &removedKeys = QVector<quint32>());
+    void updateRemoteSelfContact();
+    // Client mode with the primary's SharedSnapshot mapped
+    bool mapRemoteSnapshot();
+    // Maps the segments written after generation since, applying them
+    void requestSharedSegments(quint64 since);
+    // Returns false if the segments don't follow the ones applied so far
+    bool applySharedSegments(const QList<SharedSnapshotPtr> &segments);
+    void applySharedBase(const SharedSnapshotPtr &base,
+            const std::function<void(const QContactId &, bool)> &inserted,
+            const std::function<void(const QContactId &)> &removed);
+    void applySharedDelta(const SharedSnapshotPtr &delta,
+            const std::function<void(const QContactId &, bool)> &inserted,
+            const std::function<void(const QContactId &)> &removed);
+
+    // m_store.publish(), and schedules writing a new shared snapshot in
+    // the primary engine
+    void publish();
+    void writeSharedSnapshot();
+    static gboolean writeSharedSnapshotCb(gpointer userData);
+
+    QContactId addIndividual(FolksIndividual *individual,
+            const ConvertedContact &converted);
     QContactId removeIndividual(FolksIndividual *individual);
+    void notifyCollectionChanges();
+    void notifySelfContactChange(const QContactId &oldId);
+    // Publishes the changes queued by commitContact(), presenceChangedCb()
+    // and personaPresenceChangedCb() once the main loop is idle
+    void scheduleFlush();
+    void flushChanges();
+    static gboolean flushChangesCb(gpointer userData);
     FolksPersona* getPrimaryPersona(FolksIndividual *individual);
 
     class ContactPair {
     public:
         ContactPair()
             : individual(0) {}
-        ContactPair(QContact& c, FolksIndividual *i)
+        ContactPair(const QContact& c, FolksIndividual *i)
             : contact(c)
             , individual(g_object_ref(i)) {}
         ContactPair(const ContactPair& other)
@@ -200,16 +259,72 @@ private:
         FolksIndividual *individual;
     };
 
+    // Runs a read-only request on m_readPool. The work function is called on
+    // a worker thread and returns the function which reports its result; that
+    // one is called back on the engine's thread.
+    void startReadRequest(std::function<std::function<void()>()> work);
+    void commitContact(const ContactPair& pair);
+
+    // 0 in client mode
     FolksIndividualAggregator *m_aggregator;
     ContactNotifier *m_notifier;
 
+    // 0 in client mode
+    ContactService *m_service;
+    guint m_sharedSnapshotSource;
+    // The contacts changed since the last segment written, and the
+    // records in the deltas since the last base
+    QSet<QContactId> m_sharedChanges;
+    int m_sharedDeltaRecords;
+
+    bool m_clientMode;
+    // The unique name of the primary engine, once it was checked to run as
+    // our user
+    QString m_remoteService;
+    // The contacts of the primary engine by the keys its signals use. Keys
+    // are hashes and can collide, so one may stand for several contacts.
+    QMultiHash<quint32, QContactId> m_remoteIds;
+    quint32 m_remoteSelfKey;
+    // Tells colliding contacts apart, from the last contacts served
+    QContactId m_remoteSelfId;
+    // The generation of the last segment of the primary's snapshot
+    // applied, 0 if the client couldn't map it
+    quint64 m_sharedGeneration;
+
     bool m_initialIndividualsAdded;
 
+    // m_allContacts is the main thread's working copy, m_store is what
+    // contacts(), contactIds() and contact() read from any thread.
+    ContactStore m_store;
+    QThreadPool m_readPool;
+
     QMap<QContactId, ContactPair> m_allContacts;
+    // The contact of the individual Folks marks as the user, if any
+    QContactId m_selfContactId;
+    // Contacts whose presence changed since the last flush. Folks notifies
+    // presence-type and presence-message separately, so both are collected
+    // here and applied together from an idle source.
+    QSet<QContactId> m_pendingPresenceIds;
+    // Personas with their own presence which changed since the last flush
+    QSet<QString> m_pendingPersonaUids;
+    // Contacts changed in m_store since the last flush, announced together
+    // with a single publish
+    QSet<QContactId> m_pendingChangedIds;
+    guint m_flushSource;
     QMap<FolksIndividual *, QContactId> m_individualsToIds;
-    QMultiMap<FolksPersona *, FolksIndividual *> m_personasToIndividuals;
-    QMap<QPair<FolksIndividual *, FolksPersona *>, gulong>
-        m_personasSignalHandlerIds;
+
+    // The notify handlers of a persona with its own presence
+    struct PersonaSignals {
+        PersonaSignals()
+            : persona(0) {}
+
+        // Referenced for as long as the handlers are connected
+        FolksPersona *persona;
+        QList<gulong> handlerIds;
+    };
+    // The personas with their own presence of each individual, by uid
+    QHash<FolksIndividual *, QHash<QString, PersonaSignals> > m_personaSignals;
+    QMultiHash<QString, FolksIndividual *> m_personasToIndividuals;
 
 #define ARGS \
     FolksIndividualAggregator *aggregator, GeeSet *added, GeeSet *removed, \
@@ -235,6 +350,7 @@ typedef struct
     ManagerEngine* this_;
     QContactSaveRequest* request;
     QContact contact;
+    QElapsedTimer timer;
 } AddPersonaFromDetailsClosure;
 
 #define ARGS_CORE \
@@ -251,6 +367,8 @@ typedef struct
 
         this_->aggregatorAddPersonaFromDetailsCb(source, result, request,
                 closure->contact);
+        Metrics::record(Metrics::SaveLatency,
+                closure->timer.nsecsElapsed() / 1000);
 
         delete closure;
     }
@@ -289,13 +407,11 @@ typedef struct
             FolksIndividual *individual;
         } AvatarLoadData;
         static void avatarReadyCB(GObject *source, GAsyncResult *res, gpointer user_data);
+    // Writes an avatar which isn't a file yet to the Folks avatar cache and
+    // sets it on the contact once that is done
+    void cacheAvatar(FolksIndividual *individual, const QContactId &contactId,
+            const QByteArray &uri);
 
-    template<typename DetailType>
-    void removeOldDetails(QContact& contact)
-    {
-        foreach(DetailType oldDetail, contact.details<DetailType>())
-            contact.removeDetail(&oldDetail);
-    }
     void updateGuidFromIndividual(QContact& contact,
             FolksIndividual *individual);
     void updateAliasFromIndividual(QContact& contact,
@@ -306,10 +422,6 @@ typedef struct
             FolksIndividual *individual);
     void updateNicknameFromIndividual(QContact& contact,
             FolksIndividual *individual);
-    void updatePresenceFromIndividual(QContact& contact,
-            FolksIndividual *individual);
-    void updatePresenceFromPersona(QContact& contact,
-            FolksIndividual *individual, FolksPersona *persona);
     void updateAvatarFromIndividual(QContact& contact,
             FolksIndividual *individual);
     void updateBirthdayFromIndividual(QContact& contact,
@@ -334,26 +446,18 @@ typedef struct
             FolksIndividual *individual);
     void updatePersonas(QContact& contact, FolksIndividual *individual,
             GeeSet *added, GeeSet *removed);
-//    void addAccountDetails(QContact& contact, TpfPersona *persona);
-  //  void removeAccountDetails(QContact& contact, TpfPersona *persona);
+    void connectPersona(FolksIndividual *individual, FolksPersona *persona);
+    void disconnectPersona(FolksIndividual *individual, const QString &uid);
 
     void updateDisplayLabelFromIndividual(QContact& contact,
             FolksIndividual *individual);
     void updateNameFromIndividual(QContact& contact,
             FolksIndividual *individual);
 
-    QString getPersonaAccountUri(FolksPersona *persona);
-    QString getPersonaPresenceUri(FolksPersona *persona);
-    QContactPresence getPresenceForPersona(QContact& contact,
-            FolksPersona *persona);
-
     static void managerReadyCb(GObject *sourceObject, GAsyncResult *result,
             gpointer userData);
 //    TpAccount *getAccountForTpContact(TpContact *tpContact);
 
-    template<typename DetailType, typename FolkType>
-    bool setPresenceDetail(DetailType& detail, FolkType *folk);
-
 #define ARGS \
     FolksIndividual *individual, GeeSet *added, GeeSet *removed
     void personasChangedCb(ARGS);
@@ -380,6 +484,7 @@ typedef struct
     DEFINE_C_NOTIFICATION_HANDLER(phoneNumbersChangedCb, FolksIndividual);
     DEFINE_C_NOTIFICATION_HANDLER(postalAddressesChangedCb, FolksIndividual);
     DEFINE_C_NOTIFICATION_HANDLER(urlsChangedCb, FolksIndividual);
+    DEFINE_C_NOTIFICATION_HANDLER(isUserChangedCb, FolksIndividual);
     DEFINE_C_NOTIFICATION_HANDLER(personaPresenceChangedCb, FolksPersona);
 
     // async API
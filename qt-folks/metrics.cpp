@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <atomic>
+#include <QStringList>
+#include "metrics.h"
+
+namespace Folks
+{
+
+namespace {
+
+struct LatencyData
+{
+    std::atomic<quint64> count;
+    std::atomic<quint64> totalUs;
+    std::atomic<quint64> buckets[Metrics::BucketCount];
+};
+
+// Zero-initialized before any code runs
+std::atomic<quint64> counters[Metrics::CounterCount];
+std::atomic<quint64> queryCounters[Metrics::FilterTypeCount];
+LatencyData latencies[Metrics::LatencyCount];
+
+const char *const counterNames[Metrics::CounterCount] = {
+    "individuals-added",
+    "individuals-removed",
+    "individuals-changed",
+    "notifications-emitted",
+    "notifications-suppressed",
+    "queries-indexed",
+    "queries-scanned",
+    "cache-hits",
+    "cache-misses"
+};
+
+const char *const latencyNames[Metrics::LatencyCount] = {
+    "contacts-latency",
+    "add-individual-latency",
+    "save-latency"
+};
+
+struct FilterTypeName
+{
+    QContactFilter::FilterType type;
+    const char *name;
+};
+
+const FilterTypeName filterTypeNames[] = {
+    { QContactFilter::InvalidFilter, "invalid" },
+    { QContactFilter::ContactDetailFilter, "detail" },
+    { QContactFilter::ContactDetailRangeFilter, "detail-range" },
+    { QContactFilter::ChangeLogFilter, "change-log" },
+    { QContactFilter::ActionFilter, "action" },
+    { QContactFilter::RelationshipFilter, "relationship" },
+    { QContactFilter::IntersectionFilter, "intersection" },
+    { QContactFilter::UnionFilter, "union" },
+    { QContactFilter::IdFilter, "id" },
+    { QContactFilter::DefaultFilter, "default" },
+    { QContactFilter::CollectionFilter, "collection" }
+};
+
+int filterTypeIndex(QContactFilter::FilterType type)
+{
+    return qBound(0, int(type), int(Metrics::FilterTypeCount) - 1);
+}
+
+int bucketIndex(qint64 microseconds)
+{
+    int bucket = 0;
+    while(microseconds > 0 && bucket < Metrics::BucketCount - 1) {
+        microseconds >>= 1;
+        ++bucket;
+    }
+    return bucket;
+}
+
+QString queriesName(const char *filterName)
+{
+    return QLatin1String("queries-") + QLatin1String(filterName);
+}
+
+}
+
+quint64 Metrics::Histogram::percentile(int percent) const
+{
+    const quint64 rank = (count * percent + 99) / 100;
+    quint64 seen = 0;
+    for(int i = 0; i < BucketCount; ++i) {
+        seen += buckets[i];
+        if(seen >= rank && seen > 0)
+            return quint64(1) << i;
+    }
+    return 0;
+}
+
+void Metrics::increment(Counter counter, quint64 amount)
+{
+    counters[counter].fetch_add(amount, std::memory_order_relaxed);
+}
+
+void Metrics::countQuery(QContactFilter::FilterType type)
+{
+    queryCounters[filterTypeIndex(type)].fetch_add(1,
+            std::memory_order_relaxed);
+}
+
+void Metrics::record(Latency latency, qint64 microseconds)
+{
+    LatencyData &data = latencies[latency];
+    data.count.fetch_add(1, std::memory_order_relaxed);
+    data.totalUs.fetch_add(qMax<qint64>(microseconds, 0),
+            std::memory_order_relaxed);
+    data.buckets[bucketIndex(microseconds)].fetch_add(1,
+            std::memory_order_relaxed);
+}
+
+quint64 Metrics::value(Counter counter)
+{
+    return counters[counter].load(std::memory_order_relaxed);
+}
+
+quint64 Metrics::queries(QContactFilter::FilterType type)
+{
+    return queryCounters[filterTypeIndex(type)].load(
+            std::memory_order_relaxed);
+}
+
+Metrics::Histogram Metrics::histogram(Latency latency)
+{
+    const LatencyData &data = latencies[latency];
+
+    Histogram histogram;
+    histogram.count = data.count.load(std::memory_order_relaxed);
+    histogram.totalUs = data.totalUs.load(std::memory_order_relaxed);
+    for(int i = 0; i < BucketCount; ++i)
+        histogram.buckets[i] = data.buckets[i].load(std::memory_order_relaxed);
+
+    return histogram;
+}
+
+const char *Metrics::name(Counter counter)
+{
+    return counterNames[counter];
+}
+
+const char *Metrics::name(Latency latency)
+{
+    return latencyNames[latency];
+}
+
+QVariantMap Metrics::values()
+{
+    QVariantMap values;
+
+    for(int i = 0; i < CounterCount; ++i)
+        values.insert(QLatin1String(counterNames[i]), value(Counter(i)));
+
+    for(const FilterTypeName &filter : filterTypeNames)
+        values.insert(queriesName(filter.name), queries(filter.type));
+
+    for(int i = 0; i < LatencyCount; ++i) {
+        const Histogram h = histogram(Latency(i));
+
+        QVariantList buckets;
+        for(int j = 0; j < BucketCount; ++j)
+            buckets << h.buckets[j];
+
+        QVariantMap map;
+        map.insert(QStringLiteral("count"), h.count);
+        map.insert(QStringLiteral("total-us"), h.totalUs);
+        map.insert(QStringLiteral("buckets"), buckets);
+        values.insert(QLatin1String(latencyNames[i]), map);
+    }
+
+    return values;
+}
+
+QString Metrics::dump()
+{
+    QStringList lines;
+
+    for(int i = 0; i < CounterCount; ++i)
+        lines << QStringLiteral("%1 %2").arg(QLatin1String(counterNames[i]))
+            .arg(value(Counter(i)));
+
+    for(const FilterTypeName &filter : filterTypeNames) {
+        const quint64 count = queries(filter.type);
+        if(count)
+            lines << QStringLiteral("%1 %2").arg(queriesName(filter.name))
+                .arg(count);
+    }
+
+    for(int i = 0; i < LatencyCount; ++i) {
+        const Histogram h = histogram(Latency(i));
+        lines << QStringLiteral("%1 count %2 mean %3us p50 %4us p90 %5us p99 %6us")
+            .arg(QLatin1String(latencyNames[i]))
+            .arg(h.count)
+            .arg(h.count ? h.totalUs / h.count : 0)
+            .arg(h.percentile(50))
+            .arg(h.percentile(90))
+            .arg(h.percentile(99));
+    }
+
+    return lines.join(QLatin1Char('\n'));
+}
+
+void Metrics::reset()
+{
+    for(std::atomic<quint64> &counter : counters)
+        counter.store(0, std::memory_order_relaxed);
+    for(std::atomic<quint64> &counter : queryCounters)
+        counter.store(0, std::memory_order_relaxed);
+    for(LatencyData &data : latencies) {
+        data.count.store(0, std::memory_order_relaxed);
+        data.totalUs.store(0, std::memory_order_relaxed);
+        for(std::atomic<quint64> &bucket : data.buckets)
+            bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+MetricsService::MetricsService(QObject *parent)
+    : QObject(parent)
+{
+}
+
+QString MetricsService::Dump() const
+{
+    return Metrics::dump();
+}
+
+QVariantMap MetricsService::Values() const
+{
+    return Metrics::values();
+}
+
+} // namespace Folks
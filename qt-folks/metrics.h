@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QContactFilter>
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QVariantMap>
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+// Counters and latency histograms of the engine's hot paths.
+//
+// Every value is a relaxed atomic, so recording costs one uncontended
+// increment from any thread and never takes a lock. The values can be read
+// with value() and histogram(), as text with dump(), and from outside the
+// process through MetricsService.
+class Metrics
+{
+public:
+    enum Counter {
+        IndividualsAdded,
+        IndividualsRemoved,
+        IndividualsChanged,
+        NotificationsEmitted,
+        NotificationsSuppressed,
+        IndexedQueries,
+        ScannedQueries,
+        CacheHits,
+        CacheMisses,
+        CounterCount
+    };
+
+    enum Latency {
+        ContactsLatency,
+        AddIndividualLatency,
+        SaveLatency,
+        LatencyCount
+    };
+
+    enum {
+        // Bucket 0 counts durations below one microsecond, bucket i those
+        // below 2^i microseconds and the last one everything longer
+        BucketCount = 26,
+        // QContactFilter::FilterType values counted separately, anything
+        // above is counted with the last one
+        FilterTypeCount = 16
+    };
+
+    struct Histogram
+    {
+        quint64 count;
+        quint64 totalUs;
+        quint64 buckets[BucketCount];
+
+        // The upper bound in microseconds of the bucket the percent
+        // percentile falls into
+        quint64 percentile(int percent) const;
+    };
+
+    static void increment(Counter counter, quint64 amount = 1);
+    static void countQuery(QContactFilter::FilterType type);
+    static void record(Latency latency, qint64 microseconds);
+
+    static quint64 value(Counter counter);
+    static quint64 queries(QContactFilter::FilterType type);
+    static Histogram histogram(Latency latency);
+
+    static const char *name(Counter counter);
+    static const char *name(Latency latency);
+
+    // All values by name, counters as numbers and histograms as maps
+    static QVariantMap values();
+    // One line per value, for humans
+    static QString dump();
+    static void reset();
+
+    // Records the time from its construction to its destruction
+    class Timer
+    {
+    public:
+        explicit Timer(Latency latency)
+            : m_latency(latency) { m_timer.start(); }
+        ~Timer() { record(m_latency, m_timer.nsecsElapsed() / 1000); }
+
+    private:
+        Q_DISABLE_COPY(Timer)
+
+        Latency m_latency;
+        QElapsedTimer m_timer;
+    };
+};
+
+// Exports Metrics on the session bus, see ContactNotifier::exportObject().
+// Read-only: any peer on the bus can call it, so it can't clear the values.
+class MetricsService : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.nemomobile.contacts.sqlite.Metrics")
+
+public:
+    explicit MetricsService(QObject *parent = 0);
+
+public slots:
+    QString Dump() const;
+    QVariantMap Values() const;
+};
+
+} // namespace Folks
+
+#endif // METRICS_H
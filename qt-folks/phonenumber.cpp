@@ -0,0 +1,136 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "phonenumber.h"
+
+namespace Folks
+{
+
+QString PhoneNumber::normalize(const QString &number)
+{
+    QString normalized;
+    normalized.reserve(number.size());
+
+    for(int i = 0; i < number.size(); ++i) {
+        const QChar c = number.at(i);
+        if(c.isDigit()) {
+            normalized += QChar('0' + c.digitValue());
+        } else if(c == QLatin1Char('+')) {
+            if(normalized.isEmpty())
+                normalized += c;
+        } else if(c == QLatin1Char(',') || c == QLatin1Char(';')) {
+            // DTMF pause or wait, not part of the number itself
+            break;
+        } else if(isAsciiLetter(c)) {
+            int end = i + 1;
+            while(end < number.size() && isAsciiLetter(number.at(end)))
+                ++end;
+
+            // A lone p, w or x (or "ext") after the digits is a pause, wait
+            // or extension. Any other letters spell digits, like in
+            // 1-800-FLOWERS.
+            const QString word = number.mid(i, end - i);
+            if(hasDigits(normalized) && isSeparator(word))
+                break;
+            foreach(const QChar &letter, word)
+                normalized += keypadDigit(letter);
+            i = end - 1;
+        }
+        // Anything else (spaces, dashes, dots, brackets, slashes...) is
+        // formatting
+    }
+
+    if(normalized.startsWith(QLatin1String("00")))
+        normalized.replace(0, 2, QLatin1Char('+'));
+
+    return normalized;
+}
+
+QString PhoneNumber::digits(const QString &number)
+{
+    QString normalized = normalize(number);
+    if(normalized.startsWith(QLatin1Char('+')))
+        normalized.remove(0, 1);
+
+    return normalized;
+}
+
+QString PhoneNumber::reversed(const QString &digits)
+{
+    QString result;
+    result.reserve(digits.size());
+    for(int i = digits.size() - 1; i >= 0; --i)
+        result += digits.at(i);
+
+    return result;
+}
+
+bool PhoneNumber::isAsciiLetter(const QChar &c)
+{
+    const ushort u = c.unicode();
+    return (u >= 'a' && u <= 'z') || (u >= 'A' && u <= 'Z');
+}
+
+bool PhoneNumber::hasDigits(const QString &normalized)
+{
+    return normalized.size() > (normalized.startsWith(QLatin1Char('+')) ? 1 : 0);
+}
+
+bool PhoneNumber::isSeparator(const QString &word)
+{
+    if(word.size() == 1)
+        return QString::fromLatin1("pPwWxX").contains(word.at(0));
+
+    return word.compare(QLatin1String("ext"), Qt::CaseInsensitive) == 0;
+}
+
+QChar PhoneNumber::keypadDigit(const QChar &letter)
+{
+    // ITU E.161, the letters on a phone keypad
+    static const char digits[] = "22233344455566677778889999";
+    return QLatin1Char(digits[letter.toUpper().unicode() - 'A']);
+}
+
+bool PhoneNumber::matches(
+        const QString &number,
+        const QString &query,
+        QContactFilter::MatchFlags flags)
+{
+    const QString queryDigits = digits(query);
+    if(queryDigits.isEmpty())
+        return false;
+
+    const QString numberDigits = digits(number);
+
+    switch(int(flags) & MatchTypeMask) {
+    case QContactFilter::MatchStartsWith:
+        return normalize(number).startsWith(normalize(query));
+    case QContactFilter::MatchEndsWith:
+        return numberDigits.endsWith(queryDigits);
+    case QContactFilter::MatchContains:
+        return numberDigits.contains(queryDigits);
+    default:
+        if(numberDigits.size() >= CallerIdDigits &&
+                queryDigits.size() >= CallerIdDigits)
+            return numberDigits.right(CallerIdDigits) ==
+                queryDigits.right(CallerIdDigits);
+        return numberDigits == queryDigits;
+    }
+}
+
+} // namespace Folks
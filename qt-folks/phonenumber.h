@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef PHONE_NUMBER_H
+#define PHONE_NUMBER_H
+
+#include <QString>
+#include <QContactFilter>
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+// Phone number matching for QContactFilter::MatchPhoneNumber filters.
+//
+// Numbers are compared in their normalized form. Without a match type flag
+// (or with MatchExactly) two numbers match like caller-id does: if both
+// have at least CallerIdDigits digits only those trailing digits have to be
+// equal, so national and international spellings of a number still match.
+// MatchStartsWith is meant for dialer search and compares the start of the
+// normalized numbers, MatchEndsWith and MatchContains compare their digits.
+class PhoneNumber
+{
+public:
+    enum {
+        CallerIdDigits = 7,
+        // The bits of QContactFilter::MatchFlags selecting the kind of match
+        MatchTypeMask = 0x07
+    };
+
+    // Removes formatting characters and converts digits of any script to
+    // ASCII digits. Letters of vanity numbers become the digits on their
+    // keypad keys. A leading '+' is kept and a leading international "00"
+    // prefix is turned into '+'. Everything after a pause, wait or extension
+    // separator is dropped: ',' or ';', or a lone p, w or x (or "ext")
+    // following the digits.
+    static QString normalize(const QString &number);
+
+    // normalize() without the leading '+'
+    static QString digits(const QString &number);
+
+    static QString reversed(const QString &digits);
+
+    static bool matches(const QString &number, const QString &query,
+            QContactFilter::MatchFlags flags);
+
+private:
+    static bool isAsciiLetter(const QChar &c);
+    static bool hasDigits(const QString &normalized);
+    static bool isSeparator(const QString &word);
+    static QChar keypadDigit(const QChar &letter);
+};
+
+} // namespace Folks
+
+#endif // PHONE_NUMBER_H
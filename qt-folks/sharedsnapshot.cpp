@@ -0,0 +1,431 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QDataStream>
+#include <QIODevice>
+#include <QVector>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include "contactbuilder.h"
+#include "contactnotifier.h"
+#include "contactrecord.h"
+#include "debug.h"
+#include "sharedsnapshot.h"
+
+namespace Folks
+{
+
+struct SharedSnapshot::Header
+{
+    char magic[8];
+    quint32 version;
+    quint32 count;
+    quint64 baseGeneration;
+    quint64 generation;
+    quint32 selfContactKey;
+    quint32 infoOffset;
+    quint32 infoSize;
+};
+
+struct SharedSnapshot::Ref
+{
+    quint32 key;
+    quint32 hash;
+    // From the start of the snapshot
+    quint32 offset;
+    quint32 idSize;
+    quint32 metaSize;
+    quint32 contactSize;
+};
+
+namespace
+{
+
+const char Magic[8] = { 'Q', 'T', 'F', 'O', 'L', 'K', 'S', 0 };
+const QDataStream::Version StreamVersion = QDataStream::Qt_5_6;
+// Whoever maps a snapshot relies on it never changing
+const int RequiredSeals = F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE;
+
+QDataStream &operator<<(QDataStream &out, const IndexKeys &keys)
+{
+    return out << keys.phone << keys.name << keys.email << keys.im;
+}
+
+QDataStream &operator>>(QDataStream &in, IndexKeys &keys)
+{
+    return in >> keys.phone >> keys.name >> keys.email >> keys.im;
+}
+
+bool writeAll(int fd, struct iovec *iov, int count)
+{
+    while(count > 0) {
+        const ssize_t result = ::writev(fd, iov, qMin(count, IOV_MAX));
+        if(result < 0 && errno == EINTR)
+            continue;
+        if(result <= 0)
+            return false;
+
+        // A short write can end anywhere, even inside a buffer
+        size_t written = result;
+        while(count > 0 && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+        if(count > 0) {
+            iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+
+    return true;
+}
+
+struct iovec buffer(const QByteArray &data)
+{
+    struct iovec iov;
+    iov.iov_base = const_cast<char *>(data.constData());
+    iov.iov_len = data.size();
+    return iov;
+}
+
+}
+
+SharedSnapshot::Record SharedSnapshot::encode(const ContactEntry &entry)
+{
+    const QContact contact = entry.contact();
+    const QByteArray localId = contact.id().localId();
+
+    QList<QByteArray> collectionIds;
+    foreach(const QContactCollectionId &id, entry.collections)
+        collectionIds << id.localId();
+
+    Record record;
+    record.key = ContactNotifier::contactIdHash(contact.id());
+    record.idSize = localId.size();
+
+    QDataStream out(&record.data, QIODevice::WriteOnly);
+    out.setVersion(StreamVersion);
+    out.writeRawData(localId.constData(), localId.size());
+    out << entry.sortKey << collectionIds << entry.indexKeys();
+    record.metaSize = record.data.size() - record.idSize;
+    record.data += ContactRecord::encode(contact);
+    record.hash = qHashBits(record.data.constData(), record.data.size());
+
+    return record;
+}
+
+int SharedSnapshot::write(
+        const ContactSnapshot &snapshot,
+        quint64 baseGeneration,
+        const QSet<QContactId> &changed)
+{
+    QVector<Record> records;
+    QList<RecordKey> removed;
+    if(baseGeneration) {
+        records.reserve(changed.size());
+        foreach(const QContactId &id, changed) {
+            if(const ContactEntry *entry = snapshot.find(id))
+                records.append(encode(*entry));
+            else
+                removed << RecordKey(ContactNotifier::contactIdHash(id), id.localId());
+        }
+    } else {
+        records.reserve(snapshot.count());
+        snapshot.forEach([&records](const ContactEntry &entry) {
+            records.append(encode(entry));
+        });
+    }
+
+    QByteArray info;
+    QDataStream infoOut(&info, QIODevice::WriteOnly);
+    infoOut.setVersion(StreamVersion);
+    const QList<QContactCollection> storeCollections = snapshot.collections();
+    infoOut << quint32(storeCollections.size());
+    foreach(const QContactCollection &collection, storeCollections) {
+        infoOut << collection.id().localId()
+            << collection.metaData(QContactCollection::KeyName).toString()
+            << collection.extendedMetaData();
+    }
+    infoOut << snapshot.selfContactId().localId() << removed;
+
+    Header header;
+    memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = Version;
+    header.count = records.size();
+    header.baseGeneration = baseGeneration;
+    header.generation = snapshot.generation();
+    header.selfContactKey =
+        ContactNotifier::contactIdHash(snapshot.selfContactId());
+    header.infoOffset = sizeof(Header) + records.size() * sizeof(Ref);
+    header.infoSize = info.size();
+
+    QVector<Ref> refs;
+    refs.reserve(records.size());
+    quint32 offset = header.infoOffset + header.infoSize;
+    foreach(const Record &record, records) {
+        Ref ref;
+        ref.key = record.key;
+        ref.hash = record.hash;
+        ref.offset = offset;
+        ref.idSize = record.idSize;
+        ref.metaSize = record.metaSize;
+        ref.contactSize = record.data.size() - record.idSize - record.metaSize;
+        refs.append(ref);
+        offset += record.data.size();
+    }
+
+    QVector<struct iovec> iov;
+    iov.reserve(3 + records.size());
+    struct iovec headerIov;
+    headerIov.iov_base = &header;
+    headerIov.iov_len = sizeof(Header);
+    iov.append(headerIov);
+    struct iovec refsIov;
+    refsIov.iov_base = refs.data();
+    refsIov.iov_len = refs.size() * sizeof(Ref);
+    iov.append(refsIov);
+    iov.append(buffer(info));
+    foreach(const Record &record, records)
+        iov.append(buffer(record.data));
+
+    const int fd = memfd_create("qtfolks-snapshot",
+            MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if(fd < 0) {
+        qCWarning(lcEngine) << "Failed to create the shared snapshot:"
+            << strerror(errno);
+        return -1;
+    }
+
+    if(ftruncate(fd, offset) < 0 || !writeAll(fd, iov.data(), iov.size()) ||
+            fcntl(fd, F_ADD_SEALS, RequiredSeals | F_SEAL_SEAL) < 0) {
+        qCWarning(lcEngine) << "Failed to write the shared snapshot:"
+            << strerror(errno);
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+SharedSnapshotPtr SharedSnapshot::map(int fd, const QString &managerUri)
+{
+    const int seals = fcntl(fd, F_GET_SEALS);
+    if(seals < 0 || (seals & RequiredSeals) != RequiredSeals) {
+        qCWarning(lcEngine) << "Refusing to map an unsealed snapshot";
+        return SharedSnapshotPtr();
+    }
+
+    struct stat status;
+    if(fstat(fd, &status) < 0 || status.st_size < qint64(sizeof(Header)))
+        return SharedSnapshotPtr();
+
+    void *data = mmap(0, status.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if(data == MAP_FAILED) {
+        qCWarning(lcEngine) << "Failed to map the shared snapshot:"
+            << strerror(errno);
+        return SharedSnapshotPtr();
+    }
+
+    std::shared_ptr<SharedSnapshot> snapshot(new SharedSnapshot(managerUri,
+                static_cast<const uchar *>(data), status.st_size));
+    if(!snapshot->validate()) {
+        qCWarning(lcEngine) << "Shared snapshot is corrupt or of another version";
+        return SharedSnapshotPtr();
+    }
+
+    return snapshot;
+}
+
+SharedSnapshot::SharedSnapshot(
+        const QString &managerUri,
+        const uchar *data,
+        qint64 size)
+    : m_managerUri(managerUri)
+    , m_data(data)
+    , m_size(size)
+{
+}
+
+SharedSnapshot::~SharedSnapshot()
+{
+    munmap(const_cast<uchar *>(m_data), m_size);
+}
+
+bool SharedSnapshot::validate()
+{
+    const Header *h = header();
+    if(memcmp(h->magic, Magic, sizeof(Magic)) != 0 || h->version != Version)
+        return false;
+
+    const qint64 refsEnd = sizeof(Header) + qint64(h->count) * sizeof(Ref);
+    if(refsEnd > m_size || h->infoOffset < refsEnd ||
+            qint64(h->infoOffset) + h->infoSize > m_size ||
+            (h->baseGeneration && h->baseGeneration >= h->generation))
+        return false;
+
+    for(int i = 0; i < count(); ++i) {
+        const Ref *r = ref(i);
+        if(qint64(r->offset) + r->idSize + r->metaSize + r->contactSize > m_size)
+            return false;
+    }
+
+    QDataStream in(QByteArray::fromRawData(reinterpret_cast<const char *>(
+                    m_data + h->infoOffset), h->infoSize));
+    in.setVersion(StreamVersion);
+
+    quint32 collectionCount = 0;
+    in >> collectionCount;
+    for(quint32 i = 0; i < collectionCount && in.status() == QDataStream::Ok; ++i) {
+        QByteArray localId;
+        QString name;
+        QVariantMap extendedMetaData;
+        in >> localId >> name >> extendedMetaData;
+
+        QContactCollection collection;
+        collection.setId(QContactCollectionId(m_managerUri, localId));
+        collection.setMetaData(QContactCollection::KeyName, name);
+        for(QVariantMap::const_iterator it = extendedMetaData.constBegin();
+                it != extendedMetaData.constEnd(); ++it)
+            collection.setExtendedMetaData(it.key(), it.value());
+        m_collections.insert(localId, collection);
+    }
+    in >> m_selfLocalId >> m_removed;
+
+    return in.status() == QDataStream::Ok;
+}
+
+const SharedSnapshot::Header *SharedSnapshot::header() const
+{
+    return reinterpret_cast<const Header *>(m_data);
+}
+
+const SharedSnapshot::Ref *SharedSnapshot::ref(int record) const
+{
+    return reinterpret_cast<const Ref *>(m_data + sizeof(Header)) + record;
+}
+
+quint64 SharedSnapshot::baseGeneration() const
+{
+    return header()->baseGeneration;
+}
+
+quint64 SharedSnapshot::generation() const
+{
+    return header()->generation;
+}
+
+int SharedSnapshot::count() const
+{
+    return header()->count;
+}
+
+quint32 SharedSnapshot::selfContactKey() const
+{
+    return header()->selfContactKey;
+}
+
+QContactId SharedSnapshot::selfContactId() const
+{
+    return m_selfLocalId.isEmpty() ? QContactId()
+        : QContactId(m_managerUri, m_selfLocalId);
+}
+
+quint32 SharedSnapshot::key(int record) const
+{
+    return ref(record)->key;
+}
+
+QByteArray SharedSnapshot::localId(int record) const
+{
+    const Ref *r = ref(record);
+    return QByteArray(reinterpret_cast<const char *>(m_data + r->offset),
+            r->idSize);
+}
+
+quint32 SharedSnapshot::hash(int record) const
+{
+    return ref(record)->hash;
+}
+
+SharedSnapshot::Meta SharedSnapshot::meta(int record) const
+{
+    const Ref *r = ref(record);
+    QDataStream in(QByteArray::fromRawData(
+                reinterpret_cast<const char *>(m_data + r->offset + r->idSize),
+                r->metaSize));
+    in.setVersion(StreamVersion);
+
+    Meta meta;
+    in >> meta.sortKey >> meta.collectionIds >> meta.indexKeys;
+
+    return meta;
+}
+
+QContactId SharedSnapshot::contactId(int record) const
+{
+    return QContactId(m_managerUri, localId(record));
+}
+
+QString SharedSnapshot::sortKey(int record) const
+{
+    return meta(record).sortKey;
+}
+
+IndexKeys SharedSnapshot::indexKeys(int record) const
+{
+    return meta(record).indexKeys;
+}
+
+QList<QContactCollection> SharedSnapshot::collections(int record) const
+{
+    QList<QContactCollection> collections;
+    foreach(const QByteArray &localId, meta(record).collectionIds) {
+        if(m_collections.contains(localId))
+            collections << m_collections.value(localId);
+    }
+
+    return collections;
+}
+
+QContact SharedSnapshot::contact(
+        int record,
+        quint32 groups) const
+{
+    const Ref *r = ref(record);
+    QContact contact;
+    if(!ContactRecord::decode(
+                reinterpret_cast<const char *>(
+                    m_data + r->offset + r->idSize + r->metaSize),
+                r->contactSize, &contact, groups))
+        qCWarning(lcEngine) << "Corrupt record" << record << "in the shared snapshot";
+
+    // The primary's ids carry its manager URI, which needn't be ours
+    contact.setId(QContactId(m_managerUri, contact.id().localId()));
+    contact.setCollectionId(ContactBuilder::aggregateCollectionId(m_managerUri));
+
+    return contact;
+}
+
+} // namespace Folks
@@ -0,0 +1,156 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef SHARED_SNAPSHOT_H
+#define SHARED_SNAPSHOT_H
+
+#include <QByteArray>
+#include <QContact>
+#include <QContactCollection>
+#include <QContactId>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QSet>
+#include "contactstore.h"
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace Folks
+{
+
+// A read-only copy of a ContactSnapshot, in segments of sealed memfds.
+//
+// The primary engine writes a segment with write() whenever its store
+// changed and hands the file descriptors to client engines (see
+// ContactService), which map() them instead of keeping a copy of every
+// contact. A base segment holds every contact; the delta segments after it
+// only hold the contacts changed since the segment before, and the keys of
+// the ones removed, so writing and applying one costs as much as the
+// changes it carries. Every ContactEntry of a client points at the segment
+// its record is in, and a segment is unmapped with the last one.
+//
+// A client only decodes the sort key, collections and index keys of each
+// record up front; the contact itself is decoded from the mapping whenever
+// it is read.
+//
+// Layout, in host byte order since it never leaves the device:
+//   Header
+//   Ref[count]
+//   QDataStream encoded: the store collections, the local id of the self
+//   contact and the keys of the removed records
+//   the records: the local id, QDataStream encoded meta data (sort key,
+//   local ids of the store collections, index keys) and the contact as a
+//   ContactRecord
+class SharedSnapshot
+{
+public:
+    enum {
+        Version = 4,
+        // The primary writes at most one segment per interval
+        WriteInterval = 200, // ms
+        // After this many segments the primary writes a base again
+        MaxSegments = 32
+    };
+
+    // See ContactNotifier::contactIdHash(), and the local id telling
+    // records with colliding keys apart
+    typedef QPair<quint32, QByteArray> RecordKey;
+
+    // Writes the contacts of snapshot to a new memfd and seals it: all of
+    // them without a baseGeneration, else a delta on top of the segment of
+    // that generation with the ones of changed, removed ones included.
+    // Returns the file descriptor, or -1 if it couldn't be written.
+    static int write(const ContactSnapshot &snapshot, quint64 baseGeneration,
+            const QSet<QContactId> &changed);
+
+    // Maps a segment written by write(). Ids are moved to managerUri.
+    // Returns an empty pointer if fd doesn't hold a sealed segment of this
+    // version.
+    static SharedSnapshotPtr map(int fd, const QString &managerUri);
+
+    ~SharedSnapshot();
+
+    // 0 for a base segment, else the generation of the segment this one
+    // applies to
+    quint64 baseGeneration() const;
+    quint64 generation() const;
+    int count() const;
+    // The records removed since the segment before
+    const QList<RecordKey> &removed() const { return m_removed; }
+    // See ContactNotifier::contactIdHash()
+    quint32 selfContactKey() const;
+    // Empty if the primary has no self contact
+    QContactId selfContactId() const;
+
+    // See ContactNotifier::contactIdHash(). Hashes collide, so records are
+    // told apart by their local id.
+    quint32 key(int record) const;
+    QByteArray localId(int record) const;
+    // Changes whenever anything in the record does
+    quint32 hash(int record) const;
+
+    QContactId contactId(int record) const;
+    QString sortKey(int record) const;
+    IndexKeys indexKeys(int record) const;
+    QList<QContactCollection> collections(int record) const;
+    QContact contact(int record,
+            quint32 groups = ContactRecord::AllGroups) const;
+
+private:
+    struct Header;
+    struct Ref;
+
+    struct Meta
+    {
+        QString sortKey;
+        QList<QByteArray> collectionIds;
+        IndexKeys indexKeys;
+    };
+
+    // A record as write() encodes it
+    struct Record
+    {
+        quint32 key;
+        quint32 hash;
+        quint32 idSize;
+        quint32 metaSize;
+        QByteArray data;
+    };
+
+    SharedSnapshot(const QString &managerUri, const uchar *data, qint64 size);
+
+    static Record encode(const ContactEntry &entry);
+
+    bool validate();
+    const Header *header() const;
+    const Ref *ref(int record) const;
+    Meta meta(int record) const;
+
+    QString m_managerUri;
+    const uchar *m_data;
+    qint64 m_size;
+    // The few store collections, decoded when mapping
+    QHash<QByteArray, QContactCollection> m_collections;
+    QByteArray m_selfLocalId;
+    QList<RecordKey> m_removed;
+};
+
+} // namespace Folks
+
+#endif // SHARED_SNAPSHOT_H
@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QHash>
+#include <QReadWriteLock>
+#include "metrics.h"
+#include "utf8.h"
+
+namespace Folks
+{
+
+Utf8::Utf8(const QString &string)
+{
+    const int size = string.size();
+    const ushort *source = string.utf16();
+
+    m_buffer.resize(size + 1);
+    char *out = m_buffer.data();
+
+    int i = 0;
+    for(; i < size && source[i] < 0x80; ++i)
+        out[i] = char(source[i]);
+
+    if(i < size) {
+        // Every UTF-16 code unit takes at most three bytes, a surrogate pair
+        // takes four for its two units
+        m_buffer.resize(i + (size - i) * 3 + 1);
+        out = m_buffer.data() + i;
+
+        for(; i < size; ++i) {
+            uint c = source[i];
+            if(c < 0x80) {
+                *out++ = char(c);
+            } else if(c < 0x800) {
+                *out++ = char(0xc0 | (c >> 6));
+                *out++ = char(0x80 | (c & 0x3f));
+            } else {
+                if(QChar::isHighSurrogate(c) && i + 1 < size &&
+                        QChar::isLowSurrogate(source[i + 1])) {
+                    c = QChar::surrogateToUcs4(ushort(c), source[++i]);
+                    *out++ = char(0xf0 | (c >> 18));
+                    *out++ = char(0x80 | ((c >> 12) & 0x3f));
+                } else {
+                    // An unpaired surrogate, like QString::toUtf8()
+                    if(QChar::isSurrogate(c))
+                        c = QChar::ReplacementCharacter;
+                    *out++ = char(0xe0 | (c >> 12));
+                }
+                *out++ = char(0x80 | ((c >> 6) & 0x3f));
+                *out++ = char(0x80 | (c & 0x3f));
+            }
+        }
+        i = out - m_buffer.data();
+        m_buffer.resize(i + 1);
+    }
+
+    m_buffer[i] = '\0';
+}
+
+QString Utf8::cached(const QByteArray &utf8)
+{
+    static QReadWriteLock lock;
+    static QHash<QByteArray, QString> strings;
+
+    {
+        QReadLocker locker(&lock);
+        QHash<QByteArray, QString>::const_iterator it = strings.constFind(utf8);
+        if(it != strings.constEnd()) {
+            Metrics::increment(Metrics::CacheHits);
+            return it.value();
+        }
+    }
+
+    Metrics::increment(Metrics::CacheMisses);
+
+    const QString string = QString::fromUtf8(utf8);
+
+    QWriteLocker locker(&lock);
+    // Someone else may have added it in the meantime
+    QHash<QByteArray, QString>::iterator it = strings.find(utf8);
+    if(it == strings.end())
+        it = strings.insert(utf8, string);
+    return it.value();
+}
+
+} // namespace Folks
@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef UTF8_H
+#define UTF8_H
+
+#include <QByteArray>
+#include <QString>
+#include <QVarLengthArray>
+
+namespace Folks
+{
+
+// A UTF-8 copy of a QString to hand to GLib and Folks, valid for as long as
+// the Utf8 object lives. Unlike toUtf8().data() it can be kept in a local
+// variable without dangling.
+//
+// Strings short enough are encoded into a buffer on the stack, so the
+// usual short values (names, numbers, addresses) never touch the heap.
+// ASCII strings are copied byte by byte without any further decoding.
+class Utf8
+{
+public:
+    enum { StackSize = 256 };
+
+    explicit Utf8(const QString &string);
+
+    const char *data() const { return m_buffer.constData(); }
+    // In bytes, without the terminating NUL
+    int size() const { return m_buffer.size() - 1; }
+    operator const char *() const { return data(); }
+
+    // QString::fromUtf8(), returning the same shared QString every time a
+    // string is seen again. Only meant for small vocabularies like store
+    // ids and field parameters: nothing is ever removed from the cache.
+    // Can be called from any thread.
+    static QString cached(const QByteArray &utf8);
+
+private:
+    Q_DISABLE_COPY(Utf8)
+
+    QVarLengthArray<char, StackSize> m_buffer;
+};
+
+} // namespace Folks
+
+#endif // UTF8_H
@@ -17,252 +17,173 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
-
 #include "utils.h"
 #include <QContactDetail>
 #include <QContactAddress>
 #include <QContactOnlineAccount>
 #include <QContactPhoneNumber>
 
+#include <cstddef>
+
 QTCONTACTS_USE_NAMESPACE
 
-QStringList Utils::contextsFromEnums(const QList<int> &contexts)
-{
-    QStringList strings;
+namespace {
 
-    Q_FOREACH(int context, contexts) {
-        switch (context) {
-        case QContactDetail::ContextHome:
-            strings << "home";
-            break;
-        case QContactDetail::ContextWork:
-            strings << "work";
-            break;
-        default:
-            strings << "other";
-        }
+struct Name
+{
+    int value;
+    const char *name;
+};
+
+// None of the tables has more than a dozen entries, a linear scan over a
+// constant array beats any tree or hash lookup at that size.
+
+constexpr Name contextNames[] = {
+    { QContactDetail::ContextHome, "home" },
+    { QContactDetail::ContextWork, "work" },
+    { QContactDetail::ContextOther, "other" }
+};
+
+constexpr Name addressSubTypeNames[] = {
+    { QContactAddress::SubTypeParcel, "parcel" },
+    { QContactAddress::SubTypePostal, "postal" },
+    { QContactAddress::SubTypeDomestic, "domestic" },
+    { QContactAddress::SubTypeInternational, "international" }
+};
+
+constexpr Name protocolNames[] = {
+    { QContactOnlineAccount::ProtocolAim, "aim" },
+    { QContactOnlineAccount::ProtocolIcq, "icq" },
+    { QContactOnlineAccount::ProtocolIrc, "irc" },
+    { QContactOnlineAccount::ProtocolJabber, "jabber" },
+    { QContactOnlineAccount::ProtocolMsn, "msn" },
+    { QContactOnlineAccount::ProtocolQq, "qq" },
+    { QContactOnlineAccount::ProtocolSkype, "skype" },
+    { QContactOnlineAccount::ProtocolYahoo, "yahoo" }
+};
+
+constexpr Name onlineAccountSubTypeNames[] = {
+    { QContactOnlineAccount::SubTypeSip, "sip" },
+    { QContactOnlineAccount::SubTypeSipVoip, "sipvoip" },
+    { QContactOnlineAccount::SubTypeImpp, "impp" },
+    { QContactOnlineAccount::SubTypeVideoShare, "videoshare" }
+};
+
+constexpr Name phoneSubTypeNames[] = {
+    { QContactPhoneNumber::SubTypeLandline, "landline" },
+    { QContactPhoneNumber::SubTypeMobile, "mobile" },
+    { QContactPhoneNumber::SubTypeFax, "fax" },
+    { QContactPhoneNumber::SubTypePager, "pager" },
+    { QContactPhoneNumber::SubTypeVoice, "voice" },
+    { QContactPhoneNumber::SubTypeModem, "modem" },
+    { QContactPhoneNumber::SubTypeVideo, "video" },
+    { QContactPhoneNumber::SubTypeCar, "car" },
+    { QContactPhoneNumber::SubTypeBulletinBoardSystem, "bulletinboard" },
+    { QContactPhoneNumber::SubTypeMessagingCapable, "messaging" },
+    { QContactPhoneNumber::SubTypeAssistant, "assistant" },
+    { QContactPhoneNumber::SubTypeDtmfMenu, "dtmfmenu" }
+};
+
+template<std::size_t N>
+const char *nameOf(const Name (&table)[N], int value)
+{
+    for(std::size_t i = 0; i < N; ++i) {
+        if(table[i].value == value)
+            return table[i].name;
     }
-
-    return strings;
+    return 0;
 }
 
-QList<int> Utils::contextsFromStrings(const QStringList &contexts)
+template<std::size_t N>
+bool valueOf(const Name (&table)[N], const QByteArray &name, int *value)
 {
-    QList<int> values;
-
-    Q_FOREACH(const QString &context, contexts) {
-        if (context == "home") {
-            values << QContactDetail::ContextHome;
-        } else if (context == "work") {
-            values << QContactDetail::ContextWork;
-        } else if (context == "other") {
-            values << QContactDetail::ContextOther;
+    for(std::size_t i = 0; i < N; ++i) {
+        if(name == table[i].name) {
+            *value = table[i].value;
+            return true;
         }
     }
-
-    return values;
+    return false;
 }
 
-QStringList Utils::addressSubTypesFromEnums(const QList<int> subTypes)
+template<std::size_t N>
+void namesOf(const Name (&table)[N], const QList<int> &values,
+        QList<const char *> *names)
 {
-    static QMap<int, QString> map;
-
-    // populate the map once
-    if (map.isEmpty()) {
-        map[QContactAddress::SubTypeParcel] = "parcel";
-        map[QContactAddress::SubTypePostal] = "postal";
-        map[QContactAddress::SubTypeDomestic] = "domestic";
-        map[QContactAddress::SubTypeInternational] = "international";
-    }
-
-    QStringList strings;
-
-    Q_FOREACH(int subType, subTypes) {
-        if (map.contains(subType)) {
-            strings << map[subType];
-        }
+    Q_FOREACH(int value, values) {
+        const char *name = nameOf(table, value);
+        if(name)
+            *names << name;
     }
-
-    return strings;
-
 }
 
-QList<int> Utils::addressSubTypesFromStrings(const QStringList &subTypes)
+template<std::size_t N>
+void valuesOf(const Name (&table)[N], const QList<QByteArray> &names,
+        QList<int> *values)
 {
-    static QMap<QString, int> map;
-
-    // populate the map once
-    if (map.isEmpty()) {
-        map["parcel"] = QContactAddress::SubTypeParcel;
-        map["postal"] = QContactAddress::SubTypePostal;
-        map["domestic"] = QContactAddress::SubTypeDomestic;
-        map["international"] = QContactAddress::SubTypeInternational;
-    }
-
-    QList<int> values;
-
-    Q_FOREACH(const QString &subType, subTypes) {
-        if (map.contains(subType)) {
-            values << map[subType];
-        }
+    Q_FOREACH(const QByteArray &name, names) {
+        int value;
+        if(valueOf(table, name, &value))
+            *values << value;
     }
+}
 
-    return values;
 }
 
-QString Utils::onlineAccountProtocolFromEnum(QContactOnlineAccount::Protocol protocol)
+void Utils::contextsFromEnums(const QList<int> &contexts, QList<const char *> *names)
 {
-    static QMap<QContactOnlineAccount::Protocol, QString> map;
-
-    // populate the map once
-    if (map.isEmpty()) {
-        map[QContactOnlineAccount::ProtocolAim] = "aim";
-        map[QContactOnlineAccount::ProtocolIcq] = "icq";
-        map[QContactOnlineAccount::ProtocolIrc] = "irc";
-        map[QContactOnlineAccount::ProtocolJabber] = "jabber";
-        map[QContactOnlineAccount::ProtocolMsn] = "msn";
-        map[QContactOnlineAccount::ProtocolQq] = "qq";
-        map[QContactOnlineAccount::ProtocolSkype] = "skype";
-        map[QContactOnlineAccount::ProtocolYahoo] = "yahoo";
+    Q_FOREACH(int context, contexts) {
+        const char *name = nameOf(contextNames, context);
+        *names << (name ? name : "other");
     }
+}
 
-    if (map.contains(protocol)) {
-        return map[protocol];
-    }
+void Utils::contextsFromStrings(const QList<QByteArray> &contexts, QList<int> *values)
+{
+    valuesOf(contextNames, contexts, values);
+}
 
-    return QString::null;
+void Utils::addressSubTypesFromEnums(const QList<int> &subTypes, QList<const char *> *names)
+{
+    namesOf(addressSubTypeNames, subTypes, names);
 }
 
-QContactOnlineAccount::Protocol Utils::onlineAccountProtocolFromString(const QString &protocol)
+void Utils::addressSubTypesFromStrings(const QList<QByteArray> &subTypes, QList<int> *values)
 {
-    static QMap<QString, QContactOnlineAccount::Protocol> map;
+    valuesOf(addressSubTypeNames, subTypes, values);
+}
 
-    // populate the map once
-    if (map.isEmpty()) {
-        map["aim"] = QContactOnlineAccount::ProtocolAim;
-        map["icq"] = QContactOnlineAccount::ProtocolIcq;
-        map["irc"] = QContactOnlineAccount::ProtocolIrc;
-        map["jabber"] = QContactOnlineAccount::ProtocolJabber;
-        map["msn"] = QContactOnlineAccount::ProtocolMsn;
-        map["qq"] = QContactOnlineAccount::ProtocolQq;
-        map["skype"] = QContactOnlineAccount::ProtocolSkype;
-        map["yahoo"] = QContactOnlineAccount::ProtocolYahoo;
-    }
+const char *Utils::onlineAccountProtocolFromEnum(QContactOnlineAccount::Protocol protocol)
+{
+    const char *name = nameOf(protocolNames, protocol);
+    return name ? name : "";
+}
 
-    if (map.contains(protocol)) {
-        return map[protocol];
-    }
+QContactOnlineAccount::Protocol Utils::onlineAccountProtocolFromString(const QByteArray &protocol)
+{
+    int value;
+    if(valueOf(protocolNames, protocol, &value))
+        return QContactOnlineAccount::Protocol(value);
 
     return QContactOnlineAccount::ProtocolUnknown;
 }
 
-QStringList Utils::onlineAccountSubTypesFromEnums(const QList<int> subTypes)
+void Utils::onlineAccountSubTypesFromEnums(const QList<int> &subTypes, QList<const char *> *names)
 {
-    static QMap<int, QString> map;
-
-    // populate the map once
-    if (map.isEmpty()) {
-        map[QContactOnlineAccount::SubTypeSip] = "sip";
-        map[QContactOnlineAccount::SubTypeSipVoip] = "sipvoip";
-        map[QContactOnlineAccount::SubTypeImpp] = "impp";
-        map[QContactOnlineAccount::SubTypeVideoShare] = "videoshare";
-    }
-
-    QStringList strings;
-
-    Q_FOREACH(int subType, subTypes) {
-        if (map.contains(subType)) {
-            strings << map[subType];
-        }
-    }
-
-    return strings;
-
+    namesOf(onlineAccountSubTypeNames, subTypes, names);
 }
 
-QList<int> Utils::onlineAccountSubTypesFromStrings(const QStringList &subTypes)
+void Utils::onlineAccountSubTypesFromStrings(const QList<QByteArray> &subTypes, QList<int> *values)
 {
-    static QMap<QString, int> map;
-
-    // populate the map once
-    if (map.isEmpty()) {
-        map["sip"] = QContactOnlineAccount::SubTypeSip;
-        map["sipvoip"] = QContactOnlineAccount::SubTypeSipVoip;
-        map["impp"] = QContactOnlineAccount::SubTypeImpp;
-        map["videoshare"] = QContactOnlineAccount::SubTypeVideoShare;
-    }
-
-    QList<int> values;
-
-    Q_FOREACH(const QString &subType, subTypes) {
-        if (map.contains(subType)) {
-            values << map[subType];
-        }
-    }
-
-    return values;
+    valuesOf(onlineAccountSubTypeNames, subTypes, values);
 }
 
-
-QStringList Utils::phoneSubTypesFromEnums(const QList<int> subTypes)
+void Utils::phoneSubTypesFromEnums(const QList<int> &subTypes, QList<const char *> *names)
 {
-    static QMap<int, QString> map;
-
-    // populate the map once
-    if (map.isEmpty()) {
-        map[QContactPhoneNumber::SubTypeLandline] = "landline";
-        map[QContactPhoneNumber::SubTypeMobile] = "mobile";
-        map[QContactPhoneNumber::SubTypeFax] = "fax";
-        map[QContactPhoneNumber::SubTypePager] = "pager";
-        map[QContactPhoneNumber::SubTypeVoice] = "voice";
-        map[QContactPhoneNumber::SubTypeModem] = "modem";
-        map[QContactPhoneNumber::SubTypeVideo] = "video";
-        map[QContactPhoneNumber::SubTypeCar] = "car";
-        map[QContactPhoneNumber::SubTypeBulletinBoardSystem] = "bulletinboard";
-        map[QContactPhoneNumber::SubTypeMessagingCapable] = "messaging";
-        map[QContactPhoneNumber::SubTypeAssistant] = "assistant";
-        map[QContactPhoneNumber::SubTypeDtmfMenu] = "dtmfmenu";
-    }
-
-    QStringList strings;
-
-    Q_FOREACH(int subType, subTypes) {
-        if (map.contains(subType)) {
-            strings << map[subType];
-        }
-    }
-
-    return strings;
+    namesOf(phoneSubTypeNames, subTypes, names);
 }
 
-
-QList<int> Utils::phoneSubTypesFromStrings(const QStringList &subTypes)
+void Utils::phoneSubTypesFromStrings(const QList<QByteArray> &subTypes, QList<int> *values)
 {
-    static QMap<QString, int> map;
-
-    // populate the map once
-    if (map.isEmpty()) {
-        map["landline"] = QContactPhoneNumber::SubTypeLandline;
-        map["mobile"] = QContactPhoneNumber::SubTypeMobile;
-        map["fax"] = QContactPhoneNumber::SubTypeFax;
-        map["pager"] = QContactPhoneNumber::SubTypePager;
-        map["voice"] = QContactPhoneNumber::SubTypeVoice;
-        map["modem"] = QContactPhoneNumber::SubTypeModem;
-        map["video"] = QContactPhoneNumber::SubTypeVideo;
-        map["car"] = QContactPhoneNumber::SubTypeCar;
-        map["bulletinboard"] = QContactPhoneNumber::SubTypeBulletinBoardSystem;
-        map["messaging"] = QContactPhoneNumber::SubTypeMessagingCapable;
-        map["assistant"] = QContactPhoneNumber::SubTypeAssistant;
-        map["dtmfmenu"] = QContactPhoneNumber::SubTypeDtmfMenu;
-    }
-
-    QList<int> values;
-
-    Q_FOREACH(const QString &subType, subTypes) {
-        if (map.contains(subType)) {
-            values << map[subType];
-        }
-    }
-
-    return values;
+    valuesOf(phoneSubTypeNames, subTypes, values);
 }
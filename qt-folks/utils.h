@@ -20,28 +20,38 @@
 #ifndef UTILS_H
 #define UTILS_H
 
-#include <QStringList>
+#include <QByteArray>
+#include <QList>
 #include <QContactOnlineAccount>
 
 QTCONTACTS_USE_NAMESPACE
 
+// Conversions between the vCard type parameters Folks uses and the
+// QtContacts context, sub-type and protocol enums.
+//
+// The lookup tables are constexpr arrays, initialized at compile time and
+// never modified, so all of these can be called from any thread. Results are
+// appended to the caller's list, so the contexts and sub-types of one field
+// are collected without building intermediate lists. Names are returned as
+// the static UTF-8 strings of the tables, ready to be handed to Folks.
 class Utils
 {
 public:
-static QStringList contextsFromEnums(const QList<int> &contexts);
-static QList<int> contextsFromStrings(const QStringList &contexts);
+static void contextsFromEnums(const QList<int> &contexts, QList<const char *> *names);
+static void contextsFromStrings(const QList<QByteArray> &contexts, QList<int> *values);
 
-static QStringList addressSubTypesFromEnums(const QList<int> subTypes);
-static QList<int> addressSubTypesFromStrings(const QStringList &subTypes);
+static void addressSubTypesFromEnums(const QList<int> &subTypes, QList<const char *> *names);
+static void addressSubTypesFromStrings(const QList<QByteArray> &subTypes, QList<int> *values);
 
-static QString onlineAccountProtocolFromEnum(QContactOnlineAccount::Protocol protocol);
-static QContactOnlineAccount::Protocol onlineAccountProtocolFromString(const QString &protocol);
+// An empty string for protocols Folks has no name for
+static const char *onlineAccountProtocolFromEnum(QContactOnlineAccount::Protocol protocol);
+static QContactOnlineAccount::Protocol onlineAccountProtocolFromString(const QByteArray &protocol);
 
-static QStringList onlineAccountSubTypesFromEnums(const QList<int> subTypes);
-static QList<int> onlineAccountSubTypesFromStrings(const QStringList &subTypes);
+static void onlineAccountSubTypesFromEnums(const QList<int> &subTypes, QList<const char *> *names);
+static void onlineAccountSubTypesFromStrings(const QList<QByteArray> &subTypes, QList<int> *values);
 
-static QStringList phoneSubTypesFromEnums(const QList<int> subTypes);
-static QList<int> phoneSubTypesFromStrings(const QStringList &subTypes);
+static void phoneSubTypesFromEnums(const QList<int> &subTypes, QList<const char *> *names);
+static void phoneSubTypesFromStrings(const QList<QByteArray> &subTypes, QList<int> *values);
 };
 
 #endif
@@ -0,0 +1,319 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QFile>
+#include <QHash>
+#include <QTextStream>
+#include <QVector>
+#include "addressbook.h"
+
+namespace
+{
+
+const char *const FirstNames[] = {
+    "Aino", "Alexander", "Amelia", "Anna", "Ben", "Camille", "Carlos",
+    "Chloe", "Daniel", "Elena", "Emil", "Emma", "Fatima", "Felix", "Hannah",
+    "Hiroshi", "Ines", "Isaac", "Jakob", "Jana", "Joao", "Julia", "Kai",
+    "Laura", "Leon", "Lucia", "Marta", "Mateo", "Mia", "Noah", "Olga", "Omar",
+    "Paul", "Priya", "Rafael", "Sara", "Sofia", "Tomas", "Yuki", "Zoe"
+};
+
+const char *const LastNames[] = {
+    "Andersson", "Bauer", "Becker", "Costa", "Dubois", "Fischer", "Garcia",
+    "Hansen", "Ivanova", "Jensen", "Kim", "Kowalski", "Lambert", "Larsen",
+    "Lopez", "Martin", "Meyer", "Moreau", "Muller", "Nakamura", "Nielsen",
+    "Novak", "Oliveira", "Petrov", "Rossi", "Santos", "Schmidt", "Silva",
+    "Suzuki", "Tanaka", "Virtanen", "Wagner", "Weber", "Wong", "Yilmaz"
+};
+
+const char *const Domains[] = {
+    "example.com", "example.net", "example.org", "mail.example",
+    "work.example"
+};
+
+const char *const Protocols[] = {
+    "jabber", "aim", "msn", "yahoo", "skype", "irc"
+};
+
+// xorshift32, so that an address book is the same everywhere
+class Random
+{
+public:
+    explicit Random(quint32 seed) : m_state(seed ? seed : 0x9e3779b9) {}
+
+    quint32 next()
+    {
+        m_state ^= m_state << 13;
+        m_state ^= m_state >> 17;
+        m_state ^= m_state << 5;
+        return m_state;
+    }
+
+    int bounded(int n) { return n > 0 ? int(next() % quint32(n)) : 0; }
+    bool percent(int p) { return bounded(100) < p; }
+
+    template <typename T, int N>
+    QString pick(T (&values)[N]) { return QString::fromLatin1(values[bounded(N)]); }
+
+private:
+    quint32 m_state;
+};
+
+QString phoneNumber(Random &random)
+{
+    QString number = QStringLiteral("+%1 ").arg(1 + random.bounded(98));
+    for(int i = 0; i < 9; ++i)
+        number += QChar('0' + random.bounded(10));
+    return number;
+}
+
+QString imAddress(Random &random, const QString &user)
+{
+    return QStringLiteral("%1.%2@%3").arg(user)
+        .arg(random.bounded(100000)).arg(random.pick(Domains));
+}
+
+// GKeyFile escaping; generated values never contain the ';' list separator
+QString keyFileValue(const QString &value)
+{
+    QString escaped = value;
+    escaped.replace(QLatin1Char('\\'), QLatin1String("\\\\"));
+    escaped.replace(QLatin1Char('\n'), QLatin1String("\\n"));
+    if(escaped.startsWith(QLatin1Char(' ')))
+        escaped.replace(0, 1, QLatin1String("\\s"));
+    return escaped;
+}
+
+} // anonymous namespace
+
+AddressBook::AddressBook(const Options &options)
+    : m_options(options)
+{
+    Random random(options.seed);
+
+    for(int i = 0; i < options.individuals; ++i) {
+        const QString first = random.pick(FirstNames);
+        const QString last = random.pick(LastNames);
+        const QString user = first.toLower() + QLatin1Char('.') + last.toLower();
+
+        Individual individual;
+        individual.linkAddress = QStringLiteral("%1.%2@link.example").arg(user).arg(i);
+
+        for(int j = 0; j < options.personas; ++j) {
+            Persona persona;
+            persona.id = QStringLiteral("%1-%2").arg(i).arg(j);
+            persona.fullName = first + QLatin1Char(' ') + last;
+            // Only the first persona carries the full name as alias, the
+            // others look like the nicknames other address books have
+            persona.alias = j == 0 ? persona.fullName
+                : random.bounded(2) ? first
+                : first + QLatin1Char(' ') + last.left(1) + QLatin1Char('.');
+
+            for(int k = 0; k < options.phones; ++k)
+                persona.phones << phoneNumber(random);
+            for(int k = 0; k < options.emails; ++k)
+                persona.emails << QStringLiteral("%1%2@%3").arg(user)
+                    .arg(k ? QString::number(k) : QString())
+                    .arg(random.pick(Domains));
+
+            persona.ims << qMakePair(QStringLiteral("jabber"), individual.linkAddress);
+            for(int k = 0; k < options.ims; ++k)
+                persona.ims << qMakePair(random.pick(Protocols), imAddress(random, user));
+
+            if(random.percent(options.avatarPercent))
+                persona.avatar = QStringLiteral("file:///usr/share/avatars/%1.png")
+                    .arg(random.bounded(1000));
+            persona.favourite = random.percent(10);
+
+            individual.personas << persona;
+        }
+        m_individuals << individual;
+    }
+
+    if(m_individuals.isEmpty() || options.personas <= 0)
+        return;
+
+    // What the script did to each persona so far, so that it only removes
+    // personas which are there and only links personas which were unlinked
+    QVector<QVector<bool> > removed(options.individuals,
+            QVector<bool>(options.personas, false));
+    QVector<QVector<bool> > unlinked = removed;
+
+    for(int n = 0; n < options.changes; ++n) {
+        Change change;
+        change.time = options.changeRate > 0 ? qint64(n) * 1000 / options.changeRate : 0;
+        change.individual = random.bounded(options.individuals);
+        change.persona = random.bounded(options.personas);
+
+        bool &isRemoved = removed[change.individual][change.persona];
+        bool &isUnlinked = unlinked[change.individual][change.persona];
+        const Persona &persona = m_individuals.at(change.individual)
+            .personas.at(change.persona);
+
+        const int roll = random.bounded(100);
+        if(isRemoved) {
+            change.kind = Change::Add;
+        } else if(roll < 35) {
+            change.kind = Change::Alias;
+            change.value = QStringLiteral("%1 %2").arg(persona.alias).arg(n);
+        } else if(roll < 55) {
+            change.kind = Change::Favourite;
+            change.value = random.bounded(2) ? QStringLiteral("1") : QStringLiteral("0");
+        } else if(roll < 80) {
+            change.kind = Change::ImAddress;
+            change.value = imAddress(random, QStringLiteral("changed"));
+        } else if(roll < 90) {
+            change.kind = isUnlinked ? Change::Link : Change::Unlink;
+        } else {
+            change.kind = Change::Remove;
+        }
+
+        switch(change.kind) {
+        case Change::Unlink:
+            isUnlinked = true;
+            break;
+        case Change::Link:
+            isUnlinked = false;
+            break;
+        case Change::Remove:
+            isRemoved = true;
+            break;
+        case Change::Add:
+            // Comes back linked again
+            isRemoved = false;
+            isUnlinked = false;
+            break;
+        default:
+            break;
+        }
+
+        m_changes << change;
+    }
+}
+
+bool AddressBook::writeKeyFile(const QString &path) const
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    foreach(const Individual &individual, m_individuals) {
+        foreach(const Persona &persona, individual.personas) {
+            out << '[' << persona.id << "]\n";
+
+            // One key per protocol, holding a list of addresses
+            QStringList protocols;
+            QHash<QString, QString> addresses;
+            typedef QPair<QString, QString> Im;
+            foreach(const Im &im, persona.ims) {
+                if(!addresses.contains(im.first))
+                    protocols << im.first;
+                addresses[im.first] += keyFileValue(im.second) + QLatin1Char(';');
+            }
+            foreach(const QString &protocol, protocols)
+                out << protocol << '=' << addresses.value(protocol) << '\n';
+
+            out << "__alias=" << keyFileValue(persona.alias) << "\n\n";
+        }
+    }
+
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+QString AddressBook::kindName(Change::Kind kind)
+{
+    switch(kind) {
+    case Change::Alias:
+        return QStringLiteral("alias");
+    case Change::Favourite:
+        return QStringLiteral("favourite");
+    case Change::ImAddress:
+        return QStringLiteral("im");
+    case Change::Unlink:
+        return QStringLiteral("unlink");
+    case Change::Link:
+        return QStringLiteral("link");
+    case Change::Remove:
+        return QStringLiteral("remove");
+    case Change::Add:
+        return QStringLiteral("add");
+    }
+    return QString();
+}
+
+bool AddressBook::writeChanges(const QString &path) const
+{
+    QFile file(path);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out << "# seed " << m_options.seed << ", " << m_changes.size()
+        << " changes at " << m_options.changeRate << "/s\n";
+    foreach(const Change &change, m_changes) {
+        out << change.time << ' ' << kindName(change.kind) << ' '
+            << change.individual << ' ' << change.persona;
+        if(!change.value.isEmpty())
+            out << ' ' << change.value;
+        out << '\n';
+    }
+
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+bool AddressBook::readChanges(const QString &path, QList<Change> *changes)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return false;
+
+    QHash<QString, Change::Kind> kinds;
+    for(int kind = Change::Alias; kind <= Change::Add; ++kind)
+        kinds.insert(kindName(Change::Kind(kind)), Change::Kind(kind));
+
+    QTextStream in(&file);
+    in.setCodec("UTF-8");
+    while(!in.atEnd()) {
+        const QString line = in.readLine().trimmed();
+        if(line.isEmpty() || line.startsWith(QLatin1Char('#')))
+            continue;
+
+        // The value is the rest of the line and may contain spaces
+        const QStringList fields = line.split(QLatin1Char(' '));
+        if(fields.size() < 4 || !kinds.contains(fields.at(1)))
+            return false;
+
+        bool timeOk, individualOk, personaOk;
+        Change change;
+        change.time = fields.at(0).toInt(&timeOk);
+        change.kind = kinds.value(fields.at(1));
+        change.individual = fields.at(2).toInt(&individualOk);
+        change.persona = fields.at(3).toInt(&personaOk);
+        change.value = line.section(QLatin1Char(' '), 4);
+        if(!timeOk || !individualOk || !personaOk)
+            return false;
+
+        *changes << change;
+    }
+    return true;
+}
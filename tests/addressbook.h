@@ -0,0 +1,129 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef ADDRESS_BOOK_H
+#define ADDRESS_BOOK_H
+
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+
+// A synthetic address book for benchmarks and stress tests.
+//
+// Everything is derived from Options::seed, so the same options give the
+// same individuals and changes on every machine. Each individual has
+// Options::personas personas; they share the individual's link address,
+// an IM address Folks links them by. Avatars are given to
+// Options::avatarPercent of the personas.
+//
+// The changes form a timeline at Options::changeRate changes per second
+// (0 puts them all at once, like a resync), mixing property changes with
+// personas being unlinked, linked back, removed and added again. Read and
+// written as text, one change per line:
+//   <ms> <kind> <individual> <persona> [<value>]
+class AddressBook
+{
+public:
+    struct Options
+    {
+        Options()
+            : seed(1)
+            , individuals(1000)
+            , personas(1)
+            , phones(1)
+            , emails(1)
+            , ims(1)
+            , avatarPercent(50)
+            , changes(0)
+            , changeRate(100) {}
+
+        quint32 seed;
+        int individuals;
+        // Per individual
+        int personas;
+        // Per persona
+        int phones;
+        int emails;
+        int ims;
+        int avatarPercent;
+        int changes;
+        int changeRate;
+    };
+
+    struct Persona
+    {
+        // Unique in the address book, usable as a key-file group
+        QString id;
+        QString alias;
+        QString fullName;
+        QStringList phones;
+        QStringList emails;
+        // (protocol, address), the link address first
+        QList<QPair<QString, QString> > ims;
+        QString avatar;
+        bool favourite;
+    };
+
+    struct Individual
+    {
+        QString linkAddress;
+        QList<Persona> personas;
+    };
+
+    struct Change
+    {
+        enum Kind {
+            Alias,
+            Favourite,
+            ImAddress,
+            Unlink,
+            Link,
+            Remove,
+            Add
+        };
+
+        int time; // ms from the start
+        Kind kind;
+        int individual;
+        int persona;
+        QString value;
+    };
+
+    explicit AddressBook(const Options &options);
+
+    const Options &options() const { return m_options; }
+    const QList<Individual> &individuals() const { return m_individuals; }
+    const QList<Change> &changes() const { return m_changes; }
+
+    // Key-file stores have no phones, emails or avatars, only the aliases
+    // and IM addresses are written
+    bool writeKeyFile(const QString &path) const;
+
+    bool writeChanges(const QString &path) const;
+    static bool readChanges(const QString &path, QList<Change> *changes);
+
+    static QString kindName(Change::Kind kind);
+
+private:
+    Options m_options;
+    QList<Individual> m_individuals;
+    QList<Change> m_changes;
+};
+
+#endif // ADDRESS_BOOK_H
@@ -1,60 +0,0 @@
-/*
- * Copyright (C) 2010-2011 Collabora Ltd.
- *   @author Travis Reitter <travis.reitter@collabora.co.uk>
- *   @author Marco Barisione <marco.barisione@collabora.co.uk>
- *
- * This program is free software; you can redistribute it and/or
- * modify it under the terms of the GNU Lesser General Public
- * License as published by the Free Software Foundation; either
- * version 2.1 of the License, or (at your option) any later version.
- *
- * This library is distributed in the hope that it will be useful,
- * but WITHOUT ANY WARRANTY; without even the implied warranty of
- * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
- * Lesser General Public License for more details.
- *
- * You should have received a copy of the GNU Lesser General Public
- * License along with this library; if not, write to the Free Software
- * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
- */
-
-#include <QContactManager>
-
-#ifndef CONTACT_RETRIEVAL_H
-#define CONTACT_RETRIEVAL_H
-
-QTM_BEGIN_NAMESPACE
-class QContactManager;
-QTM_END_NAMESPACE
-
-QT_USE_NAMESPACE
-QTM_USE_NAMESPACE
-
-class TestContactRetrieval : public QObject
-{
-    Q_OBJECT
-
-public:
-    TestContactRetrieval(QCoreApplication *app);
-
-    QCoreApplication& app() { return *mApp; }
-    QContactManager& manager() { return *mManager; }
-
-public Q_SLOTS:
-    void testContactRetrieval();
-
-private:
-    QCoreApplication *mApp;
-    QContactManager *mManager;
-    QHash<QString, QString> mExpectedContacts;
-
-    QList<QContact> contactsFromIds(const QList<QContactLocalId>& ids);
-
-private Q_SLOTS:
-    void timeout();
-    void contactsAdded(const QList<QContactLocalId>& ids);
-    void contactsRemoved(const QList<QContactLocalId>& ids);
-    void contactsChanged(const QList<QContactLocalId>& ids);
-};
-
-#endif // CONTACT_RETRIEVAL_H
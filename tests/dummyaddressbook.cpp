@@ -0,0 +1,334 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "dummyaddressbook.h"
+#include <QDebug>
+
+namespace
+{
+
+guint fieldDetailsHash(gconstpointer v, gpointer)
+{
+    return folks_abstract_field_details_hash_static(
+            FOLKS_ABSTRACT_FIELD_DETAILS(const_cast<gpointer>(v)));
+}
+
+gboolean fieldDetailsEqual(gconstpointer a, gconstpointer b, gpointer)
+{
+    return folks_abstract_field_details_equal_static(
+            FOLKS_ABSTRACT_FIELD_DETAILS(const_cast<gpointer>(a)),
+            FOLKS_ABSTRACT_FIELD_DETAILS(const_cast<gpointer>(b)));
+}
+
+guint stringHash(gconstpointer v, gpointer)
+{
+    return g_str_hash(v);
+}
+
+gboolean stringEqual(gconstpointer a, gconstpointer b, gpointer)
+{
+    return g_str_equal(a, b);
+}
+
+GeeSet *objectSet(GType type)
+{
+    return GEE_SET(gee_hash_set_new(type,
+                (GBoxedCopyFunc) g_object_ref, g_object_unref,
+                NULL, NULL, NULL, NULL, NULL, NULL));
+}
+
+GeeSet *fieldDetailsSet(GType type, const QStringList &values)
+{
+    GeeSet *set = GEE_SET(gee_hash_set_new(type,
+                (GBoxedCopyFunc) g_object_ref, g_object_unref,
+                fieldDetailsHash, NULL, NULL,
+                fieldDetailsEqual, NULL, NULL));
+
+    foreach(const QString &value, values) {
+        const QByteArray utf8 = value.toUtf8();
+        FolksAbstractFieldDetails *details = type == FOLKS_TYPE_PHONE_FIELD_DETAILS
+            ? FOLKS_ABSTRACT_FIELD_DETAILS(folks_phone_field_details_new(utf8.constData(), NULL))
+            : FOLKS_ABSTRACT_FIELD_DETAILS(folks_email_field_details_new(utf8.constData(), NULL));
+        gee_collection_add(GEE_COLLECTION(set), details);
+        g_object_unref(details);
+    }
+    return set;
+}
+
+void loadBackendsCb(GObject *source, GAsyncResult *result, gpointer userdata)
+{
+    GError *error = NULL;
+    folks_backend_store_load_backends_finish(FOLKS_BACKEND_STORE(source), result, &error);
+    if(error) {
+        qWarning() << "Loading the Folks backends failed:" << error->message;
+        g_error_free(error);
+    }
+    *static_cast<bool*>(userdata) = true;
+}
+
+} // anonymous namespace
+
+DummyAddressBook::DummyAddressBook(
+        const AddressBook &book,
+        const QString &storeId)
+    : m_personasPerIndividual(book.options().personas)
+    , m_backend(0)
+    , m_store(0)
+{
+    FolksBackendStore *backendStore = folks_backend_store_dup();
+    if(loadBackend(backendStore))
+        m_backend = FOLKS_DUMMY_BACKEND(
+                folks_backend_store_dup_backend_by_name(backendStore, "dummy"));
+    g_object_unref(backendStore);
+
+    if(!m_backend) {
+        qWarning() << "The Folks dummy backend isn't available";
+        return;
+    }
+
+    const QByteArray id = storeId.toUtf8();
+    m_store = folks_dummy_persona_store_new(id.constData(), id.constData(), NULL, 0);
+    folks_dummy_persona_store_set_persona_type(m_store, FOLKS_DUMMY_TYPE_FULL_PERSONA);
+
+    GeeSet *stores = objectSet(FOLKS_TYPE_PERSONA_STORE);
+    gee_collection_add(GEE_COLLECTION(stores), m_store);
+    folks_dummy_backend_register_persona_stores(m_backend, stores, TRUE);
+    g_object_unref(stores);
+
+    // All personas are registered at once, like a store loading them
+    QList<FolksDummyFullPersona*> personas;
+    m_states.reserve(book.individuals().size() * m_personasPerIndividual);
+    foreach(const AddressBook::Individual &individual, book.individuals()) {
+        foreach(const AddressBook::Persona &details, individual.personas) {
+            State state;
+            state.details = details;
+            state.unlinked = false;
+            state.persona = createPersona(state);
+            personas << state.persona;
+            m_states << state;
+        }
+    }
+    registerPersonas(personas, true);
+
+    folks_dummy_persona_store_reach_quiescence(m_store);
+}
+
+DummyAddressBook::~DummyAddressBook()
+{
+    foreach(const State &state, m_states) {
+        if(state.persona)
+            g_object_unref(state.persona);
+    }
+
+    if(m_store) {
+        GeeSet *stores = objectSet(FOLKS_TYPE_PERSONA_STORE);
+        gee_collection_add(GEE_COLLECTION(stores), m_store);
+        folks_dummy_backend_unregister_persona_stores(m_backend, stores, TRUE);
+        g_object_unref(stores);
+        g_object_unref(m_store);
+    }
+    if(m_backend)
+        g_object_unref(m_backend);
+}
+
+bool DummyAddressBook::loadBackend(FolksBackendStore *backendStore)
+{
+    bool done = false;
+    folks_backend_store_load_backends(backendStore, loadBackendsCb, &done);
+    while(!done)
+        g_main_context_iteration(g_main_context_default(), TRUE);
+
+    return folks_backend_store_get_is_prepared(backendStore);
+}
+
+FolksDummyFullPersona *DummyAddressBook::persona(
+        int individual,
+        int persona) const
+{
+    if(persona < 0 || persona >= m_personasPerIndividual)
+        return 0;
+
+    const int index = individual * m_personasPerIndividual + persona;
+    return index >= 0 && index < m_states.size() ? m_states.at(index).persona : 0;
+}
+
+QString DummyAddressBook::individualId(
+        int individual,
+        int persona) const
+{
+    FolksDummyFullPersona *dummy = this->persona(individual, persona);
+    FolksIndividual *folksIndividual = dummy
+        ? folks_persona_get_individual(FOLKS_PERSONA(dummy)) : 0;
+    return folksIndividual
+        ? QString::fromUtf8(folks_individual_get_id(folksIndividual)) : QString();
+}
+
+FolksDummyFullPersona *DummyAddressBook::createPersona(
+        const State &state) const
+{
+    // Individuals are made by linking on the shared link address
+    static const char *linkable[] = { "im-addresses" };
+
+    const AddressBook::Persona &details = state.details;
+    const QByteArray id = details.id.toUtf8();
+    FolksDummyFullPersona *persona = folks_dummy_full_persona_new(
+            m_store, id.constData(), FALSE,
+            const_cast<gchar**>(linkable), G_N_ELEMENTS(linkable));
+
+    folks_dummy_full_persona_update_alias(persona, details.alias.toUtf8().constData());
+    folks_dummy_full_persona_update_full_name(persona, details.fullName.toUtf8().constData());
+    folks_dummy_full_persona_update_is_favourite(persona, details.favourite);
+
+    GeeSet *phones = fieldDetailsSet(FOLKS_TYPE_PHONE_FIELD_DETAILS, details.phones);
+    folks_dummy_full_persona_update_phone_numbers(persona, phones);
+    g_object_unref(phones);
+
+    GeeSet *emails = fieldDetailsSet(FOLKS_TYPE_EMAIL_FIELD_DETAILS, details.emails);
+    folks_dummy_full_persona_update_email_addresses(persona, emails);
+    g_object_unref(emails);
+
+    if(!details.avatar.isEmpty()) {
+        GFile *file = g_file_new_for_uri(details.avatar.toUtf8().constData());
+        GIcon *icon = g_file_icon_new(file);
+        folks_dummy_full_persona_update_avatar(persona, G_LOADABLE_ICON(icon));
+        g_object_unref(icon);
+        g_object_unref(file);
+    }
+
+    State linked = state;
+    linked.persona = persona;
+    updateImAddresses(linked);
+
+    return persona;
+}
+
+void DummyAddressBook::updateImAddresses(const State &state) const
+{
+    GeeMultiMap *addresses = GEE_MULTI_MAP(gee_hash_multi_map_new(
+                G_TYPE_STRING, (GBoxedCopyFunc) g_strdup, g_free,
+                FOLKS_TYPE_IM_FIELD_DETAILS, (GBoxedCopyFunc) g_object_ref, g_object_unref,
+                stringHash, NULL, NULL,
+                stringEqual, NULL, NULL,
+                fieldDetailsHash, NULL, NULL,
+                fieldDetailsEqual, NULL, NULL));
+
+    typedef QPair<QString, QString> Im;
+    // The link address comes first
+    const QList<Im> ims = state.unlinked ? state.details.ims.mid(1) : state.details.ims;
+    foreach(const Im &im, ims) {
+        FolksImFieldDetails *details =
+            folks_im_field_details_new(im.second.toUtf8().constData(), NULL);
+        gee_multi_map_set(addresses, im.first.toUtf8().constData(), details);
+        g_object_unref(details);
+    }
+
+    folks_dummy_full_persona_update_im_addresses(state.persona, addresses);
+    g_object_unref(addresses);
+}
+
+void DummyAddressBook::registerPersonas(
+        const QList<FolksDummyFullPersona*> &personas,
+        bool add)
+{
+    GeeSet *set = objectSet(FOLKS_TYPE_PERSONA);
+    foreach(FolksDummyFullPersona *persona, personas)
+        gee_collection_add(GEE_COLLECTION(set), persona);
+
+    if(add)
+        folks_dummy_persona_store_register_personas(m_store, set);
+    else
+        folks_dummy_persona_store_unregister_personas(m_store, set);
+    g_object_unref(set);
+}
+
+bool DummyAddressBook::apply(const AddressBook::Change &change)
+{
+    if(!m_store || change.persona < 0 || change.persona >= m_personasPerIndividual)
+        return false;
+
+    const int index = change.individual * m_personasPerIndividual + change.persona;
+    if(index < 0 || index >= m_states.size())
+        return false;
+
+    State &state = m_states[index];
+    if(!state.persona && change.kind != AddressBook::Change::Add)
+        return false;
+
+    switch(change.kind) {
+    case AddressBook::Change::Alias:
+        state.details.alias = change.value;
+        folks_dummy_full_persona_update_alias(state.persona,
+                change.value.toUtf8().constData());
+        break;
+
+    case AddressBook::Change::Favourite:
+        state.details.favourite = change.value == QLatin1String("1");
+        folks_dummy_full_persona_update_is_favourite(state.persona,
+                state.details.favourite);
+        break;
+
+    case AddressBook::Change::ImAddress:
+        // Replaces the last address, never the link address
+        if(state.details.ims.size() > 1)
+            state.details.ims.removeLast();
+        state.details.ims << qMakePair(QStringLiteral("jabber"), change.value);
+        updateImAddresses(state);
+        break;
+
+    case AddressBook::Change::Unlink:
+    case AddressBook::Change::Link:
+        state.unlinked = change.kind == AddressBook::Change::Unlink;
+        updateImAddresses(state);
+        break;
+
+    case AddressBook::Change::Remove:
+        registerPersonas(QList<FolksDummyFullPersona*>() << state.persona, false);
+        g_object_unref(state.persona);
+        state.persona = 0;
+        break;
+
+    case AddressBook::Change::Add:
+        if(state.persona)
+            return false;
+        state.unlinked = false;
+        state.persona = createPersona(state);
+        registerPersonas(QList<FolksDummyFullPersona*>() << state.persona, true);
+        break;
+    }
+
+    return true;
+}
+
+void DummyAddressBook::restore()
+{
+    QList<FolksDummyFullPersona*> added;
+    for(int i = 0; i < m_states.size(); ++i) {
+        State &state = m_states[i];
+        if(!state.persona) {
+            state.unlinked = false;
+            state.persona = createPersona(state);
+            added << state.persona;
+        } else if(state.unlinked) {
+            state.unlinked = false;
+            updateImAddresses(state);
+        }
+    }
+
+    if(!added.isEmpty())
+        registerPersonas(added, true);
+}
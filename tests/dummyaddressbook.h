@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef DUMMY_ADDRESS_BOOK_H
+#define DUMMY_ADDRESS_BOOK_H
+
+#include <folks/folks-dummy.h>
+#include <QVector>
+#include "addressbook.h"
+
+// An AddressBook in a persona store of the Folks dummy backend.
+//
+// The dummy backend lives in the process using it, so this has to be set up
+// before the aggregator of that process (the engine's, for tests going
+// through QContactManager) is prepared: the aggregator then finds all the
+// personas in its first individuals-changed, like from a loaded store.
+// FOLKS_BACKENDS_ALLOWED has to allow the dummy backend.
+//
+// Unlike key-file stores, dummy personas have phone numbers, email
+// addresses and avatars. They have no presence though, so changes are
+// limited to what AddressBook::Change covers.
+//
+// GIO has struct members named "signals", so this has to be included before
+// any Qt header defining the keyword.
+class DummyAddressBook
+{
+public:
+    explicit DummyAddressBook(const AddressBook &book,
+            const QString &storeId = QStringLiteral("dummy-store"));
+    ~DummyAddressBook();
+
+    // Whether the dummy backend could be loaded and the store registered
+    bool isValid() const { return m_store != 0; }
+
+    FolksPersonaStore *store() const { return FOLKS_PERSONA_STORE(m_store); }
+
+    // The persona as it is now, null while it is removed
+    FolksDummyFullPersona *persona(int individual, int persona) const;
+    // The Folks id of the individual the persona is in now, empty while it
+    // is removed or not aggregated yet
+    QString individualId(int individual, int persona) const;
+
+    // Applies one change of the script. Returns false if it refers to a
+    // persona the address book doesn't have.
+    bool apply(const AddressBook::Change &change);
+
+    // Adds the removed personas back and links the unlinked ones again, so
+    // that the next script starts from the whole address book
+    void restore();
+
+private:
+    struct State
+    {
+        FolksDummyFullPersona *persona;
+        AddressBook::Persona details;
+        bool unlinked;
+    };
+
+    static bool loadBackend(FolksBackendStore *backendStore);
+
+    FolksDummyFullPersona *createPersona(const State &state) const;
+    void updateImAddresses(const State &state) const;
+    void registerPersonas(const QList<FolksDummyFullPersona*> &personas, bool add);
+
+    int m_personasPerIndividual;
+    FolksDummyBackend *m_backend;
+    FolksDummyPersonaStore *m_store;
+    QVector<State> m_states;
+};
+
+#endif // DUMMY_ADDRESS_BOOK_H
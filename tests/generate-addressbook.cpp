@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+// Writes a generated address book as a key-file store and its change
+// script, e.g. for the key-file backend:
+//   generate-addressbook --individuals 5000 --personas 2 --key-file contacts.ini
+// With --dummy the address book is seeded into the dummy backend instead
+// and the individuals Folks links it into are counted.
+
+#ifdef HAVE_FOLKS_DUMMY
+#include "dummyaddressbook.h"
+#endif
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "addressbook.h"
+
+namespace
+{
+
+#ifdef HAVE_FOLKS_DUMMY
+void prepareCb(GObject *source, GAsyncResult *result, gpointer)
+{
+    GError *error = NULL;
+    folks_individual_aggregator_prepare_finish(
+            FOLKS_INDIVIDUAL_AGGREGATOR(source), result, &error);
+    if(error) {
+        qWarning() << "Preparing the aggregator failed:" << error->message;
+        g_error_free(error);
+    }
+}
+
+int seedDummy(const AddressBook &book)
+{
+    qputenv("FOLKS_BACKENDS_ALLOWED", "dummy");
+
+    QElapsedTimer timer;
+    timer.start();
+    DummyAddressBook dummy(book);
+    if(!dummy.isValid())
+        return 1;
+    const qint64 seedTime = timer.restart();
+
+    FolksIndividualAggregator *aggregator = folks_individual_aggregator_dup();
+    folks_individual_aggregator_prepare(aggregator, prepareCb, NULL);
+    while(!folks_individual_aggregator_get_is_quiescent(aggregator))
+        g_main_context_iteration(g_main_context_default(), TRUE);
+
+    QTextStream(stdout) << "Seeded "
+        << book.individuals().size() * book.options().personas << " personas in "
+        << seedTime << " ms, aggregated into "
+        << gee_map_get_size(folks_individual_aggregator_get_individuals(aggregator))
+        << " individuals in " << timer.elapsed() << " ms\n";
+
+    g_object_unref(aggregator);
+    return 0;
+}
+#endif
+
+} // anonymous namespace
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral(
+                "Generates reproducible address books for the Folks test backends"));
+    parser.addHelpOption();
+
+    const QCommandLineOption seed(QStringLiteral("seed"),
+            QStringLiteral("Random seed"), QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption individuals(QStringLiteral("individuals"),
+            QStringLiteral("Number of individuals"), QStringLiteral("n"),
+            QStringLiteral("1000"));
+    const QCommandLineOption personas(QStringLiteral("personas"),
+            QStringLiteral("Personas per individual, linked by a shared IM address"),
+            QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption phones(QStringLiteral("phones"),
+            QStringLiteral("Phone numbers per persona"), QStringLiteral("n"),
+            QStringLiteral("1"));
+    const QCommandLineOption emails(QStringLiteral("emails"),
+            QStringLiteral("Email addresses per persona"), QStringLiteral("n"),
+            QStringLiteral("1"));
+    const QCommandLineOption ims(QStringLiteral("ims"),
+            QStringLiteral("IM addresses per persona, besides the link address"),
+            QStringLiteral("n"), QStringLiteral("1"));
+    const QCommandLineOption avatars(QStringLiteral("avatars"),
+            QStringLiteral("Percentage of personas with an avatar"),
+            QStringLiteral("percent"), QStringLiteral("50"));
+    const QCommandLineOption changes(QStringLiteral("changes"),
+            QStringLiteral("Number of changes in the script"), QStringLiteral("n"),
+            QStringLiteral("0"));
+    const QCommandLineOption changeRate(QStringLiteral("change-rate"),
+            QStringLiteral("Changes per second, 0 for all at once"),
+            QStringLiteral("n"), QStringLiteral("100"));
+    const QCommandLineOption keyFile(QStringLiteral("key-file"),
+            QStringLiteral("Write a key-file store (aliases and IM addresses only)"),
+            QStringLiteral("path"));
+    const QCommandLineOption changesFile(QStringLiteral("changes-file"),
+            QStringLiteral("Write the change script"), QStringLiteral("path"));
+    const QCommandLineOption dummy(QStringLiteral("dummy"),
+            QStringLiteral("Seed the dummy backend and report how it aggregates"));
+
+    parser.addOptions(QList<QCommandLineOption>() << seed << individuals
+            << personas << phones << emails << ims << avatars << changes
+            << changeRate << keyFile << changesFile << dummy);
+    parser.process(app);
+
+    AddressBook::Options options;
+    options.seed = parser.value(seed).toUInt();
+    options.individuals = parser.value(individuals).toInt();
+    options.personas = parser.value(personas).toInt();
+    options.phones = parser.value(phones).toInt();
+    options.emails = parser.value(emails).toInt();
+    options.ims = parser.value(ims).toInt();
+    options.avatarPercent = parser.value(avatars).toInt();
+    options.changes = parser.value(changes).toInt();
+    options.changeRate = parser.value(changeRate).toInt();
+
+    if(!parser.isSet(keyFile) && !parser.isSet(changesFile) && !parser.isSet(dummy)) {
+        qWarning("Nothing to do, use --key-file, --changes-file or --dummy");
+        return 1;
+    }
+
+    const AddressBook book(options);
+
+    if(parser.isSet(keyFile) && !book.writeKeyFile(parser.value(keyFile))) {
+        qWarning("Could not write %s", qPrintable(parser.value(keyFile)));
+        return 1;
+    }
+    if(parser.isSet(changesFile) && !book.writeChanges(parser.value(changesFile))) {
+        qWarning("Could not write %s", qPrintable(parser.value(changesFile)));
+        return 1;
+    }
+
+    if(parser.isSet(dummy)) {
+#ifdef HAVE_FOLKS_DUMMY
+        return seedDummy(book);
+#else
+        qWarning("Built without the Folks dummy backend");
+        return 1;
+#endif
+    }
+
+    return 0;
+}
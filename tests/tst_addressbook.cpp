@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QTemporaryDir>
+#include <QtTest>
+#include "addressbook.h"
+
+namespace
+{
+
+AddressBook::Options options(quint32 seed)
+{
+    AddressBook::Options options;
+    options.seed = seed;
+    options.individuals = 200;
+    options.personas = 3;
+    options.phones = 2;
+    options.emails = 2;
+    options.ims = 2;
+    options.changes = 2000;
+    return options;
+}
+
+QString fingerprint(const AddressBook &book)
+{
+    QString text;
+    foreach(const AddressBook::Individual &individual, book.individuals()) {
+        foreach(const AddressBook::Persona &persona, individual.personas) {
+            text += persona.id + persona.alias + persona.fullName
+                + persona.phones.join(QString()) + persona.emails.join(QString())
+                + persona.avatar + QString::number(persona.favourite);
+        }
+    }
+    foreach(const AddressBook::Change &change, book.changes()) {
+        text += QStringLiteral("%1 %2 %3 %4 %5").arg(change.time).arg(change.kind)
+            .arg(change.individual).arg(change.persona).arg(change.value);
+    }
+    return text;
+}
+
+} // anonymous namespace
+
+class TestAddressBook : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void reproducible();
+    void counts();
+    void linkAddresses();
+    void consistentChanges();
+    void changeRate();
+    void keyFile();
+    void changesRoundTrip();
+};
+
+void TestAddressBook::reproducible()
+{
+    QCOMPARE(fingerprint(AddressBook(options(7))), fingerprint(AddressBook(options(7))));
+    QVERIFY(fingerprint(AddressBook(options(7))) != fingerprint(AddressBook(options(8))));
+}
+
+void TestAddressBook::counts()
+{
+    const AddressBook book(options(1));
+    QCOMPARE(book.individuals().size(), 200);
+    QCOMPARE(book.changes().size(), 2000);
+
+    QSet<QString> ids;
+    foreach(const AddressBook::Individual &individual, book.individuals()) {
+        QCOMPARE(individual.personas.size(), 3);
+        foreach(const AddressBook::Persona &persona, individual.personas) {
+            QCOMPARE(persona.phones.size(), 2);
+            QCOMPARE(persona.emails.size(), 2);
+            // The link address and two more
+            QCOMPARE(persona.ims.size(), 3);
+            ids.insert(persona.id);
+        }
+    }
+    QCOMPARE(ids.size(), 600);
+}
+
+void TestAddressBook::linkAddresses()
+{
+    const AddressBook book(options(1));
+
+    QSet<QString> linkAddresses;
+    foreach(const AddressBook::Individual &individual, book.individuals()) {
+        QVERIFY(!linkAddresses.contains(individual.linkAddress));
+        linkAddresses.insert(individual.linkAddress);
+        foreach(const AddressBook::Persona &persona, individual.personas)
+            QCOMPARE(persona.ims.first().second, individual.linkAddress);
+    }
+}
+
+void TestAddressBook::consistentChanges()
+{
+    const AddressBook book(options(3));
+
+    QSet<QPair<int, int> > removed;
+    QSet<QPair<int, int> > unlinked;
+    QSet<AddressBook::Change::Kind> kinds;
+    foreach(const AddressBook::Change &change, book.changes()) {
+        const QPair<int, int> persona(change.individual, change.persona);
+        kinds.insert(change.kind);
+
+        // Only added personas are touched and only removed ones are added
+        QCOMPARE(change.kind == AddressBook::Change::Add, removed.contains(persona));
+
+        switch(change.kind) {
+        case AddressBook::Change::Unlink:
+            QVERIFY(!unlinked.contains(persona));
+            unlinked.insert(persona);
+            break;
+        case AddressBook::Change::Link:
+            QVERIFY(unlinked.remove(persona));
+            break;
+        case AddressBook::Change::Remove:
+            removed.insert(persona);
+            break;
+        case AddressBook::Change::Add:
+            removed.remove(persona);
+            unlinked.remove(persona);
+            break;
+        default:
+            break;
+        }
+    }
+
+    // 2000 changes are plenty to have every kind
+    QCOMPARE(kinds.size(), int(AddressBook::Change::Add) + 1);
+}
+
+void TestAddressBook::changeRate()
+{
+    AddressBook::Options storm = options(1);
+    storm.changeRate = 0;
+    foreach(const AddressBook::Change &change, AddressBook(storm).changes())
+        QCOMPARE(change.time, 0);
+
+    AddressBook::Options steady = options(1);
+    steady.changeRate = 500;
+    const QList<AddressBook::Change> changes = AddressBook(steady).changes();
+    QCOMPARE(changes.last().time, 1999 * 1000 / 500);
+}
+
+void TestAddressBook::keyFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.path() + QStringLiteral("/contacts.ini");
+
+    const AddressBook book(options(1));
+    QVERIFY(book.writeKeyFile(path));
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    const QStringList lines = QString::fromUtf8(file.readAll()).split(QLatin1Char('\n'));
+
+    int groups = 0;
+    foreach(const QString &line, lines)
+        groups += line.startsWith(QLatin1Char('['));
+    QCOMPARE(groups, 600);
+
+    const AddressBook::Individual &individual = book.individuals().at(5);
+    const AddressBook::Persona &persona = individual.personas.at(1);
+    const int group = lines.indexOf(QLatin1Char('[') + persona.id + QLatin1Char(']'));
+    QVERIFY(group >= 0);
+    QVERIFY(lines.at(group + 1).startsWith(
+                QStringLiteral("jabber=") + individual.linkAddress + QLatin1Char(';')));
+    QVERIFY(lines.mid(group).contains(QStringLiteral("__alias=") + persona.alias));
+}
+
+void TestAddressBook::changesRoundTrip()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString path = dir.path() + QStringLiteral("/changes.txt");
+
+    const AddressBook book(options(5));
+    QVERIFY(book.writeChanges(path));
+
+    QList<AddressBook::Change> changes;
+    QVERIFY(AddressBook::readChanges(path, &changes));
+    QCOMPARE(changes.size(), book.changes().size());
+    for(int i = 0; i < changes.size(); ++i) {
+        QCOMPARE(changes.at(i).time, book.changes().at(i).time);
+        QCOMPARE(changes.at(i).kind, book.changes().at(i).kind);
+        QCOMPARE(changes.at(i).individual, book.changes().at(i).individual);
+        QCOMPARE(changes.at(i).persona, book.changes().at(i).persona);
+        QCOMPARE(changes.at(i).value, book.changes().at(i).value);
+    }
+
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::Append | QIODevice::Text));
+    file.write("10 explode 1 2\n");
+    file.close();
+    QVERIFY(!AddressBook::readChanges(path, &changes));
+}
+
+QTEST_GUILESS_MAIN(TestAddressBook)
+
+#include "tst_addressbook.moc"
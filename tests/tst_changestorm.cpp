@@ -0,0 +1,446 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "dummyaddressbook.h"
+
+#include <QContactManager>
+#include <QDBusArgument>
+#include <QDBusConnection>
+#include <QDBusMessage>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QTimer>
+#include <QtTest>
+#include <algorithm>
+#include <functional>
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace
+{
+
+// Budgets in ms, scaled by QTFOLKS_TEST_TIME_SCALE like the engine tests
+const int LoadBudget = 30000;
+const int SettleBudget = 5000;
+
+const int Timeout = 60000;
+// Changes still without a signal after this long are counted as silent
+const int SettleTime = 1000;
+// A timer tick later than one 60 Hz frame is a main-loop stall
+const int StallThreshold = 16;
+
+int budget(int ms)
+{
+    static const double scale = qEnvironmentVariableIsSet("QTFOLKS_TEST_TIME_SCALE")
+        ? qgetenv("QTFOLKS_TEST_TIME_SCALE").toDouble() : 1.0;
+    return qMax(1, int(ms * scale));
+}
+
+#define VERIFY_BUDGET(elapsed, ms) \
+    QVERIFY2((elapsed) <= budget(ms), qPrintable(QStringLiteral( \
+                    "took %1 ms, budget %2 ms").arg(elapsed).arg(budget(ms))))
+
+int envInt(const char *name, int defaultValue)
+{
+    bool ok;
+    const int value = qgetenv(name).toInt(&ok);
+    return ok ? value : defaultValue;
+}
+
+bool waitFor(const std::function<bool()> &condition, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while(!condition()) {
+        if(timer.elapsed() > timeout)
+            return false;
+        QTest::qWait(1);
+    }
+    return true;
+}
+
+qint64 percentile(QVector<qint64> values, int p)
+{
+    if(values.isEmpty())
+        return 0;
+
+    std::sort(values.begin(), values.end());
+    return values.at((values.size() - 1) * p / 100);
+}
+
+const char *const DBusPath = "/org/nemomobile/contacts/sqlite";
+const char *const DBusInterface = "org.nemomobile.contacts.sqlite";
+const char *const DBusSignals[] = {
+    "contactsAdded", "contactsChanged", "contactsPresenceChanged",
+    "contactsRemoved", "contactsBatchChanged"
+};
+
+} // anonymous namespace
+
+// Replays change scripts against an address book in the dummy backend and
+// reports how the engine keeps up: the latency from a change to the
+// contactsChanged (or contactsAdded/Removed) signals of QContactManager and
+// to the D-Bus signals of the notifier, how many signals it takes and how
+// long the main loop stalls meanwhile.
+//
+// The Folks notify:: signals are emitted from within the dummy persona
+// updates, so a change counts from the moment it is applied. The engine
+// connected to them first, and a handler of our own would only run after
+// its one had already emitted contactsChanged. A change is delivered by the
+// first signal carrying its contact: the one of the individual its persona
+// was in when it was applied, or is in by the time of the signal, as links
+// and unlinks move personas to new individuals.
+//
+// Changes are applied from a timer, one per main loop iteration, so that
+// the ticker measuring stalls runs between them and only sees the work the
+// engine does for a change, not a whole batch applied in one go.
+//
+// QTFOLKS_STORM_INDIVIDUALS sets the size of the address book (2 personas
+// each), QTFOLKS_CHANGE_SCRIPT adds a row replaying a script written by
+// generate-addressbook for the same size and --personas 2.
+class TestChangeStorm : public QObject
+{
+    Q_OBJECT
+
+public slots:
+    void dbusSignal(const QDBusMessage &message);
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void init();
+    void cleanup();
+    void replay_data();
+    void replay();
+
+private:
+    struct Change
+    {
+        // When it was applied, in ns
+        qint64 applied;
+        int individual;
+        int persona;
+        // contactIdHash() of the individual the persona was in, 0 if none
+        quint32 before;
+    };
+
+    struct Stats
+    {
+        Stats()
+            : qtSignals(0)
+            , qtIds(0)
+            , dbusSignals(0)
+            , dbusIds(0)
+            , lastSignal(0)
+            , lastTick(0)
+            , stalls(0)
+            , stallTime(0)
+            , longestStall(0) {}
+
+        // The changes no signal delivered yet
+        QVector<Change> qtPending;
+        QVector<Change> dbusPending;
+        // In us
+        QVector<qint64> qtLatencies;
+        QVector<qint64> dbusLatencies;
+        int qtSignals;
+        int qtIds;
+        int dbusSignals;
+        int dbusIds;
+        // In ms, like everything below
+        qint64 lastSignal;
+        qint64 lastTick;
+        int stalls;
+        qint64 stallTime;
+        qint64 longestStall;
+    };
+
+    // As ContactNotifier hashes the ids in its D-Bus signals
+    static quint32 contactIdHash(const QContactId &id);
+    quint32 contactIdHash(int individual, int persona) const;
+
+    void qtSignal(const QList<QContactId> &ids);
+    void resolve(QVector<Change> *pending, QVector<qint64> *latencies,
+            const QSet<quint32> &ids, qint64 now) const;
+    void applyNext();
+    void tick();
+
+    QTemporaryDir m_dir;
+    AddressBook::Options m_options;
+    DummyAddressBook *m_dummy;
+    QContactManager *m_manager;
+    QElapsedTimer m_clock;
+    QTimer m_ticker;
+    QTimer m_replayer;
+    QList<AddressBook::Change> m_timeline;
+    int m_next;
+    int m_skipped;
+    Stats m_stats;
+};
+
+void TestChangeStorm::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    qputenv("FOLKS_BACKENDS_ALLOWED", "dummy");
+    qputenv("FOLKS_PRIMARY_STORE", "dummy:dummy-store");
+    qputenv("XDG_CONFIG_HOME", QFile::encodeName(m_dir.filePath(QStringLiteral("config"))));
+    qputenv("XDG_DATA_HOME", QFile::encodeName(m_dir.filePath(QStringLiteral("data"))));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(m_dir.filePath(QStringLiteral("cache"))));
+
+    m_options.individuals = envInt("QTFOLKS_STORM_INDIVIDUALS", 2000);
+    m_options.personas = 2;
+
+    // Seeded before the engine prepares the aggregator, so that it loads
+    // the address book like a store it starts with
+    m_dummy = new DummyAddressBook(AddressBook(m_options));
+    QVERIFY(m_dummy->isValid());
+
+    QElapsedTimer timer;
+    timer.start();
+    m_manager = new QContactManager(QStringLiteral("folks"));
+    QVERIFY(m_manager->managerName() != QLatin1String("invalid"));
+    QVERIFY2(waitFor([this]() {
+                return m_manager->contactIds().size() == m_options.individuals; },
+                Timeout), "the address book was never linked into its individuals");
+    VERIFY_BUDGET(timer.elapsed(), LoadBudget);
+
+    connect(m_manager, &QContactManager::contactsAdded,
+            this, &TestChangeStorm::qtSignal);
+    connect(m_manager, &QContactManager::contactsChanged,
+            this, &TestChangeStorm::qtSignal);
+    connect(m_manager, &QContactManager::contactsRemoved,
+            this, &TestChangeStorm::qtSignal);
+
+    // On a connection of our own, so the signals come through the bus
+    QDBusConnection bus = QDBusConnection::sessionBus();
+    for(const char *name : DBusSignals) {
+        QVERIFY(bus.connect(QString(), QLatin1String(DBusPath),
+                    QLatin1String(DBusInterface), QLatin1String(name),
+                    this, SLOT(dbusSignal(QDBusMessage))));
+    }
+
+    m_ticker.setInterval(1);
+    m_ticker.setTimerType(Qt::PreciseTimer);
+    connect(&m_ticker, &QTimer::timeout, this, &TestChangeStorm::tick);
+
+    m_replayer.setSingleShot(true);
+    m_replayer.setTimerType(Qt::PreciseTimer);
+    connect(&m_replayer, &QTimer::timeout, this, &TestChangeStorm::applyNext);
+}
+
+void TestChangeStorm::cleanupTestCase()
+{
+    delete m_manager;
+    delete m_dummy;
+}
+
+void TestChangeStorm::init()
+{
+    m_stats = Stats();
+    m_clock.start();
+    m_ticker.start();
+}
+
+void TestChangeStorm::cleanup()
+{
+    m_ticker.stop();
+    m_replayer.stop();
+
+    m_dummy->restore();
+    QVERIFY2(waitFor([this]() {
+                return m_manager->contactIds().size() == m_options.individuals; },
+                Timeout), "the address book was never restored");
+}
+
+void TestChangeStorm::replay_data()
+{
+    QTest::addColumn<int>("changes");
+    QTest::addColumn<int>("changeRate");
+    QTest::addColumn<QString>("script");
+
+    const int individuals = m_options.individuals;
+    // All at once, like an address book resync or an IM reconnect
+    QTest::newRow("resync") << individuals << 0 << QString();
+    // More than one change per frame
+    QTest::newRow("burst") << individuals / 2 << 1000 << QString();
+    QTest::newRow("steady") << 300 << 100 << QString();
+
+    if(qEnvironmentVariableIsSet("QTFOLKS_CHANGE_SCRIPT"))
+        QTest::newRow("script") << 0 << 0
+            << QString::fromLocal8Bit(qgetenv("QTFOLKS_CHANGE_SCRIPT"));
+}
+
+void TestChangeStorm::replay()
+{
+    QFETCH(int, changes);
+    QFETCH(int, changeRate);
+    QFETCH(QString, script);
+
+    m_timeline.clear();
+    if(script.isEmpty()) {
+        // Same seed and size, so the same address book
+        AddressBook::Options options = m_options;
+        options.changes = changes;
+        options.changeRate = changeRate;
+        m_timeline = AddressBook(options).changes();
+    } else {
+        QVERIFY2(AddressBook::readChanges(script, &m_timeline), qPrintable(script));
+    }
+    QVERIFY(!m_timeline.isEmpty());
+
+    m_next = 0;
+    m_skipped = 0;
+    m_replayer.start(qMax(0, int(m_timeline.first().time - m_clock.elapsed())));
+    QVERIFY(waitFor([this]() { return m_next == m_timeline.size(); },
+                m_timeline.last().time + Timeout));
+    const qint64 replayed = m_clock.elapsed();
+
+    QVERIFY(waitFor([this]() {
+                return (m_stats.qtPending.isEmpty() && m_stats.dbusPending.isEmpty())
+                    || m_clock.elapsed() - m_stats.lastSignal > SettleTime; },
+                Timeout));
+    const qint64 settled = qMax(qint64(0), m_stats.lastSignal - replayed);
+
+    qDebug("%s: %d changes in %lld ms, %d skipped, %d without a Qt signal, "
+            "%d without a D-Bus signal, settled %lld ms later",
+            QTest::currentDataTag(), m_timeline.size(), replayed, m_skipped,
+            m_stats.qtPending.size(), m_stats.dbusPending.size(), settled);
+    qDebug("  Qt: %d signals for %d ids, latency p50 %lld us, p95 %lld us, max %lld us",
+            m_stats.qtSignals, m_stats.qtIds,
+            percentile(m_stats.qtLatencies, 50), percentile(m_stats.qtLatencies, 95),
+            percentile(m_stats.qtLatencies, 100));
+    qDebug("  D-Bus: %d signals for %d ids, latency p50 %lld us, p95 %lld us, max %lld us",
+            m_stats.dbusSignals, m_stats.dbusIds,
+            percentile(m_stats.dbusLatencies, 50), percentile(m_stats.dbusLatencies, 95),
+            percentile(m_stats.dbusLatencies, 100));
+    qDebug("  main loop: %d stalls over %d ms, %lld ms stalled, longest %lld ms",
+            m_stats.stalls, StallThreshold, m_stats.stallTime, m_stats.longestStall);
+
+    QVERIFY(m_stats.qtSignals > 0);
+    QVERIFY(m_stats.dbusSignals > 0);
+    VERIFY_BUDGET(settled, SettleBudget);
+}
+
+void TestChangeStorm::applyNext()
+{
+    const AddressBook::Change &change = m_timeline.at(m_next++);
+    Change applied;
+    applied.individual = change.individual;
+    applied.persona = change.persona;
+    applied.before = contactIdHash(change.individual, change.persona);
+    applied.applied = m_clock.nsecsElapsed();
+    if(m_dummy->apply(change)) {
+        m_stats.qtPending << applied;
+        m_stats.dbusPending << applied;
+    } else {
+        // Nothing happened, so no signal can deliver it
+        ++m_skipped;
+    }
+
+    // Back to the main loop before the next one, even if it is overdue
+    if(m_next < m_timeline.size())
+        m_replayer.start(qMax(0, int(m_timeline.at(m_next).time - m_clock.elapsed())));
+}
+
+quint32 TestChangeStorm::contactIdHash(
+        const QContactId &id)
+{
+    return qHash(id.toString());
+}
+
+quint32 TestChangeStorm::contactIdHash(
+        int individual,
+        int persona) const
+{
+    // As ContactBuilder::contactId() makes them from the individual's id
+    const QString id = m_dummy->individualId(individual, persona);
+    return id.isEmpty() ? 0 : contactIdHash(QContactId(m_manager->managerUri(),
+                QByteArrayLiteral("sql-") + QByteArray::number(qHash(id))));
+}
+
+void TestChangeStorm::qtSignal(
+        const QList<QContactId> &ids)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    ++m_stats.qtSignals;
+    m_stats.qtIds += ids.size();
+    m_stats.lastSignal = now / 1000000;
+
+    QSet<quint32> hashes;
+    foreach(const QContactId &id, ids)
+        hashes.insert(contactIdHash(id));
+    resolve(&m_stats.qtPending, &m_stats.qtLatencies, hashes, now);
+}
+
+void TestChangeStorm::dbusSignal(const QDBusMessage &message)
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    ++m_stats.dbusSignals;
+    m_stats.lastSignal = now / 1000000;
+
+    // Every argument is an array of contact id hashes
+    QSet<quint32> hashes;
+    foreach(const QVariant &argument, message.arguments()) {
+        const QDBusArgument ids = argument.value<QDBusArgument>();
+        ids.beginArray();
+        while(!ids.atEnd()) {
+            quint32 id;
+            ids >> id;
+            hashes.insert(id);
+            ++m_stats.dbusIds;
+        }
+        ids.endArray();
+    }
+
+    resolve(&m_stats.dbusPending, &m_stats.dbusLatencies, hashes, now);
+}
+
+void TestChangeStorm::resolve(
+        QVector<Change> *pending,
+        QVector<qint64> *latencies,
+        const QSet<quint32> &ids,
+        qint64 now) const
+{
+    QVector<Change> undelivered;
+    foreach(const Change &change, *pending) {
+        const quint32 current = contactIdHash(change.individual, change.persona);
+        if((change.before && ids.contains(change.before))
+                || (current && ids.contains(current)))
+            *latencies << (now - change.applied) / 1000;
+        else
+            undelivered << change;
+    }
+    *pending = undelivered;
+}
+
+void TestChangeStorm::tick()
+{
+    const qint64 now = m_clock.elapsed();
+    const qint64 gap = now - m_stats.lastTick;
+    if(gap > StallThreshold) {
+        ++m_stats.stalls;
+        m_stats.stallTime += gap;
+        m_stats.longestStall = qMax(m_stats.longestStall, gap);
+    }
+    m_stats.lastTick = now;
+}
+
+QTEST_GUILESS_MAIN(TestChangeStorm)
+
+#include "tst_changestorm.moc"
@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QtTest>
+#include "addressbook.h"
+#include "contactindex.h"
+
+QTCONTACTS_USE_NAMESPACE
+
+using Folks::NameIndex;
+
+namespace
+{
+
+const QString ManagerUri = QStringLiteral("qtcontacts:folks:");
+
+QContactId contactId(const AddressBook::Individual &individual)
+{
+    return QContactId(ManagerUri, individual.personas.first().id.toUtf8());
+}
+
+QSet<QContactId> lookup(const NameIndex &index, const QString &query,
+        QContactFilter::MatchFlags flags)
+{
+    QSet<QContactId> ids;
+    if(!index.lookup(query, flags, &ids))
+        qWarning() << "Not answered from the index:" << query;
+    return ids;
+}
+
+} // anonymous namespace
+
+class TestContactIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void rename();
+    void benchmarkRename_data();
+    void benchmarkRename();
+};
+
+void TestContactIndex::rename()
+{
+    const QContactId id(ManagerUri, QByteArray("renamed"));
+    const QContactId other(ManagerUri, QByteArray("other"));
+    NameIndex index;
+    index.insert(id, NameIndex::words(QStringLiteral("Anna Svensson")));
+    index.insert(other, NameIndex::words(QStringLiteral("Hanna Berg")));
+
+    // A copy, like the one in a published snapshot, keeps the old names
+    const NameIndex published = index;
+    index.remove(id, NameIndex::words(QStringLiteral("Anna Svensson")));
+    index.insert(id, NameIndex::words(QStringLiteral("Anna Lindqvist")));
+
+    QCOMPARE(lookup(index, QStringLiteral("sven"), QContactFilter::MatchContains),
+            QSet<QContactId>());
+    QCOMPARE(lookup(index, QStringLiteral("lind"), QContactFilter::MatchStartsWith),
+            QSet<QContactId>() << id);
+    QCOMPARE(lookup(index, QStringLiteral("nna"), QContactFilter::MatchContains),
+            QSet<QContactId>() << id << other);
+    QCOMPARE(lookup(published, QStringLiteral("sven"), QContactFilter::MatchContains),
+            QSet<QContactId>() << id);
+    QCOMPARE(lookup(published, QStringLiteral("lind"), QContactFilter::MatchStartsWith),
+            QSet<QContactId>());
+}
+
+void TestContactIndex::benchmarkRename_data()
+{
+    QTest::addColumn<int>("individuals");
+
+    QTest::newRow("1000") << 1000;
+    QTest::newRow("10000") << 10000;
+    QTest::newRow("100000") << 100000;
+}
+
+// What ContactStore does to its name index when one contact is renamed
+// while a published snapshot still shares it
+void TestContactIndex::benchmarkRename()
+{
+    QFETCH(int, individuals);
+
+    AddressBook::Options options;
+    options.individuals = individuals;
+    const AddressBook book(options);
+
+    NameIndex index;
+    foreach(const AddressBook::Individual &individual, book.individuals()) {
+        index.insert(contactId(individual),
+                NameIndex::words(individual.personas.first().fullName));
+    }
+
+    const AddressBook::Individual &renamed = book.individuals().at(individuals / 2);
+    const QContactId id = contactId(renamed);
+    const QStringList names[] = {
+        NameIndex::words(renamed.personas.first().fullName),
+        NameIndex::words(book.individuals().at(individuals / 3).personas.first().fullName)
+    };
+
+    int i = 0;
+    QBENCHMARK {
+        const NameIndex published = index;
+        index.remove(id, names[i % 2]);
+        index.insert(id, names[(i + 1) % 2]);
+        ++i;
+    }
+}
+
+QTEST_GUILESS_MAIN(TestContactIndex)
+
+#include "tst_contactindex.moc"
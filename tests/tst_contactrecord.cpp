@@ -0,0 +1,354 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QContactAvatar>
+#include <QContactDisplayLabel>
+#include <QContactEmailAddress>
+#include <QContactFavorite>
+#include <QContactHobby>
+#include <QContactName>
+#include <QContactOnlineAccount>
+#include <QContactPhoneNumber>
+#include <QContactPresence>
+#include <QDataStream>
+#include <QtTest>
+#include "addressbook.h"
+#include "contactrecord.h"
+
+QTCONTACTS_USE_NAMESPACE
+
+using Folks::ContactRecord;
+
+namespace
+{
+
+const QString ManagerUri = QStringLiteral("qtcontacts:folks:");
+const quint32 Seed = 1;
+
+// The first persona of a fixed address book, with the details it doesn't
+// generate filled in around it
+QContact sampleContact()
+{
+    AddressBook::Options options;
+    options.seed = Seed;
+    options.individuals = 1;
+    options.avatarPercent = 100;
+    const AddressBook::Persona persona =
+        AddressBook(options).individuals().first().personas.first();
+    const QStringList names = persona.fullName.split(QLatin1Char(' '));
+
+    QContact contact;
+    contact.setId(QContactId(ManagerUri, persona.id.toUtf8()));
+    contact.setCollectionId(QContactCollectionId(ManagerUri, QByteArray("aggregate")));
+
+    QContactDisplayLabel label;
+    label.setLabel(persona.fullName);
+    contact.saveDetail(&label);
+
+    QContactName name;
+    name.setFirstName(names.first());
+    name.setLastName(names.last());
+    contact.saveDetail(&name);
+
+    QContactPhoneNumber phone;
+    phone.setNumber(persona.phones.first());
+    phone.setContexts(QList<int>() << QContactDetail::ContextHome);
+    phone.setSubTypes(QList<int>() << QContactPhoneNumber::SubTypeLandline
+            << QContactPhoneNumber::SubTypeVoice);
+    phone.setDetailUri(QStringLiteral("key-file:%1:phone:0").arg(persona.id));
+    contact.saveDetail(&phone);
+
+    QContactEmailAddress email;
+    email.setEmailAddress(persona.emails.first());
+    email.setContexts(QList<int>() << QContactDetail::ContextWork);
+    contact.saveDetail(&email);
+
+    // The link address, always jabber
+    const QString imUri = QStringLiteral("telepathy:%1:im:0").arg(persona.id);
+    QContactOnlineAccount account;
+    account.setAccountUri(persona.ims.first().second);
+    account.setProtocol(QContactOnlineAccount::ProtocolJabber);
+    account.setServiceProvider(persona.ims.first().first);
+    account.setCapabilities(QStringList() << QStringLiteral("text")
+            << QStringLiteral("audio"));
+    account.setDetailUri(imUri);
+    contact.saveDetail(&account);
+
+    QContactPresence presence;
+    presence.setPresenceState(QContactPresence::PresenceAway);
+    presence.setCustomMessage(QStringLiteral("Out for lunch"));
+    presence.setTimestamp(QDateTime(QDate(2026, 3, 1), QTime(12, 30), Qt::UTC));
+    presence.setLinkedDetailUris(QStringList() << imUri);
+    contact.saveDetail(&presence);
+
+    QContactAvatar avatar;
+    avatar.setImageUrl(QUrl(persona.avatar));
+    contact.saveDetail(&avatar);
+
+    QContactFavorite favorite;
+    favorite.setFavorite(persona.favourite);
+    contact.saveDetail(&favorite);
+
+    return contact;
+}
+
+QByteArray streamed(const QContact &contact)
+{
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_5_6);
+    out << contact;
+    return data;
+}
+
+QContact roundTrip(const QContact &contact,
+        quint32 groups = ContactRecord::AllGroups)
+{
+    QContact decoded;
+    if(!ContactRecord::decode(ContactRecord::encode(contact), &decoded, groups))
+        qWarning() << "Decoding failed";
+    return decoded;
+}
+
+}
+
+class TestContactRecord : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void roundTrip_data();
+    void roundTrip();
+    void unsortedContexts();
+    void otherDetails();
+    void groupMask();
+    void detailTypesHint();
+    void corruptData();
+    void size();
+    void benchmarkEncode_data();
+    void benchmarkEncode();
+    void benchmarkDecode_data();
+    void benchmarkDecode();
+};
+
+void TestContactRecord::roundTrip_data()
+{
+    QTest::addColumn<QContact>("contact");
+
+    QTest::newRow("empty") << QContact();
+
+    QContact idOnly;
+    idOnly.setId(QContactId(ManagerUri, QByteArray("1")));
+    QTest::newRow("id only") << idOnly;
+
+    QTest::newRow("sample") << sampleContact();
+
+    // The address book only has ASCII names
+    QContact accented = sampleContact();
+    QContactName name = accented.detail<QContactName>();
+    name.setFirstName(QStringLiteral("Zoë"));
+    accented.saveDetail(&name);
+    QContactDisplayLabel label = accented.detail<QContactDisplayLabel>();
+    label.setLabel(QStringLiteral("Zoë ") + name.lastName());
+    accented.saveDetail(&label);
+    QTest::newRow("accented") << accented;
+
+    QContact offset = sampleContact();
+    QContactPresence presence = offset.detail<QContactPresence>();
+    presence.setTimestamp(QDateTime(QDate(2026, 3, 1), QTime(12, 30),
+                Qt::OffsetFromUTC, 3600));
+    offset.saveDetail(&presence);
+    QTest::newRow("offset timestamp") << offset;
+}
+
+void TestContactRecord::roundTrip()
+{
+    QFETCH(QContact, contact);
+
+    const QContact decoded = ::roundTrip(contact);
+    QCOMPARE(decoded.id(), contact.id());
+    QCOMPARE(decoded.collectionId(), contact.collectionId());
+    QCOMPARE(decoded.details().size(), contact.details().size());
+    foreach(const QContactDetail &detail, contact.details()) {
+        QVERIFY2(decoded.details(detail.type()).contains(detail),
+                qPrintable(QString::number(detail.type())));
+    }
+}
+
+void TestContactRecord::unsortedContexts()
+{
+    // Not a bitmask, stored value by value
+    QContact contact;
+    QContactPhoneNumber phone;
+    phone.setNumber(QStringLiteral("5550100"));
+    phone.setContexts(QList<int>() << QContactDetail::ContextWork
+            << QContactDetail::ContextHome << QContactDetail::ContextWork);
+    contact.saveDetail(&phone);
+
+    const QContactPhoneNumber decoded =
+        ::roundTrip(contact).detail<QContactPhoneNumber>();
+    QCOMPARE(decoded.contexts(), phone.contexts());
+}
+
+void TestContactRecord::otherDetails()
+{
+    QContact contact;
+
+    // A type without a group of its own
+    QContactHobby hobby;
+    hobby.setHobby(QStringLiteral("Climbing"));
+    contact.saveDetail(&hobby);
+
+    // A field the phone number group doesn't know about
+    QContactPhoneNumber phone;
+    phone.setNumber(QStringLiteral("5550100"));
+    phone.setValue(QContactPhoneNumber::FieldNumber + 100, 42);
+    contact.saveDetail(&phone);
+
+    // A value of another type than the group expects
+    QContactDisplayLabel label;
+    label.setValue(QContactDisplayLabel::FieldLabel, 42);
+    contact.saveDetail(&label);
+
+    const QContact decoded = ::roundTrip(contact);
+    QCOMPARE(decoded.detail<QContactHobby>(), hobby);
+    QCOMPARE(decoded.detail<QContactPhoneNumber>(), phone);
+    QCOMPARE(decoded.detail<QContactDisplayLabel>().value(
+                QContactDisplayLabel::FieldLabel), QVariant(42));
+}
+
+void TestContactRecord::groupMask()
+{
+    const QContact contact = sampleContact();
+    const QContact decoded = ::roundTrip(contact,
+            ContactRecord::groupMask(ContactRecord::NameGroup)
+            | ContactRecord::groupMask(ContactRecord::PhoneNumberGroup));
+
+    QCOMPARE(decoded.id(), contact.id());
+    QCOMPARE(decoded.detail<QContactName>(), contact.detail<QContactName>());
+    QCOMPARE(decoded.detail<QContactPhoneNumber>(),
+            contact.detail<QContactPhoneNumber>());
+    QVERIFY(decoded.details<QContactEmailAddress>().isEmpty());
+    QVERIFY(decoded.details<QContactPresence>().isEmpty());
+}
+
+void TestContactRecord::detailTypesHint()
+{
+    const QContact contact = sampleContact();
+    QCOMPARE(ContactRecord::groupMask(QList<QContactDetail::DetailType>()),
+            ContactRecord::AllGroups);
+
+    // Decoding only the hinted groups and trimming a whole contact to them
+    // give the same details
+    const quint32 groups = ContactRecord::groupMask(
+            QList<QContactDetail::DetailType>()
+            << QContactDetail::TypeName << QContactDetail::TypePhoneNumber);
+    const QContact decoded = ::roundTrip(contact, groups);
+    const QContact selected = ContactRecord::select(contact, groups);
+
+    QCOMPARE(selected.id(), contact.id());
+    QCOMPARE(selected.collectionId(), contact.collectionId());
+    QCOMPARE(selected.detail<QContactName>(), decoded.detail<QContactName>());
+    QCOMPARE(selected.detail<QContactPhoneNumber>(),
+            decoded.detail<QContactPhoneNumber>());
+    QVERIFY(selected.details<QContactEmailAddress>().isEmpty());
+    QVERIFY(selected.details<QContactDisplayLabel>().isEmpty());
+}
+
+void TestContactRecord::corruptData()
+{
+    const QByteArray record = ContactRecord::encode(sampleContact());
+
+    QContact contact;
+    QVERIFY(!ContactRecord::decode(QByteArray(), &contact));
+
+    QByteArray version = record;
+    version[0] = char(ContactRecord::Version + 1);
+    QVERIFY(!ContactRecord::decode(version, &contact));
+
+    // Every truncation has to be noticed instead of read past the end
+    for(int size = 1; size < record.size(); ++size) {
+        QContact truncated;
+        QVERIFY2(!ContactRecord::decode(record.constData(), size, &truncated),
+                qPrintable(QString::number(size)));
+    }
+}
+
+void TestContactRecord::size()
+{
+    const QContact contact = sampleContact();
+    const int recordSize = ContactRecord::encode(contact).size();
+    const int streamSize = streamed(contact).size();
+    qDebug() << "record" << recordSize << "bytes, QDataStream" << streamSize
+        << "bytes";
+    QVERIFY(recordSize < streamSize);
+}
+
+void TestContactRecord::benchmarkEncode_data()
+{
+    QTest::addColumn<bool>("record");
+    QTest::newRow("record") << true;
+    QTest::newRow("QDataStream") << false;
+}
+
+void TestContactRecord::benchmarkEncode()
+{
+    QFETCH(bool, record);
+    const QContact contact = sampleContact();
+
+    if(record) {
+        QBENCHMARK {
+            ContactRecord::encode(contact);
+        }
+    } else {
+        QBENCHMARK {
+            streamed(contact);
+        }
+    }
+}
+
+void TestContactRecord::benchmarkDecode_data()
+{
+    benchmarkEncode_data();
+}
+
+void TestContactRecord::benchmarkDecode()
+{
+    QFETCH(bool, record);
+    const QContact contact = sampleContact();
+
+    if(record) {
+        const QByteArray data = ContactRecord::encode(contact);
+        QBENCHMARK {
+            QContact decoded;
+            ContactRecord::decode(data, &decoded);
+        }
+    } else {
+        const QByteArray data = streamed(contact);
+        QBENCHMARK {
+            QDataStream in(data);
+            in.setVersion(QDataStream::Qt_5_6);
+            QContact decoded;
+            in >> decoded;
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestContactRecord)
+
+#include "tst_contactrecord.moc"
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QtTest>
+#include "internpool.h"
+
+using Folks::InternPool;
+
+class TestInternPool : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void shared();
+    void recentlyUsedStringsStay();
+    void stringsAreBounded();
+};
+
+void TestInternPool::shared()
+{
+    const QString first = InternPool::string(QStringLiteral("Away"));
+    const QString second = InternPool::string(QString::fromLatin1("Away"));
+    QVERIFY(second.isSharedWith(first));
+
+    const QList<int> list = InternPool::intList(QList<int>() << 1 << 2);
+    QVERIFY(InternPool::intList(QList<int>() << 1 << 2).isSharedWith(list));
+}
+
+void TestInternPool::recentlyUsedStringsStay()
+{
+    const QString away = InternPool::string(QStringLiteral("Out to lunch"));
+
+    // Asked for in every generation, so it is never dropped
+    for(int i = 0; i < 4 * InternPool::StringLimit; ++i) {
+        InternPool::string(QStringLiteral("message %1").arg(i));
+        if(i % (InternPool::StringLimit / 2) == 0)
+            QVERIFY(InternPool::string(QString::fromLatin1("Out to lunch"))
+                    .isSharedWith(away));
+    }
+}
+
+void TestInternPool::stringsAreBounded()
+{
+    const QString once = InternPool::string(QStringLiteral("Only said once"));
+
+    // Two full generations later it is gone
+    for(int i = 0; i < 2 * InternPool::StringLimit + 1; ++i)
+        InternPool::string(QStringLiteral("status %1").arg(i));
+
+    QVERIFY(!InternPool::string(QString::fromLatin1("Only said once"))
+            .isSharedWith(once));
+}
+
+QTEST_GUILESS_MAIN(TestInternPool)
+
+#include "tst_internpool.moc"
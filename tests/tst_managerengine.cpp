@@ -0,0 +1,302 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QContactDetailFilter>
+#include <QContactDisplayLabel>
+#include <QContactIntersectionFilter>
+#include <QContactManager>
+#include <QContactOnlineAccount>
+#include <QContactRemoveRequest>
+#include <QContactSaveRequest>
+#include <QContactUnionFilter>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QtTest>
+#include <functional>
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace
+{
+
+// Budgets in ms, generous enough for a loaded build machine. Set
+// QTFOLKS_TEST_TIME_SCALE to scale them, e.g. under valgrind.
+const int LoadBudget = 5000;
+const int QueryBudget = 1;
+const int SaveBudget = 2000;
+const int NotifyBudget = 1000;
+
+const int QueryRepeats = 1000;
+// How long anything may take before it counts as broken, not slow
+const int Timeout = 30000;
+
+int budget(int ms)
+{
+    static const double scale = qEnvironmentVariableIsSet("QTFOLKS_TEST_TIME_SCALE")
+        ? qgetenv("QTFOLKS_TEST_TIME_SCALE").toDouble() : 1.0;
+    return qMax(1, int(ms * scale));
+}
+
+#define VERIFY_BUDGET(elapsed, ms) \
+    QVERIFY2((elapsed) <= budget(ms), qPrintable(QStringLiteral( \
+                    "took %1 ms, budget %2 ms").arg(elapsed).arg(budget(ms))))
+
+QContactDetailFilter imFilter(const QString &accountUri)
+{
+    QContactDetailFilter filter;
+    filter.setDetailType(QContactOnlineAccount::Type,
+            QContactOnlineAccount::FieldAccountUri);
+    filter.setValue(accountUri);
+    filter.setMatchFlags(QContactFilter::MatchExactly);
+    return filter;
+}
+
+bool waitFor(const std::function<bool()> &condition, int timeout)
+{
+    QElapsedTimer timer;
+    timer.start();
+    while(!condition()) {
+        if(timer.elapsed() > timeout)
+            return false;
+        QTest::qWait(1);
+    }
+    return true;
+}
+
+}
+
+// Runs the engine against a copy of a key-file store from tests/data, on
+// the private session bus CTest starts for it.
+class TestManagerEngine : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void load();
+    void retrieval_data();
+    void retrieval();
+    void query();
+    void nestedFilters();
+    void save();
+    void change();
+    void remove();
+
+private:
+    QTemporaryDir m_dir;
+    QContactManager *m_manager;
+    QElapsedTimer m_loadTimer;
+    QContactId m_savedId;
+};
+
+void TestManagerEngine::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    // Folks writes to the store, so it gets a copy
+    const QString store = m_dir.filePath(QStringLiteral("contacts.ini"));
+    QVERIFY(QFile::copy(QStringLiteral(TEST_DATA_DIR
+                    "/backend-key-file--sample-contacts.ini"), store));
+    QVERIFY(QFile::setPermissions(store, QFile::ReadOwner | QFile::WriteOwner));
+
+    qputenv("FOLKS_BACKENDS_ALLOWED", "key-file");
+    qputenv("FOLKS_BACKEND_KEY_FILE_PATH", QFile::encodeName(store));
+    // The key-file store is named after its file
+    qputenv("FOLKS_PRIMARY_STORE", "key-file:contacts.ini");
+    // Nothing from the user's own configuration or caches
+    qputenv("XDG_CONFIG_HOME", QFile::encodeName(m_dir.filePath(QStringLiteral("config"))));
+    qputenv("XDG_DATA_HOME", QFile::encodeName(m_dir.filePath(QStringLiteral("data"))));
+    qputenv("XDG_CACHE_HOME", QFile::encodeName(m_dir.filePath(QStringLiteral("cache"))));
+
+    m_loadTimer.start();
+    m_manager = new QContactManager(QStringLiteral("folks"));
+    // Loaded as "folks", named like the engine it replaces
+    QVERIFY(m_manager->managerName() != QLatin1String("invalid"));
+}
+
+void TestManagerEngine::cleanupTestCase()
+{
+    delete m_manager;
+}
+
+void TestManagerEngine::load()
+{
+    QVERIFY2(waitFor([this]() { return m_manager->contactIds().size() >= 3; },
+                Timeout), "the sample contacts never arrived");
+    VERIFY_BUDGET(m_loadTimer.elapsed(), LoadBudget);
+}
+
+void TestManagerEngine::retrieval_data()
+{
+    QTest::addColumn<QString>("accountUri");
+    QTest::addColumn<QString>("label");
+
+    // Without an alias the label is whatever Folks picks, so it isn't checked
+    QTest::newRow("no alias") << QStringLiteral("user1@localhost") << QString();
+    QTest::newRow("alias") << QStringLiteral("foo@localhost")
+        << QStringLiteral("A Classic");
+    QTest::newRow("dotted") << QStringLiteral("palm.tree.squirrel@localhost")
+        << QStringLiteral("Palm Tree Squirrel");
+}
+
+void TestManagerEngine::retrieval()
+{
+    QFETCH(QString, accountUri);
+    QFETCH(QString, label);
+
+    const QList<QContact> contacts = m_manager->contacts(imFilter(accountUri));
+    QCOMPARE(contacts.size(), 1);
+    if(!label.isEmpty())
+        QCOMPARE(contacts.first().detail<QContactDisplayLabel>().label(), label);
+}
+
+void TestManagerEngine::query()
+{
+    const QContactDetailFilter filter = imFilter(QStringLiteral("foo@localhost"));
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int i = 0; i < QueryRepeats; ++i)
+        QCOMPARE(m_manager->contactIds(filter).size(), 1);
+    VERIFY_BUDGET(timer.elapsed(), QueryBudget * QueryRepeats);
+
+    timer.restart();
+    for(int i = 0; i < QueryRepeats; ++i)
+        QCOMPARE(m_manager->contacts().size(), m_manager->contactIds().size());
+    VERIFY_BUDGET(timer.elapsed(), QueryBudget * QueryRepeats);
+}
+
+void TestManagerEngine::nestedFilters()
+{
+    QContactDetailFilter label;
+    label.setDetailType(QContactDisplayLabel::Type, QContactDisplayLabel::FieldLabel);
+    label.setValue(QStringLiteral("A Class"));
+    label.setMatchFlags(QContactFilter::MatchStartsWith);
+
+    QContactIntersectionFilter intersection;
+    intersection.append(imFilter(QStringLiteral("foo@localhost")));
+    intersection.append(label);
+
+    // The intersection comes last, so it can't replace what the first term
+    // found
+    QContactUnionFilter filter;
+    filter.append(imFilter(QStringLiteral("user1@localhost")));
+    filter.append(intersection);
+
+    const QList<QContactId> expected = m_manager->contactIds(
+            imFilter(QStringLiteral("user1@localhost")))
+        + m_manager->contactIds(imFilter(QStringLiteral("foo@localhost")));
+    QCOMPARE(expected.size(), 2);
+
+    const QList<QContactId> ids = m_manager->contactIds(filter);
+    QCOMPARE(ids.size(), 2);
+    foreach(const QContactId &id, expected)
+        QVERIFY(ids.contains(id));
+}
+
+void TestManagerEngine::save()
+{
+    QSignalSpy added(m_manager, SIGNAL(contactsAdded(QList<QContactId>)));
+
+    QContact contact;
+    QContactDisplayLabel label;
+    label.setLabel(QStringLiteral("Saved Contact"));
+    contact.saveDetail(&label);
+    QContactOnlineAccount account;
+    account.setAccountUri(QStringLiteral("saved@localhost"));
+    account.setProtocol(QContactOnlineAccount::ProtocolJabber);
+    contact.saveDetail(&account);
+
+    QContactSaveRequest request;
+    request.setManager(m_manager);
+    request.setContacts(QList<QContact>() << contact);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(request.start());
+    QVERIFY2(waitFor([&]() { return request.isFinished(); }, Timeout),
+            "the save request never finished");
+    QCOMPARE(request.error(), QContactManager::NoError);
+    QVERIFY(waitFor([&]() { return !added.isEmpty(); }, Timeout));
+    VERIFY_BUDGET(timer.elapsed(), SaveBudget);
+
+    const QList<QContact> saved =
+        m_manager->contacts(imFilter(QStringLiteral("saved@localhost")));
+    QCOMPARE(saved.size(), 1);
+    m_savedId = saved.first().id();
+}
+
+void TestManagerEngine::change()
+{
+    if(m_savedId.isNull())
+        QSKIP("Needs the contact from save()");
+
+    QSignalSpy changed(m_manager,
+            SIGNAL(contactsChanged(QList<QContactId>,QList<QContactDetail::DetailType>)));
+
+    QContact contact = m_manager->contact(m_savedId);
+    QContactDisplayLabel label = contact.detail<QContactDisplayLabel>();
+    label.setLabel(QStringLiteral("Changed Contact"));
+    contact.saveDetail(&label);
+
+    QContactSaveRequest request;
+    request.setManager(m_manager);
+    request.setContacts(QList<QContact>() << contact);
+
+    // From the request to the change coming back from Folks
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(request.start());
+    QVERIFY(waitFor([&]() {
+        foreach(const QList<QVariant> &arguments, changed) {
+            if(arguments.at(0).value<QList<QContactId> >().contains(m_savedId))
+                return true;
+        }
+        return false;
+    }, Timeout));
+    VERIFY_BUDGET(timer.elapsed(), NotifyBudget);
+
+    QCOMPARE(m_manager->contact(m_savedId).detail<QContactDisplayLabel>().label(),
+            QStringLiteral("Changed Contact"));
+}
+
+void TestManagerEngine::remove()
+{
+    if(m_savedId.isNull())
+        QSKIP("Needs the contact from save()");
+
+    QSignalSpy removed(m_manager, SIGNAL(contactsRemoved(QList<QContactId>)));
+
+    QContactRemoveRequest request;
+    request.setManager(m_manager);
+    request.setContactIds(QList<QContactId>() << m_savedId);
+
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY(request.start());
+    QVERIFY(waitFor([&]() { return !removed.isEmpty(); }, Timeout));
+    VERIFY_BUDGET(timer.elapsed(), NotifyBudget);
+
+    QVERIFY(removed.first().at(0).value<QList<QContactId> >().contains(m_savedId));
+    QVERIFY(m_manager->contacts(imFilter(QStringLiteral("saved@localhost"))).isEmpty());
+}
+
+QTEST_GUILESS_MAIN(TestManagerEngine)
+
+#include "tst_managerengine.moc"
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QtTest>
+#include "phonenumber.h"
+
+using Folks::PhoneNumber;
+
+class TestPhoneNumber : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void normalize_data();
+    void normalize();
+    void matches_data();
+    void matches();
+};
+
+void TestPhoneNumber::normalize_data()
+{
+    QTest::addColumn<QString>("number");
+    QTest::addColumn<QString>("normalized");
+
+    QTest::newRow("formatting") << QStringLiteral("(030) 123-45.67")
+        << QStringLiteral("0301234567");
+    QTest::newRow("international") << QStringLiteral("0049 30 1234567")
+        << QStringLiteral("+49301234567");
+    QTest::newRow("plus") << QStringLiteral("+44 20 7946 0000")
+        << QStringLiteral("+442079460000");
+    QTest::newRow("arabic-indic digits")
+        << QString::fromUtf8("\xd9\xa1\xd9\xa2\xd9\xa3") << QStringLiteral("123");
+    QTest::newRow("pause") << QStringLiteral("555-1234p12")
+        << QStringLiteral("5551234");
+    QTest::newRow("wait") << QStringLiteral("555-1234 W 12")
+        << QStringLiteral("5551234");
+    QTest::newRow("extension") << QStringLiteral("+1 555 1234 x89")
+        << QStringLiteral("+15551234");
+    QTest::newRow("ext") << QStringLiteral("+1 555 1234 ext. 89")
+        << QStringLiteral("+15551234");
+    QTest::newRow("dtmf") << QStringLiteral("555-1234,,12")
+        << QStringLiteral("5551234");
+    QTest::newRow("vanity") << QStringLiteral("1-800-FLOWERS")
+        << QStringLiteral("18003569377");
+    QTest::newRow("vanity with extension") << QStringLiteral("1-800-GO-FEDEX x12")
+        << QStringLiteral("18004633339");
+}
+
+void TestPhoneNumber::normalize()
+{
+    QFETCH(QString, number);
+    QFETCH(QString, normalized);
+
+    QCOMPARE(PhoneNumber::normalize(number), normalized);
+}
+
+void TestPhoneNumber::matches_data()
+{
+    QTest::addColumn<QString>("number");
+    QTest::addColumn<QString>("query");
+    QTest::addColumn<int>("flags");
+    QTest::addColumn<bool>("matches");
+
+    const int phoneNumber = QContactFilter::MatchPhoneNumber;
+    QTest::newRow("caller id") << QStringLiteral("+49 30 1234567")
+        << QStringLiteral("030 1234567") << phoneNumber << true;
+    QTest::newRow("other number") << QStringLiteral("+49 30 1234567")
+        << QStringLiteral("030 7654321") << phoneNumber << false;
+    QTest::newRow("vanity") << QStringLiteral("1-800-FLOWERS")
+        << QStringLiteral("+1 800 356 9377") << phoneNumber << true;
+    QTest::newRow("starts with") << QStringLiteral("+49 30 1234567")
+        << QStringLiteral("+4930")
+        << (phoneNumber | QContactFilter::MatchStartsWith) << true;
+    QTest::newRow("ends with") << QStringLiteral("+49 30 1234567")
+        << QStringLiteral("4567")
+        << (phoneNumber | QContactFilter::MatchEndsWith) << true;
+}
+
+void TestPhoneNumber::matches()
+{
+    QFETCH(QString, number);
+    QFETCH(QString, query);
+    QFETCH(int, flags);
+    QFETCH(bool, matches);
+
+    QCOMPARE(PhoneNumber::matches(number, query, QContactFilter::MatchFlags(flags)),
+            matches);
+}
+
+QTEST_GUILESS_MAIN(TestPhoneNumber)
+
+#include "tst_phonenumber.moc"
@@ -0,0 +1,512 @@
+/*
+ * Copyright (C) 2026 qtfolks contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <QContactDisplayLabel>
+#include <QContactGlobalPresence>
+#include <QContactNickname>
+#include <QSortFilterProxyModel>
+#include <QtTest>
+#include "addressbook.h"
+#include "sortedcontactmodel.h"
+
+QTCONTACTS_USE_NAMESPACE
+
+namespace
+{
+
+const QString ManagerUri = QStringLiteral("qtcontacts:folks:");
+const quint32 Seed = 1;
+
+QContact makeContact(int id, const QString &label)
+{
+    QContact contact;
+    contact.setId(QContactId(ManagerUri, QByteArray::number(id)));
+
+    QContactDisplayLabel displayLabel;
+    displayLabel.setLabel(label);
+    contact.saveDetail(&displayLabel);
+
+    return contact;
+}
+
+// Labelled like the individuals of a fixed address book, the same on
+// every run
+QList<QContact> makeContacts(int count)
+{
+    AddressBook::Options options;
+    options.seed = Seed;
+    options.individuals = count;
+    const AddressBook book(options);
+
+    QList<QContact> contacts;
+    for(int i = 0; i < count; ++i)
+        contacts << makeContact(i, book.individuals().at(i).personas.first().fullName);
+    return contacts;
+}
+
+// What a model without sorting of its own would do: append and change in
+// place, leaving the order to a QSortFilterProxyModel
+class UnsortedModel : public QAbstractListModel
+{
+public:
+    int rowCount(const QModelIndex &parent = QModelIndex()) const
+    {
+        return parent.isValid() ? 0 : m_contacts.size();
+    }
+
+    QVariant data(const QModelIndex &index, int role) const
+    {
+        if(role != Qt::DisplayRole)
+            return QVariant();
+        return m_contacts.at(index.row()).detail<QContactDisplayLabel>().label();
+    }
+
+    void append(const QList<QContact> &contacts)
+    {
+        beginInsertRows(QModelIndex(), m_contacts.size(),
+                m_contacts.size() + contacts.size() - 1);
+        m_contacts += contacts;
+        endInsertRows();
+    }
+
+    void removeLast()
+    {
+        beginRemoveRows(QModelIndex(), m_contacts.size() - 1, m_contacts.size() - 1);
+        m_contacts.removeLast();
+        endRemoveRows();
+    }
+
+    void change(int row, const QContact &contact)
+    {
+        m_contacts[row] = contact;
+        emit dataChanged(index(row), index(row));
+    }
+
+private:
+    QList<QContact> m_contacts;
+};
+
+// Serves its contacts from a hash, counting the fetches
+class WindowedModel : public SortedContactModel
+{
+public:
+    enum { NicknameRole = SectionRole + 1 };
+
+    WindowedModel(const QList<QContact> &contacts)
+        : SortedContactModel(0, Windowed)
+        , fetches(0)
+        , fetched(0)
+        , labelsFetched(0)
+    {
+        foreach(const QContact &contact, contacts)
+            m_contacts.insert(contact.id(), contact);
+        insertContacts(contacts);
+    }
+
+    QHash<int, QByteArray> roleNames() const
+    {
+        QHash<int, QByteArray> roles = SortedContactModel::roleNames();
+        roles[NicknameRole] = "nickname";
+        return roles;
+    }
+
+    // What ContactModel does when the manager reports changes
+    void change(const QList<QContact> &contacts)
+    {
+        QList<QContactId> ids;
+        foreach(const QContact &contact, contacts) {
+            m_contacts.insert(contact.id(), contact);
+            ids << contact.id();
+        }
+        updateContacts(fetchUpdates(ids));
+    }
+
+    mutable int fetches;
+    mutable int fetched;
+    mutable int labelsFetched;
+
+protected:
+    QVariant roleData(const QContact &contact, int role) const
+    {
+        if(role == NicknameRole)
+            return contact.detail<QContactNickname>().nickname();
+        return QVariant();
+    }
+
+    QList<QContact> fetchContacts(const QList<QContactId> &ids) const
+    {
+        fetches++;
+        fetched += ids.size();
+
+        QList<QContact> contacts;
+        foreach(const QContactId &id, ids)
+            contacts << m_contacts.value(id);
+        return contacts;
+    }
+
+    QList<QContact> fetchLabels(const QList<QContactId> &ids) const
+    {
+        labelsFetched += ids.size();
+
+        QList<QContact> contacts;
+        foreach(const QContactId &id, ids) {
+            const QContact contact = m_contacts.value(id);
+            contacts << makeContact(id.localId().toInt(),
+                    contact.detail<QContactDisplayLabel>().label());
+        }
+        return contacts;
+    }
+
+private:
+    QHash<QContactId, QContact> m_contacts;
+};
+
+QList<QContact> withNicknames(QList<QContact> contacts)
+{
+    for(int i = 0; i < contacts.size(); ++i) {
+        QContactNickname nickname;
+        nickname.setNickname(QString::number(i));
+        contacts[i].saveDetail(&nickname);
+    }
+    return contacts;
+}
+
+}
+
+class TestSortedContactModel : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sorted();
+    void moves();
+    void sections();
+    void windowed();
+    void windowedCacheBound();
+    void windowedUpdates();
+    void benchmark_data();
+    void benchmark();
+
+private:
+    static void verifyOrder(const SortedContactModel &model);
+    static void verifySections(const SortedContactModel &model);
+};
+
+void TestSortedContactModel::verifyOrder(const SortedContactModel &model)
+{
+    QCollator collator;
+    collator.setCaseSensitivity(Qt::CaseInsensitive);
+    collator.setNumericMode(true);
+
+    for(int row = 1; row < model.rowCount(); ++row) {
+        const QString previous =
+            model.contact(row - 1).detail<QContactDisplayLabel>().label();
+        const QString label =
+            model.contact(row).detail<QContactDisplayLabel>().label();
+        QVERIFY2(collator.compare(previous, label) <= 0,
+                qPrintable(previous + QLatin1String(" > ") + label));
+        QCOMPARE(model.rowOf(model.contact(row).id()), row);
+    }
+}
+
+void TestSortedContactModel::verifySections(const SortedContactModel &model)
+{
+    // The runs kept up to date along the way against ones from scratch
+    int section = -1;
+    QString name;
+    for(int row = 0; row < model.rowCount(); ++row) {
+        const QString rowSection = model.data(model.index(row),
+                SortedContactModel::SectionRole).toString();
+        if(row == 0 || rowSection != name) {
+            section++;
+            name = rowSection;
+            QCOMPARE(model.sectionName(section), name);
+            QCOMPARE(model.sectionFirstRow(section), row);
+        }
+    }
+    QCOMPARE(model.sectionCount(), section + 1);
+}
+
+void TestSortedContactModel::sorted()
+{
+    SortedContactModel model;
+    QSignalSpy resets(&model, SIGNAL(modelReset()));
+    QSignalSpy inserts(&model, SIGNAL(rowsInserted(QModelIndex,int,int)));
+
+    const QList<QContact> contacts = makeContacts(200);
+    // A batch larger than the model is sorted at once, the others
+    // inserted row by row
+    model.insertContacts(contacts.mid(0, 100));
+    QCOMPARE(resets.count(), 1);
+    model.insertContacts(contacts.mid(100, 50));
+    model.insertContacts(contacts.mid(150));
+    QCOMPARE(resets.count(), 1);
+    QCOMPARE(inserts.count(), 100);
+
+    QCOMPARE(model.rowCount(), contacts.size());
+    verifyOrder(model);
+    verifySections(model);
+
+    // Adding a contact again doesn't duplicate it
+    model.insertContacts(contacts.mid(0, 1));
+    QCOMPARE(model.rowCount(), contacts.size());
+
+    QList<QContactId> removed;
+    for(int i = 0; i < contacts.size(); i += 3)
+        removed << contacts.at(i).id();
+    model.removeContacts(removed);
+    QCOMPARE(model.rowCount(), contacts.size() - removed.size());
+    foreach(const QContactId &id, removed)
+        QCOMPARE(model.rowOf(id), -1);
+    verifyOrder(model);
+    verifySections(model);
+}
+
+void TestSortedContactModel::moves()
+{
+    SortedContactModel model;
+    model.insertContacts(QList<QContact>()
+            << makeContact(1, QStringLiteral("Alice"))
+            << makeContact(2, QStringLiteral("Bob"))
+            << makeContact(3, QStringLiteral("Carol"))
+            << makeContact(4, QStringLiteral("Dave")));
+
+    QSignalSpy moved(&model, SIGNAL(rowsMoved(QModelIndex,int,int,QModelIndex,int)));
+    QSignalSpy changed(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+    // Same row, no move
+    model.updateContacts(QList<QContact>() << makeContact(2, QStringLiteral("Bobby")));
+    QCOMPARE(moved.count(), 0);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(model.rowOf(makeContact(2, QString()).id()), 1);
+
+    // Down and up again
+    model.updateContacts(QList<QContact>() << makeContact(1, QStringLiteral("Eve")));
+    QCOMPARE(moved.count(), 1);
+    QCOMPARE(model.rowOf(makeContact(1, QString()).id()), 3);
+    verifyOrder(model);
+
+    model.updateContacts(QList<QContact>() << makeContact(1, QStringLiteral("Aaron")));
+    QCOMPARE(moved.count(), 2);
+    QCOMPARE(model.rowOf(makeContact(1, QString()).id()), 0);
+    verifyOrder(model);
+    verifySections(model);
+}
+
+void TestSortedContactModel::sections()
+{
+    SortedContactModel model;
+    QSignalSpy sectionsChanged(&model, SIGNAL(sectionsChanged()));
+
+    model.insertContacts(QList<QContact>()
+            << makeContact(1, QStringLiteral("Anna"))
+            << makeContact(2, QStringLiteral("Ben"))
+            << makeContact(3, QStringLiteral("Bert")));
+    QCOMPARE(model.sectionCount(), 2);
+    QCOMPARE(sectionsChanged.count(), 1);
+
+    // Joins an existing run
+    model.insertContacts(QList<QContact>() << makeContact(4, QStringLiteral("Andy")));
+    QCOMPARE(model.sectionCount(), 2);
+    QCOMPARE(model.sectionFirstRow(1), 2);
+    QCOMPARE(sectionsChanged.count(), 1);
+
+    // A new run, then moving the only contact out of it again
+    model.insertContacts(QList<QContact>() << makeContact(5, QStringLiteral("42")));
+    QCOMPARE(model.sectionName(0), QStringLiteral("#"));
+    QCOMPARE(model.sectionCount(), 3);
+    model.updateContacts(QList<QContact>() << makeContact(5, QStringLiteral("Cleo")));
+    QCOMPARE(model.sectionCount(), 3);
+    QCOMPARE(model.sectionName(2), QStringLiteral("C"));
+    verifySections(model);
+
+    // Emptying a run
+    model.removeContacts(QList<QContactId>() << makeContact(5, QString()).id());
+    QCOMPARE(model.sectionCount(), 2);
+    model.removeContacts(QList<QContactId>() << makeContact(2, QString()).id()
+            << makeContact(3, QString()).id());
+    QCOMPARE(model.sectionCount(), 1);
+    verifySections(model);
+}
+
+void TestSortedContactModel::windowed()
+{
+    WindowedModel model(withNicknames(makeContacts(1000)));
+    QCOMPARE(model.fetches, 0);
+    verifySections(model);
+
+    QSignalSpy changed(&model, SIGNAL(dataChanged(QModelIndex,QModelIndex,QVector<int>)));
+
+    // Only the label until the page around the row arrives
+    const QModelIndex index = model.index(500);
+    QCOMPARE(model.data(index, WindowedModel::NicknameRole).toString(), QString());
+    model.data(model.index(501), WindowedModel::NicknameRole);
+    QCOMPARE(model.fetches, 0);
+
+    QTRY_COMPARE(model.fetches, 1);
+    QCOMPARE(model.fetched, WindowedModel::PageSize + 2);
+    QCOMPARE(changed.count(), 1);
+    QCOMPARE(model.data(index, WindowedModel::NicknameRole).toString(),
+            model.contact(500).detail<QContactNickname>().nickname());
+
+    // Rows of the page are cached already
+    model.data(model.index(500 + WindowedModel::PageSize / 2),
+            WindowedModel::NicknameRole);
+    QCoreApplication::processEvents();
+    QCOMPARE(model.fetches, 2); // contact() above fetched as well
+
+    // Changes of cached rows update their values
+    QContact contact = model.contact(500);
+    QContactNickname nickname = contact.detail<QContactNickname>();
+    nickname.setNickname(QStringLiteral("changed"));
+    contact.saveDetail(&nickname);
+    model.updateContacts(QList<QContact>() << contact);
+    QCOMPARE(model.data(model.index(model.rowOf(contact.id())),
+                WindowedModel::NicknameRole).toString(), QStringLiteral("changed"));
+}
+
+void TestSortedContactModel::windowedCacheBound()
+{
+    const int count = 3 * WindowedModel::CacheSize;
+    WindowedModel model(withNicknames(makeContacts(count)));
+
+    // Scrolling through the whole list
+    for(int row = 0; row < count; row += 10) {
+        model.data(model.index(row), WindowedModel::NicknameRole);
+        QCoreApplication::processEvents();
+        QVERIFY(model.cachedRows() <= WindowedModel::CacheSize);
+    }
+    QVERIFY(model.fetched < 2 * count);
+}
+
+void TestSortedContactModel::windowedUpdates()
+{
+    const QList<QContact> contacts = withNicknames(makeContacts(1000));
+    WindowedModel model(contacts);
+
+    model.data(model.index(500), WindowedModel::NicknameRole);
+    QTRY_COMPARE(model.fetches, 1);
+    const int fetched = model.fetched;
+
+    // Cached or not, every changed contact moves to its new row, but only
+    // the cached ones are fetched whole
+    QList<QContact> changed;
+    for(int i = 0; i < contacts.size(); i += 10) {
+        QContact contact = contacts.at(i);
+        QContactDisplayLabel label = contact.detail<QContactDisplayLabel>();
+        label.setLabel(QStringLiteral("Changed ") + label.label());
+        contact.saveDetail(&label);
+        changed << contact;
+    }
+    model.change(changed);
+
+    QVERIFY(model.fetched - fetched <= model.cachedRows());
+    QVERIFY(model.labelsFetched >= changed.size() - model.cachedRows());
+    QCOMPARE(model.fetched - fetched + model.labelsFetched, changed.size());
+    verifyOrder(model);
+    verifySections(model);
+
+    foreach(const QContact &contact, changed) {
+        const int row = model.rowOf(contact.id());
+        QVERIFY(row >= 0);
+        QCOMPARE(model.contact(row).detail<QContactDisplayLabel>().label(),
+                contact.detail<QContactDisplayLabel>().label());
+    }
+}
+
+void TestSortedContactModel::benchmark_data()
+{
+    QTest::addColumn<bool>("proxy");
+    QTest::addColumn<QString>("operation");
+
+    const QStringList operations = QStringList() << QStringLiteral("insert")
+        << QStringLiteral("rename") << QStringLiteral("presence");
+    foreach(const QString &operation, operations) {
+        QTest::newRow(qPrintable(operation + QLatin1String(" sorted")))
+            << false << operation;
+        QTest::newRow(qPrintable(operation + QLatin1String(" proxy")))
+            << true << operation;
+    }
+}
+
+void TestSortedContactModel::benchmark()
+{
+    QFETCH(bool, proxy);
+    QFETCH(QString, operation);
+
+    const int count = 10000;
+    const QList<QContact> contacts = makeContacts(count);
+    const QContact added = makeContact(count, QStringLiteral("Mallory"));
+    const QContact renamed[] = {
+        makeContact(count / 2, QStringLiteral("Aardvark")),
+        makeContact(count / 2, QStringLiteral("Zebra"))
+    };
+    QContact presence = contacts.at(count / 2);
+    QContactGlobalPresence globalPresence;
+    globalPresence.setPresenceState(QContactPresence::PresenceAway);
+    presence.saveDetail(&globalPresence);
+
+    int i = 0;
+    if(proxy) {
+        UnsortedModel source;
+        source.append(contacts);
+        QSortFilterProxyModel model;
+        model.setDynamicSortFilter(true);
+        model.setSortCaseSensitivity(Qt::CaseInsensitive);
+        model.setSortLocaleAware(true);
+        model.setSourceModel(&source);
+        model.sort(0);
+
+        if(operation == QLatin1String("insert")) {
+            QBENCHMARK {
+                source.append(QList<QContact>() << added);
+                source.removeLast();
+            }
+        } else if(operation == QLatin1String("rename")) {
+            QBENCHMARK {
+                source.change(count / 2, renamed[i++ % 2]);
+            }
+        } else {
+            QBENCHMARK {
+                source.change(count / 2, presence);
+            }
+        }
+    } else {
+        SortedContactModel model;
+        model.insertContacts(contacts);
+
+        if(operation == QLatin1String("insert")) {
+            QBENCHMARK {
+                model.insertContacts(QList<QContact>() << added);
+                model.removeContacts(QList<QContactId>() << added.id());
+            }
+        } else if(operation == QLatin1String("rename")) {
+            QBENCHMARK {
+                model.updateContacts(QList<QContact>() << renamed[i++ % 2]);
+            }
+        } else {
+            QBENCHMARK {
+                model.updateContacts(QList<QContact>() << presence);
+            }
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestSortedContactModel)
+
+#include "tst_sortedcontactmodel.moc"